@@ -0,0 +1,857 @@
+/* Synthetic load test server for benchmarking the ClassiCube client offline
+ *
+ * Speaks the classic protocol (and CPE, if the client supports it) over TCP, and generates
+ *  a reproducible amount of load - a map of a given size, moving entities, block updates,
+ *  chat messages and custom model definitions. Only one client is served at a time.
+ *
+ * Compiling:  cc -O2 -o loadtest loadtest.c -lm
+ * Running:    ./loadtest --width 512 --height 64 --length 512 --entities 200 --blocks 2000
+ * Then connect the client to it, e.g.  ./ClassiCube Tester pass 127.0.0.1 25566
+ *
+ * NOTE: Requires a POSIX system (BSD sockets)
+ */
+/* Otherwise clock_gettime is hidden when compiling with strict -std=c99 */
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <math.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#define TICKS_PER_SEC  20
+#define MAX_ENTITIES   254
+#define MAX_MODELS     64
+#define MAX_PARTS      64
+/* Entity positions are sent as signed 16 bit values in 1/32 block units */
+#define MAX_COORD      1000
+
+struct Config {
+	int port;
+	int width, height, length;
+	int entities;
+	int blocksPerSec;
+	int chatPerSec;
+	int models, parts;
+	unsigned int seed;
+};
+
+static struct Config config = {
+	25566,
+	256, 64, 256,
+	50,
+	200,
+	2,
+	0, 8,
+	12345
+};
+
+
+/*########################################################################################################################*
+*----------------------------------------------------------Utils----------------------------------------------------------*
+*#########################################################################################################################*/
+static unsigned int rng_state;
+
+static unsigned int Random_Next(unsigned int n) {
+	/* xorshift32, so that the same seed always produces the same load */
+	rng_state ^= rng_state << 13;
+	rng_state ^= rng_state >> 17;
+	rng_state ^= rng_state << 5;
+	return rng_state % n;
+}
+
+static double Time_Now(void) {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static void Time_Sleep(double secs) {
+	struct timespec t;
+	if (secs <= 0) return;
+	t.tv_sec  = (time_t)secs;
+	t.tv_nsec = (long)((secs - t.tv_sec) * 1e9);
+	nanosleep(&t, NULL);
+}
+
+static unsigned int crc_table[256];
+static void Crc32_Init(void) {
+	unsigned int i, j, c;
+	for (i = 0; i < 256; i++)
+	{
+		c = i;
+		for (j = 0; j < 8; j++) { c = (c & 1) ? 0xEDB88320U ^ (c >> 1) : c >> 1; }
+		crc_table[i] = c;
+	}
+}
+
+static unsigned int Crc32_Calc(const unsigned char* data, size_t len) {
+	unsigned int crc = 0xFFFFFFFFU;
+	size_t i;
+	for (i = 0; i < len; i++) { crc = crc_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8); }
+	return crc ^ 0xFFFFFFFFU;
+}
+
+
+/*########################################################################################################################*
+*---------------------------------------------------------Deflate---------------------------------------------------------*
+*#########################################################################################################################*/
+/* Minimal compressor which only uses the fixed huffman codes, and only finds runs of */
+/*  the same byte (i.e. matches with a distance of 1). Good enough for generated maps. */
+struct Deflater {
+	unsigned char* buffer;
+	size_t len, cap;
+	unsigned int bits;
+	int numBits;
+};
+
+static const int len_base[29] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+	35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const int len_bits[29] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+	3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+
+static void Deflater_PutByte(struct Deflater* d, unsigned char value) {
+	if (d->len == d->cap) {
+		d->cap    = d->cap ? d->cap * 2 : 64 * 1024;
+		d->buffer = (unsigned char*)realloc(d->buffer, d->cap);
+		if (!d->buffer) { fprintf(stderr, "Out of memory\n"); exit(1); }
+	}
+	d->buffer[d->len++] = value;
+}
+
+/* Writes a value, least significant bit first */
+static void Deflater_Bits(struct Deflater* d, unsigned int value, int count) {
+	d->bits    |= value << d->numBits;
+	d->numBits += count;
+
+	while (d->numBits >= 8) {
+		Deflater_PutByte(d, (unsigned char)d->bits);
+		d->bits   >>= 8;
+		d->numBits -= 8;
+	}
+}
+
+/* Writes a huffman code, most significant bit first */
+static void Deflater_Code(struct Deflater* d, unsigned int code, int len) {
+	unsigned int reversed = 0;
+	int i;
+	for (i = 0; i < len; i++) { reversed = (reversed << 1) | ((code >> i) & 1); }
+	Deflater_Bits(d, reversed, len);
+}
+
+static void Deflater_Symbol(struct Deflater* d, int sym) {
+	if (sym < 144) {
+		Deflater_Code(d, 0x30  + sym,         8);
+	} else if (sym < 256) {
+		Deflater_Code(d, 0x190 + (sym - 144), 9);
+	} else if (sym < 280) {
+		Deflater_Code(d, sym - 256,           7);
+	} else {
+		Deflater_Code(d, 0xC0  + (sym - 280), 8);
+	}
+}
+
+/* Writes a match of the given length (3 to 258) with a distance of 1 */
+static void Deflater_Match(struct Deflater* d, int len) {
+	int i = 28;
+	while (len_base[i] > len) i--;
+
+	Deflater_Symbol(d, 257 + i);
+	Deflater_Bits(d, len - len_base[i], len_bits[i]);
+	Deflater_Code(d, 0, 5); /* distance code 0 = distance of 1 */
+}
+
+static void Deflater_Compress(struct Deflater* d, const unsigned char* data, size_t len) {
+	size_t i = 0, run;
+	int count;
+
+	Deflater_Bits(d, 1, 1); /* final block */
+	Deflater_Bits(d, 1, 2); /* fixed huffman codes */
+
+	while (i < len) {
+		Deflater_Symbol(d, data[i]);
+		for (run = 1; i + run < len && data[i + run] == data[i]; run++) { }
+		i += run;
+		run--;
+
+		while (run >= 3) {
+			count = run > 258 ? 258 : (int)run;
+			/* Avoid leaving a remainder too short to be a match */
+			if (run - count > 0 && run - count < 3) count -= 3;
+
+			Deflater_Match(d, count);
+			run -= count;
+		}
+		while (run--) Deflater_Symbol(d, data[i - 1]);
+	}
+
+	Deflater_Symbol(d, 256); /* end of block */
+	if (d->numBits) Deflater_Bits(d, 0, 8 - d->numBits);
+}
+
+/* Compresses the data in GZip format, as classic map data is sent as */
+static void Deflater_GZip(struct Deflater* d, const unsigned char* data, size_t len) {
+	static const unsigned char header[10] = { 0x1F, 0x8B, 0x08, 0, 0, 0, 0, 0, 0, 0xFF };
+	unsigned int crc = Crc32_Calc(data, len);
+	int i;
+
+	for (i = 0; i < 10; i++) Deflater_PutByte(d, header[i]);
+	Deflater_Compress(d, data, len);
+
+	for (i = 0; i < 4; i++) Deflater_PutByte(d, (unsigned char)(crc >> (i * 8)));
+	for (i = 0; i < 4; i++) Deflater_PutByte(d, (unsigned char)(len >> (i * 8)));
+}
+
+
+/*########################################################################################################################*
+*-------------------------------------------------------Connection--------------------------------------------------------*
+*#########################################################################################################################*/
+static int conn_socket = -1;
+static unsigned char out_buffer[256 * 1024];
+static int out_len;
+static unsigned long long out_total;
+
+static int cpe_enabled, cpe_bulkBlocks, cpe_changeModel, cpe_customModels;
+
+static int Conn_Flush(void) {
+	int sent = 0, res;
+
+	while (sent < out_len) {
+		res = (int)send(conn_socket, out_buffer + sent, out_len - sent, 0);
+		if (res < 0 && errno == EINTR) continue;
+		if (res <= 0) return 0;
+		sent += res;
+	}
+	out_total += out_len;
+	out_len    = 0;
+	return 1;
+}
+
+/* Returns a pointer to space for a packet of the given size in the output buffer */
+static unsigned char* Conn_Packet(int size) {
+	unsigned char* data;
+	if (out_len + size > (int)sizeof(out_buffer)) Conn_Flush();
+
+	data = out_buffer + out_len;
+	memset(data, 0, size);
+	out_len += size;
+	return data;
+}
+
+static int Conn_Read(unsigned char* data, int len) {
+	int read = 0, res;
+
+	while (read < len) {
+		res = (int)recv(conn_socket, data + read, len - read, 0);
+		if (res < 0 && errno == EINTR) continue;
+		if (res <= 0) return 0;
+		read += res;
+	}
+	return 1;
+}
+
+static void Put_U16(unsigned char* data, int value) {
+	data[0] = (unsigned char)(value >> 8); data[1] = (unsigned char)value;
+}
+
+static void Put_U32(unsigned char* data, unsigned int value) {
+	data[0] = (unsigned char)(value >> 24); data[1] = (unsigned char)(value >> 16);
+	data[2] = (unsigned char)(value >> 8);  data[3] = (unsigned char)value;
+}
+
+static void Put_Float(unsigned char* data, float value) {
+	union { float f; unsigned int u; } raw;
+	raw.f = value;
+	Put_U32(data, raw.u);
+}
+
+static void Put_String(unsigned char* data, const char* str) {
+	int i, len = (int)strlen(str);
+	for (i = 0; i < 64; i++) { data[i] = i < len ? str[i] : ' '; }
+}
+
+static void Get_String(const unsigned char* data, char* str) {
+	int len = 64;
+	while (len > 0 && data[len - 1] == ' ') len--;
+
+	memcpy(str, data, len);
+	str[len] = '\0';
+}
+
+
+/*########################################################################################################################*
+*--------------------------------------------------------Login/CPE--------------------------------------------------------*
+*#########################################################################################################################*/
+#define OPCODE_HANDSHAKE     0
+#define OPCODE_LEVEL_INIT    2
+#define OPCODE_LEVEL_CHUNK   3
+#define OPCODE_LEVEL_END     4
+#define OPCODE_SET_BLOCK     6
+#define OPCODE_ADD_ENTITY    7
+#define OPCODE_TELEPORT      8
+#define OPCODE_RELPOS_ORI    9
+#define OPCODE_MESSAGE       13
+#define OPCODE_EXT_INFO      16
+#define OPCODE_EXT_ENTRY     17
+#define OPCODE_CHANGE_MODEL  29
+#define OPCODE_BULK_UPDATE   38
+#define OPCODE_DEFINE_MODEL  50
+#define OPCODE_DEFINE_PART   51
+
+struct ServerExt { const char* name; int version; int* supported; };
+static struct ServerExt server_exts[] = {
+	{ "BulkBlockUpdate", 1, &cpe_bulkBlocks   },
+	{ "ChangeModel",     1, &cpe_changeModel  },
+	{ "CustomModels",    2, &cpe_customModels }
+};
+#define NUM_SERVER_EXTS (int)(sizeof(server_exts) / sizeof(server_exts[0]))
+
+/* Size of each packet the client may send, or 0 if not expected */
+static int client_sizes[256];
+
+static void Client_InitSizes(void) {
+	client_sizes[0]  = 131; /* Handshake */
+	client_sizes[5]  = 9;   /* SetBlockClient */
+	client_sizes[8]  = 10;  /* Position update */
+	client_sizes[13] = 66;  /* Message */
+	client_sizes[16] = 67;  /* ExtInfo */
+	client_sizes[17] = 69;  /* ExtEntry */
+	client_sizes[19] = 2;   /* CustomBlockSupportLevel */
+	client_sizes[34] = 15;  /* PlayerClicked */
+	client_sizes[43] = 4;   /* TwoWayPing */
+	client_sizes[53] = 66;  /* PluginMessage */
+	client_sizes[57] = 5;   /* NotifyAction */
+	client_sizes[58] = 9;   /* NotifyPositionAction */
+}
+
+static int Login_ReadExtensions(void) {
+	unsigned char data[69];
+	char name[65];
+	int i, j, count;
+
+	if (!Conn_Read(data, 67) || data[0] != OPCODE_EXT_INFO) return 0;
+	count = (data[65] << 8) | data[66];
+
+	for (i = 0; i < count; i++)
+	{
+		if (!Conn_Read(data, 69) || data[0] != OPCODE_EXT_ENTRY) return 0;
+		Get_String(data + 1, name);
+
+		for (j = 0; j < NUM_SERVER_EXTS; j++)
+		{
+			if (strcmp(name, server_exts[j].name)) continue;
+			/* Only CustomModels version 2 packets are sent */
+			if (data[68] < server_exts[j].version) continue;
+			*server_exts[j].supported = 1;
+		}
+	}
+	return 1;
+}
+
+static int Login_Handshake(void) {
+	unsigned char data[131];
+	unsigned char* packet;
+	char name[65];
+	int i;
+
+	if (!Conn_Read(data, 131) || data[0] != OPCODE_HANDSHAKE) return 0;
+	Get_String(data + 2, name);
+	cpe_enabled = data[130] == 0x42;
+	printf("%s connected (CPE %s)\n", name, cpe_enabled ? "supported" : "not supported");
+
+	cpe_bulkBlocks = cpe_changeModel = cpe_customModels = 0;
+	if (cpe_enabled) {
+		packet = Conn_Packet(67);
+		packet[0] = OPCODE_EXT_INFO;
+		Put_String(packet + 1, "ClassiCube load tester");
+		Put_U16(packet + 65, NUM_SERVER_EXTS);
+
+		for (i = 0; i < NUM_SERVER_EXTS; i++)
+		{
+			packet = Conn_Packet(69);
+			packet[0] = OPCODE_EXT_ENTRY;
+			Put_String(packet + 1, server_exts[i].name);
+			Put_U32(packet + 65, server_exts[i].version);
+		}
+		if (!Conn_Flush() || !Login_ReadExtensions()) return 0;
+	}
+
+	packet = Conn_Packet(131);
+	packet[0] = OPCODE_HANDSHAKE;
+	packet[1] = 7;
+	Put_String(packet + 2,  "Load test server");
+	Put_String(packet + 66, "-hax Synthetic load");
+	packet[130] = 0x64; /* operator */
+	return Conn_Flush();
+}
+
+
+/*########################################################################################################################*
+*----------------------------------------------------------World----------------------------------------------------------*
+*#########################################################################################################################*/
+static unsigned char* map_data; /* 4 byte volume prefix, then blocks */
+static unsigned char* map_blocks;
+static int map_ground;
+
+#define BLOCK_AIR   0
+#define BLOCK_STONE 1
+#define BLOCK_GRASS 2
+#define BLOCK_DIRT  3
+
+static void World_Generate(void) {
+	int y, layer = config.width * config.length;
+	unsigned int volume = (unsigned int)layer * config.height;
+	unsigned char block;
+
+	map_data = (unsigned char*)malloc(volume + 4);
+	if (!map_data) { fprintf(stderr, "Out of memory\n"); exit(1); }
+	map_blocks = map_data + 4;
+	Put_U32(map_data, volume);
+
+	map_ground = config.height / 2;
+	for (y = 0; y < config.height; y++)
+	{
+		block = BLOCK_AIR;
+		if (y < map_ground - 4)  block = BLOCK_STONE;
+		else if (y < map_ground - 1) block = BLOCK_DIRT;
+		else if (y < map_ground) block = BLOCK_GRASS;
+
+		memset(map_blocks + (size_t)y * layer, block, layer);
+	}
+}
+
+static int World_Send(void) {
+	struct Deflater d = { 0 };
+	unsigned char* packet;
+	size_t offset, volume = (size_t)config.width * config.height * config.length;
+	int len;
+	double beg = Time_Now();
+
+	/* Compressed again for every client, since blocks change over time */
+	Deflater_GZip(&d, map_data, volume + 4);
+	printf("Sending map (%zu KB compressed, took %.0f ms)\n", d.len / 1024, (Time_Now() - beg) * 1000);
+
+	packet = Conn_Packet(1);
+	packet[0] = OPCODE_LEVEL_INIT;
+
+	for (offset = 0; offset < d.len; offset += 1024)
+	{
+		len    = d.len - offset > 1024 ? 1024 : (int)(d.len - offset);
+		packet = Conn_Packet(1028);
+
+		packet[0] = OPCODE_LEVEL_CHUNK;
+		Put_U16(packet + 1, len);
+		memcpy(packet + 3, d.buffer + offset, len);
+		packet[1027] = (unsigned char)((offset + len) * 100 / d.len);
+	}
+
+	packet = Conn_Packet(7);
+	packet[0] = OPCODE_LEVEL_END;
+	Put_U16(packet + 1, config.width);
+	Put_U16(packet + 3, config.height);
+	Put_U16(packet + 5, config.length);
+
+	free(d.buffer);
+	return Conn_Flush();
+}
+
+static void World_SetBlock(int x, int y, int z, unsigned char block) {
+	map_blocks[((size_t)y * config.length + z) * config.width + x] = block;
+}
+
+
+/*########################################################################################################################*
+*---------------------------------------------------------Entities--------------------------------------------------------*
+*#########################################################################################################################*/
+struct Bot {
+	float centreX, centreZ, radius, speed, angle;
+	int x, y, z; /* Last sent position, in 1/32 block units */
+};
+static struct Bot bots[MAX_ENTITIES];
+
+static void Entity_Spawn(int id, const char* name, int x, int y, int z) {
+	unsigned char* packet = Conn_Packet(74);
+	packet[0] = OPCODE_ADD_ENTITY;
+	packet[1] = (unsigned char)id;
+	Put_String(packet + 2, name);
+	Put_U16(packet + 66, x);
+	Put_U16(packet + 68, y);
+	Put_U16(packet + 70, z);
+}
+
+/* Number of possible entity centres along an axis, keeping entities 8 blocks away from the map edges */
+static int Spawn_Range(int size) {
+	if (size > MAX_COORD) size = MAX_COORD;
+	return size > 16 ? size - 16 : 1;
+}
+
+static void Bots_Spawn(void) {
+	char name[64];
+	struct Bot* b;
+	int i;
+
+	for (i = 0; i < config.entities; i++)
+	{
+		b = &bots[i];
+		b->centreX = 8 + Random_Next(Spawn_Range(config.width));
+		b->centreZ = 8 + Random_Next(Spawn_Range(config.length));
+		b->radius  = 2 + Random_Next(6);
+		b->speed   = 0.5f + Random_Next(100) / 50.0f;
+		b->angle   = Random_Next(360) * 3.14159265f / 180;
+
+		b->x = (int)(b->centreX * 32);
+		b->y = (map_ground + 2) * 32;
+		b->z = (int)(b->centreZ * 32);
+
+		sprintf(name, "&7Bot%i", i);
+		Entity_Spawn(i, name, b->x, b->y, b->z);
+	}
+}
+
+static void Bots_Tick(void) {
+	unsigned char* packet;
+	struct Bot* b;
+	int i, x, z;
+
+	for (i = 0; i < config.entities; i++)
+	{
+		b = &bots[i];
+		b->angle += b->speed / TICKS_PER_SEC;
+
+		x = (int)((b->centreX + cosf(b->angle) * b->radius) * 32);
+		z = (int)((b->centreZ + sinf(b->angle) * b->radius) * 32);
+
+		packet = Conn_Packet(7);
+		packet[0] = OPCODE_RELPOS_ORI;
+		packet[1] = (unsigned char)i;
+		packet[2] = (unsigned char)(x - b->x);
+		packet[3] = 0;
+		packet[4] = (unsigned char)(z - b->z);
+		packet[5] = (unsigned char)((int)(b->angle * 256 / 6.2831853f + 64) & 0xFF);
+		packet[6] = 0;
+
+		b->x = x; b->z = z;
+	}
+}
+
+static void Models_Define(void) {
+	unsigned char* packet;
+	char name[64];
+	int i, j, k;
+	float x, z;
+
+	for (i = 0; i < config.models; i++)
+	{
+		sprintf(name, "loadtest%i", i);
+		packet = Conn_Packet(116);
+		packet[0] = OPCODE_DEFINE_MODEL;
+		packet[1] = (unsigned char)i;
+		Put_String(packet + 2, name);
+		packet[66] = 0x01 | 0x02; /* bobbing, pushes */
+
+		Put_Float(packet +  67, 2.0f);  /* name Y */
+		Put_Float(packet +  71, 1.6f);  /* eye Y */
+		Put_Float(packet +  75, 0.6f);  /* collision bounds */
+		Put_Float(packet +  79, 1.8f);
+		Put_Float(packet +  83, 0.6f);
+		Put_Float(packet +  87, -0.5f); /* picking bounds */
+		Put_Float(packet +  91, 0.0f);
+		Put_Float(packet +  95, -0.5f);
+		Put_Float(packet +  99, 0.5f);
+		Put_Float(packet + 103, 2.0f);
+		Put_Float(packet + 107, 0.5f);
+		Put_U16(packet + 111, 64);
+		Put_U16(packet + 113, 64);
+		packet[115] = (unsigned char)config.parts;
+
+		/* Small cubes arranged in a grid, each slowly spinning */
+		for (j = 0; j < config.parts; j++)
+		{
+			x = (j % 8) * 2.0f - 8.0f;
+			z = (j / 8) * 2.0f - 8.0f;
+
+			packet = Conn_Packet(167);
+			packet[0] = OPCODE_DEFINE_PART;
+			packet[1] = (unsigned char)i;
+			Put_Float(packet +  2, x);        Put_Float(packet +  6, 0.0f);  Put_Float(packet + 10, z);
+			Put_Float(packet + 14, x + 2.0f); Put_Float(packet + 18, 16.0f); Put_Float(packet + 22, z + 2.0f);
+
+			for (k = 0; k < 6; k++)
+			{
+				Put_U16(packet + 26 + k * 8 + 4, 8);
+				Put_U16(packet + 26 + k * 8 + 6, 8);
+			}
+			Put_Float(packet + 74, x + 1.0f); Put_Float(packet + 78, 0.0f); Put_Float(packet + 82, z + 1.0f);
+
+			packet[98] = 8 | (1 << 6); /* spin animation around Y axis */
+			Put_Float(packet + 99, 1.0f);
+		}
+	}
+}
+
+static void Models_Apply(void) {
+	unsigned char* packet;
+	char name[64];
+	int i;
+
+	for (i = 0; i < config.entities; i++)
+	{
+		sprintf(name, "loadtest%i", i % config.models);
+		packet = Conn_Packet(66);
+		packet[0] = OPCODE_CHANGE_MODEL;
+		packet[1] = (unsigned char)i;
+		Put_String(packet + 2, name);
+	}
+}
+
+
+/*########################################################################################################################*
+*-------------------------------------------------------Block/chat--------------------------------------------------------*
+*#########################################################################################################################*/
+static int bulk_count;
+static unsigned char* bulk_packet;
+
+static void Blocks_Update(int x, int y, int z, unsigned char block) {
+	unsigned char* packet;
+	World_SetBlock(x, y, z, block);
+
+	if (!cpe_bulkBlocks) {
+		packet = Conn_Packet(8);
+		packet[0] = OPCODE_SET_BLOCK;
+		Put_U16(packet + 1, x);
+		Put_U16(packet + 3, y);
+		Put_U16(packet + 5, z);
+		packet[7] = block;
+		return;
+	}
+
+	if (!bulk_packet) {
+		bulk_packet    = Conn_Packet(1282);
+		bulk_packet[0] = OPCODE_BULK_UPDATE;
+		bulk_count     = 0;
+	}
+
+	Put_U32(bulk_packet + 2 + bulk_count * 4, (unsigned int)(((size_t)y * config.length + z) * config.width + x));
+	bulk_packet[2 + 256 * 4 + bulk_count] = block;
+	bulk_packet[1] = (unsigned char)bulk_count;
+
+	if (++bulk_count == 256) bulk_packet = NULL;
+}
+
+static void Blocks_Tick(int count) {
+	int i, x, y, z;
+	bulk_packet = NULL;
+
+	for (i = 0; i < count; i++)
+	{
+		/* Toggle random blocks in the few layers just above the ground */
+		x = Random_Next(config.width);
+		y = map_ground + Random_Next(4);
+		z = Random_Next(config.length);
+		Blocks_Update(x, y, z, (unsigned char)(Random_Next(2) ? BLOCK_AIR : 1 + Random_Next(49)));
+	}
+	/* Partially filled bulk packet would be moved if the buffer was flushed */
+	bulk_packet = NULL;
+}
+
+static void Chat_Tick(int count) {
+	static unsigned int messages;
+	unsigned char* packet;
+	char msg[65];
+	int i;
+
+	for (i = 0; i < count; i++)
+	{
+		sprintf(msg, "&7[Spam] &fLoad test message &e#%u&f, lorem ipsum dolor", ++messages);
+		packet = Conn_Packet(66);
+		packet[0] = OPCODE_MESSAGE;
+		packet[1] = 0;
+		Put_String(packet + 2, msg);
+	}
+}
+
+
+/*########################################################################################################################*
+*--------------------------------------------------------Main loop--------------------------------------------------------*
+*#########################################################################################################################*/
+static unsigned char in_buffer[64 * 1024];
+static int in_len;
+
+/* Reads and discards everything the client has sent. Returns 0 if the client disconnected */
+static int Client_Drain(void) {
+	int res, size, offset;
+
+	for (;;) {
+		res = (int)recv(conn_socket, in_buffer + in_len, sizeof(in_buffer) - in_len, MSG_DONTWAIT);
+		if (res < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) break;
+		if (res <= 0) return 0;
+		in_len += res;
+
+		for (offset = 0; offset < in_len; offset += size)
+		{
+			size = client_sizes[in_buffer[offset]];
+			if (!size) { printf("Unexpected opcode %i from client\n", in_buffer[offset]); return 0; }
+			if (offset + size > in_len) break;
+		}
+
+		in_len -= offset;
+		memmove(in_buffer, in_buffer + offset, in_len);
+	}
+	return 1;
+}
+
+static void Client_Serve(void) {
+	double blockAcc = 0, chatAcc = 0, next, statsTime;
+	unsigned long long lastTotal = 0;
+	unsigned char* packet;
+	int blocks, chats, x, y, z;
+
+	out_len = 0; in_len = 0; out_total = 0;
+	if (!Login_Handshake() || !World_Send()) return;
+
+	/* Spawn the client in the middle of the area with entities */
+	x = Spawn_Range(config.width)  * 16;
+	y = (map_ground + 2) * 32;
+	z = Spawn_Range(config.length) * 16;
+
+	Entity_Spawn(255, "", x, y, z);
+	packet = Conn_Packet(10);
+	packet[0] = OPCODE_TELEPORT;
+	packet[1] = 255;
+	Put_U16(packet + 2, x);
+	Put_U16(packet + 4, y);
+	Put_U16(packet + 6, z);
+
+	if (config.models && cpe_customModels) Models_Define();
+	Bots_Spawn();
+	if (config.models && cpe_customModels && cpe_changeModel) Models_Apply();
+	if (!Conn_Flush()) return;
+
+	next = statsTime = Time_Now();
+	for (;;)
+	{
+		if (!Client_Drain()) break;
+
+		Bots_Tick();
+		blockAcc += (double)config.blocksPerSec / TICKS_PER_SEC;
+		chatAcc  += (double)config.chatPerSec   / TICKS_PER_SEC;
+		blocks    = (int)blockAcc; blockAcc -= blocks;
+		chats     = (int)chatAcc;  chatAcc  -= chats;
+
+		Blocks_Tick(blocks);
+		Chat_Tick(chats);
+		if (!Conn_Flush()) break;
+
+		if (Time_Now() - statsTime >= 1.0) {
+			printf("Sent %llu KB/s\n", (out_total - lastTotal) / 1024);
+			lastTotal  = out_total;
+			statsTime += 1.0;
+		}
+
+		next += 1.0 / TICKS_PER_SEC;
+		Time_Sleep(next - Time_Now());
+	}
+	printf("Client disconnected (sent %llu KB in total)\n", out_total / 1024);
+}
+
+static void PrintUsage(void) {
+	printf("Usage: loadtest [options]\n");
+	printf("  --port [port]          Port to listen on (default %i)\n", config.port);
+	printf("  --width/--height/--length [size]  Map dimensions (default %ix%ix%i)\n",
+		config.width, config.height, config.length);
+	printf("  --entities [count]     Number of moving entities, up to %i (default %i)\n", MAX_ENTITIES, config.entities);
+	printf("  --blocks [count]       Block updates per second (default %i)\n", config.blocksPerSec);
+	printf("  --chat [count]         Chat messages per second (default %i)\n", config.chatPerSec);
+	printf("  --models [count]       Custom models to define, up to %i (default %i)\n", MAX_MODELS, config.models);
+	printf("  --parts [count]        Parts per custom model, up to %i (default %i)\n", MAX_PARTS, config.parts);
+	printf("  --seed [value]         Random seed (default %u)\n", config.seed);
+}
+
+static int ParseArgs(int argc, char** argv) {
+	int i, value;
+
+	for (i = 1; i < argc; i++)
+	{
+		if (i + 1 >= argc) { PrintUsage(); return 0; }
+		value = atoi(argv[i + 1]);
+
+		if (!strcmp(argv[i], "--port"))          config.port = value;
+		else if (!strcmp(argv[i], "--width"))    config.width = value;
+		else if (!strcmp(argv[i], "--height"))   config.height = value;
+		else if (!strcmp(argv[i], "--length"))   config.length = value;
+		else if (!strcmp(argv[i], "--entities")) config.entities = value;
+		else if (!strcmp(argv[i], "--blocks"))   config.blocksPerSec = value;
+		else if (!strcmp(argv[i], "--chat"))     config.chatPerSec = value;
+		else if (!strcmp(argv[i], "--models"))   config.models = value;
+		else if (!strcmp(argv[i], "--parts"))    config.parts = value;
+		else if (!strcmp(argv[i], "--seed"))     config.seed = (unsigned int)value;
+		else { PrintUsage(); return 0; }
+		i++;
+	}
+
+	if (config.width < 16 || config.height < 16 || config.length < 16 ||
+		config.width > 32767 || config.height > 32767 || config.length > 32767) {
+		printf("Map dimensions must be between 16 and 32767\n"); return 0;
+	}
+	if (config.entities < 0 || config.entities > MAX_ENTITIES) {
+		printf("Number of entities must be between 0 and %i\n", MAX_ENTITIES); return 0;
+	}
+	if (config.models < 0 || config.models > MAX_MODELS || config.parts < 1 || config.parts > MAX_PARTS) {
+		printf("Models must be between 0 and %i, with 1 to %i parts\n", MAX_MODELS, MAX_PARTS); return 0;
+	}
+	if (config.blocksPerSec < 0 || config.chatPerSec < 0) {
+		printf("Rates cannot be negative\n"); return 0;
+	}
+	return 1;
+}
+
+int main(int argc, char** argv) {
+	struct sockaddr_in addr;
+	int listener, one = 1;
+
+	if (!ParseArgs(argc, argv)) return 1;
+	/* Show statistics immediately, even when output is redirected */
+	setvbuf(stdout, NULL, _IOLBF, 0);
+	signal(SIGPIPE, SIG_IGN);
+	Crc32_Init();
+	Client_InitSizes();
+
+	listener = socket(AF_INET, SOCK_STREAM, 0);
+	setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family      = AF_INET;
+	addr.sin_port        = htons((unsigned short)config.port);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	if (bind(listener, (struct sockaddr*)&addr, sizeof(addr)) || listen(listener, 1)) {
+		perror("Failed to listen"); return 1;
+	}
+	printf("Listening on 127.0.0.1:%i\n", config.port);
+
+	for (;;)
+	{
+		conn_socket = accept(listener, NULL, NULL);
+		if (conn_socket < 0) continue;
+		setsockopt(conn_socket, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+		/* Every client gets exactly the same world and load for the same seed */
+		rng_state = config.seed ? config.seed : 1;
+		World_Generate();
+		Client_Serve();
+
+		free(map_data);
+		close(conn_socket);
+	}
+	return 0;
+}
@@ -0,0 +1,192 @@
+/* Throughput benchmark for the TLS code used by the ClassiCube client
+ *
+ * Large HTTPS downloads (e.g. texture packs) spend nearly all of their CPU time decrypting
+ *  and authenticating 16 KB TLS records, plus a little time on the handshake. This measures
+ *  both using the bundled BearSSL, for the hardware accelerated implementations (if the CPU
+ *  supports them) and for the portable fallback implementations.
+ *
+ * Compiling:  cc -O2 -I../../third_party/bearssl -o tlsbench tlsbench.c ../../third_party/bearssl/[a-z]*.c
+ * Running:    ./tlsbench --mb 64
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bearssl.h"
+
+/* Maximum size of the plaintext in a TLS record */
+#define RECORD_SIZE 16384
+
+static int config_mb = 64;
+static unsigned char record[RECORD_SIZE];
+static unsigned char key[32], iv[16], tag[16];
+
+
+/*########################################################################################################################*
+*----------------------------------------------------------Utils----------------------------------------------------------*
+*#########################################################################################################################*/
+static double Time_Now(void) {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static int NumRecords(void) {
+	return (int)(((long)config_mb * 1024 * 1024) / RECORD_SIZE);
+}
+
+static void PrintThroughput(const char* name, const char* impl, double elapsed) {
+	printf("  %-22s %-24s %8.1f MB/s\n", name, impl, config_mb / elapsed);
+}
+
+static void PrintUnsupported(const char* name, const char* impl) {
+	printf("  %-22s %-24s %13s\n", name, impl, "unsupported");
+}
+
+
+/*########################################################################################################################*
+*-----------------------------------------------------Bulk encryption-----------------------------------------------------*
+*#########################################################################################################################*/
+/* Decrypts records the same way as ssl_rec_gcm.c does */
+static void Bench_AESGCM(const br_block_ctr_class* ctr, br_ghash gh, const char* impl) {
+	br_aes_gen_ctr_keys keys;
+	br_gcm_context gcm;
+	int i, count = NumRecords();
+	double beg;
+
+	if (!ctr || !gh) { PrintUnsupported("AES-128-GCM", impl); return; }
+	ctr->init(&keys.vtable, key, 16);
+	br_gcm_init(&gcm, &keys.vtable, gh);
+	beg = Time_Now();
+
+	for (i = 0; i < count; i++)
+	{
+		br_gcm_reset(&gcm, iv, 12);
+		br_gcm_aad_inject(&gcm, iv, 13);
+		br_gcm_flip(&gcm);
+		br_gcm_run(&gcm, 0, record, RECORD_SIZE);
+		br_gcm_get_tag(&gcm, tag);
+	}
+	PrintThroughput("AES-128-GCM", impl, Time_Now() - beg);
+}
+
+/* Decrypts records the same way as ssl_rec_chapol.c does */
+static void Bench_ChaCha(br_chacha20_run cc, br_poly1305_run poly, const char* impl) {
+	int i, count = NumRecords();
+	double beg;
+
+	if (!cc || !poly) { PrintUnsupported("ChaCha20-Poly1305", impl); return; }
+	beg = Time_Now();
+
+	for (i = 0; i < count; i++)
+	{
+		poly(key, iv, record, RECORD_SIZE, iv, 13, tag, cc, 0);
+	}
+	PrintThroughput("ChaCha20-Poly1305", impl, Time_Now() - beg);
+}
+
+/* Decrypts records the same way as ssl_rec_cbc.c does */
+static void Bench_AESCBC(const br_block_cbcdec_class* dec, const char* impl) {
+	br_aes_gen_cbcdec_keys keys;
+	br_hmac_key_context hkc;
+	br_hmac_context hc;
+	unsigned char cbc_iv[16], mac[32];
+	int i, count = NumRecords();
+	double beg;
+
+	if (!dec) { PrintUnsupported("AES-128-CBC-SHA256", impl); return; }
+	dec->init(&keys.vtable, key, 16);
+	br_hmac_key_init(&hkc, &br_sha256_vtable, key, 32);
+	beg = Time_Now();
+
+	for (i = 0; i < count; i++)
+	{
+		memcpy(cbc_iv, iv, 16);
+		dec->run(&keys.vtable, cbc_iv, record, RECORD_SIZE);
+		br_hmac_init(&hc, &hkc, 0);
+		br_hmac_update(&hc, record, RECORD_SIZE);
+		br_hmac_out(&hc, mac);
+	}
+	PrintThroughput("AES-128-CBC-SHA256", impl, Time_Now() - beg);
+}
+
+
+/*########################################################################################################################*
+*--------------------------------------------------------Handshake--------------------------------------------------------*
+*#########################################################################################################################*/
+#define HANDSHAKE_ITERATIONS 500
+
+/* Measures the ECDHE point multiplication that the client does in every full handshake */
+static void Bench_ECDHE(const br_ec_impl* ec, int curve, const char* name, const char* impl) {
+	unsigned char point[65], scalar[32];
+	const unsigned char* gen;
+	size_t len;
+	int i;
+	double beg, elapsed;
+
+	if (!ec) {
+		printf("  %-22s %-24s %13s\n", name, impl, "unsupported"); return;
+	}
+	gen = ec->generator(curve, &len);
+	memset(scalar, 0x5A, sizeof(scalar));
+	scalar[0] = 0x01;
+	beg = Time_Now();
+
+	for (i = 0; i < HANDSHAKE_ITERATIONS; i++)
+	{
+		memcpy(point, gen, len);
+		ec->mul(point, len, scalar, sizeof(scalar), curve);
+	}
+	elapsed = Time_Now() - beg;
+	printf("  %-22s %-24s %8.0f ops/s\n", name, impl, HANDSHAKE_ITERATIONS / elapsed);
+}
+
+
+/*########################################################################################################################*
+*----------------------------------------------------------Main-----------------------------------------------------------*
+*#########################################################################################################################*/
+static void PrintUsage(void) {
+	printf("Usage: tlsbench [options]\n");
+	printf("  --mb [count]   Megabytes of records to decrypt with each implementation (default %i)\n", config_mb);
+}
+
+int main(int argc, char** argv) {
+	const br_block_ctr_class* ni_ctr = br_aes_x86ni_ctr_get_vtable();
+	const br_block_cbcdec_class* ni_dec = br_aes_x86ni_cbcdec_get_vtable();
+	br_ghash pclmul = br_ghash_pclmul_get();
+	int i;
+
+	for (i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--mb") && i + 1 < argc) {
+			config_mb = atoi(argv[++i]);
+		} else {
+			PrintUsage(); return 1;
+		}
+	}
+	if (config_mb <= 0) { PrintUsage(); return 1; }
+
+	memset(record, 0xAB, sizeof(record));
+	memset(key,    0x11, sizeof(key));
+	memset(iv,     0x22, sizeof(iv));
+
+	printf("CPU support: AES-NI %s, PCLMUL %s, SSE2 %s, 64x64 multiply %s\n",
+		ni_ctr ? "yes" : "no", pclmul ? "yes" : "no",
+		br_chacha20_sse2_get() ? "yes" : "no", br_poly1305_ctmulq_get() ? "yes" : "no");
+	printf("Client prefers: %s\n\n", ni_ctr && pclmul ? "AES-GCM" : "ChaCha20-Poly1305");
+
+	printf("Record decryption (%i MB in %i byte records):\n", config_mb, RECORD_SIZE);
+	Bench_AESGCM(ni_ctr, pclmul, "x86ni + pclmul");
+	Bench_AESGCM(&br_aes_big_ctr_vtable, br_ghash_ctmul64, "big + ctmul64");
+	Bench_ChaCha(br_chacha20_sse2_get(), br_poly1305_ctmulq_get(), "sse2 + ctmulq");
+	Bench_ChaCha(br_chacha20_ct_run, br_poly1305_ctmul_run, "ct + ctmul");
+	Bench_AESCBC(ni_dec, "x86ni + hmac");
+	Bench_AESCBC(&br_aes_big_cbcdec_vtable, "big + hmac");
+
+	printf("\nHandshake key exchange:\n");
+	Bench_ECDHE(br_ec_c25519_m64_get(), BR_EC_curve25519, "X25519",   "m64");
+	Bench_ECDHE(&br_ec_c25519_m31,      BR_EC_curve25519, "X25519",   "m31");
+	Bench_ECDHE(br_ec_p256_m64_get(),   BR_EC_secp256r1,  "P-256",    "m64");
+	Bench_ECDHE(&br_ec_p256_m31,        BR_EC_secp256r1,  "P-256",    "m31");
+	return 0;
+}
@@ -114,6 +114,28 @@ cc_bool Png_Detect(const cc_uint8* data, cc_uint32 len) {
 	return len >= PNG_SIG_SIZE && Mem_Equal(data, pngSig, PNG_SIG_SIZE);
 }
 
+static cc_result Png_DecodedClose(struct Stream* stream) { return 0; }
+void Png_MakeDecodedStream(struct Stream* stream, struct Bitmap* bmp, void* data, cc_uint32 len) {
+	Stream_ReadonlyMemory(stream, data, len);
+	stream->Close = Png_DecodedClose;
+	stream->meta.png.bmp = bmp;
+}
+
+/* Hands over the bitmap of a stream from Png_MakeDecodedStream, as if the data had just been decoded */
+static cc_bool Png_TakeDecoded(struct Bitmap* bmp, struct Stream* stream) {
+	struct Bitmap* src;
+	if (stream->Close != Png_DecodedClose) return false;
+
+	src = stream->meta.png.bmp;
+	if (!src->scan0) return false;
+	*bmp = *src;
+	src->scan0 = NULL;
+
+	stream->meta.png.cur += stream->meta.png.left;
+	stream->meta.png.left = 0;
+	return true;
+}
+
 
 /*########################################################################################################################*
 *------------------------------------------------------PNG decoder--------------------------------------------------------*
@@ -125,6 +147,92 @@ cc_result Png_Decode(struct Bitmap* bmp, struct Stream* stream) {
 #else
 typedef void (*Png_RowExpander)(int width, BitmapCol* palette, cc_uint8* src, BitmapCol* dst);
 
+/* SSE2 is always available on x86_64, so can reconstruct and expand multiple bytes at once */
+#if (defined __SSE2__ || defined _M_X64) && !defined BITMAP_16BPP
+#include <emmintrin.h>
+#define PNG_SIMD_SSE2
+
+static CC_INLINE int Png_ReadI32(const cc_uint8* src) {
+	int value;
+#if defined __GNUC__
+	__builtin_memcpy(&value, src, 4);
+#else
+	value = *(const int*)src;
+#endif
+	return value;
+}
+
+/* Loads the channels of a 3 or 4 byte pixel into the low bytes */
+static CC_INLINE __m128i Png_LoadPixel(cc_uint8 bytesPerPixel, const cc_uint8* src) {
+	if (bytesPerPixel == 4) return _mm_cvtsi32_si128(Png_ReadI32(src));
+	return _mm_cvtsi32_si128(src[0] | (src[1] << 8) | (src[2] << 16));
+}
+
+static CC_INLINE void Png_StorePixel(cc_uint8 bytesPerPixel, cc_uint8* dst, __m128i value) {
+	int v = _mm_cvtsi128_si32(value);
+	dst[0] = (cc_uint8)v; dst[1] = (cc_uint8)(v >> 8); dst[2] = (cc_uint8)(v >> 16);
+	if (bytesPerPixel == 4) dst[3] = (cc_uint8)(v >> 24);
+}
+
+/* Filters with a dependency on the preceding pixel are reconstructed one pixel at a time, */
+/*  but with all of the pixel's channels at once. (only used for 8 bit RGB and RGBA images) */
+static void Png_ReconstructSub(cc_uint8 bytesPerPixel, cc_uint8* line, cc_uint32 lineLen) {
+	__m128i a = _mm_setzero_si128();
+	cc_uint32 i;
+
+	for (i = 0; i < lineLen; i += bytesPerPixel) {
+		a = _mm_add_epi8(Png_LoadPixel(bytesPerPixel, line + i), a);
+		Png_StorePixel(bytesPerPixel, line + i, a);
+	}
+}
+
+static void Png_ReconstructAverage(cc_uint8 bytesPerPixel, cc_uint8* line, cc_uint8* prior, cc_uint32 lineLen) {
+	const __m128i ones = _mm_set1_epi8(1);
+	__m128i a = _mm_setzero_si128(), b, avg;
+	cc_uint32 i;
+
+	for (i = 0; i < lineLen; i += bytesPerPixel) {
+		b = Png_LoadPixel(bytesPerPixel, prior + i);
+		/* _mm_avg_epu8 rounds up, but PNG averages round down */
+		avg = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), ones));
+
+		a = _mm_add_epi8(Png_LoadPixel(bytesPerPixel, line + i), avg);
+		Png_StorePixel(bytesPerPixel, line + i, a);
+	}
+}
+
+#define Png_Abs16(x) _mm_max_epi16(x, _mm_sub_epi16(zero, x))
+#define Png_Select(mask, x, y) _mm_or_si128(_mm_and_si128(mask, x), _mm_andnot_si128(mask, y))
+
+static void Png_ReconstructPaeth(cc_uint8 bytesPerPixel, cc_uint8* line, cc_uint8* prior, cc_uint32 lineLen) {
+	const __m128i zero = _mm_setzero_si128();
+	__m128i a = zero, c = zero, b, x, pa, pb, pc, smallest, nearest;
+	cc_uint32 i;
+
+	/* Channels are widened to 16 bits, so that p = a + b - c can't overflow */
+	for (i = 0; i < lineLen; i += bytesPerPixel) {
+		b = _mm_unpacklo_epi8(Png_LoadPixel(bytesPerPixel, prior + i), zero);
+		x = _mm_unpacklo_epi8(Png_LoadPixel(bytesPerPixel, line  + i), zero);
+
+		/* pa = |p - a| = |b - c|, pb = |p - b| = |a - c|, pc = |p - c| = |(a - c) + (b - c)| */
+		pa = _mm_sub_epi16(b, c);
+		pb = _mm_sub_epi16(a, c);
+		pc = _mm_add_epi16(pa, pb);
+		pa = Png_Abs16(pa); pb = Png_Abs16(pb); pc = Png_Abs16(pc);
+
+		/* Ties are broken in the order a, b, c */
+		smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+		nearest  = Png_Select(_mm_cmpeq_epi16(smallest, pb), b, c);
+		nearest  = Png_Select(_mm_cmpeq_epi16(smallest, pa), a, nearest);
+
+		/* Adding bytes wraps around within the low byte of each 16 bit channel */
+		a = _mm_add_epi8(x, nearest);
+		c = b;
+		Png_StorePixel(bytesPerPixel, line + i, _mm_packus_epi16(a, a));
+	}
+}
+#endif
+
 /* 9 Filtering */
 /* 13.9 Filtering */
 static void Png_ReconstructFirst(cc_uint8 type, cc_uint8 bytesPerPixel, cc_uint8* line, cc_uint32 lineLen) {
@@ -155,6 +263,16 @@ static void Png_ReconstructFirst(cc_uint8 type, cc_uint8 bytesPerPixel, cc_uint8
 static void Png_Reconstruct(cc_uint8 type, cc_uint8 bytesPerPixel, cc_uint8* line, cc_uint8* prior, cc_uint32 lineLen) {
 	cc_uint32 i, j;
 
+#ifdef PNG_SIMD_SSE2
+	if (bytesPerPixel == 3 || bytesPerPixel == 4) {
+		switch (type) {
+		case PNG_FILTER_SUB:     Png_ReconstructSub(bytesPerPixel, line, lineLen);            return;
+		case PNG_FILTER_AVERAGE: Png_ReconstructAverage(bytesPerPixel, line, prior, lineLen); return;
+		case PNG_FILTER_PAETH:   Png_ReconstructPaeth(bytesPerPixel, line, prior, lineLen);   return;
+		}
+	}
+#endif
+
 	switch (type) {
 	case PNG_FILTER_SUB:
 		for (i = bytesPerPixel, j = 0; i < lineLen; i++, j++) {
@@ -163,7 +281,15 @@ static void Png_Reconstruct(cc_uint8 type, cc_uint8 bytesPerPixel, cc_uint8* lin
 		return;
 
 	case PNG_FILTER_UP:
-		for (i = 0; i < lineLen; i++) {
+		i = 0;
+#ifdef PNG_SIMD_SSE2
+		for (; i + 16 <= lineLen; i += 16) {
+			__m128i cur = _mm_loadu_si128((const __m128i*)(line  + i));
+			__m128i up  = _mm_loadu_si128((const __m128i*)(prior + i));
+			_mm_storeu_si128((__m128i*)(line + i), _mm_add_epi8(cur, up));
+		}
+#endif
+		for (; i < lineLen; i++) {
 			line[i] += prior[i];
 		}
 		return;
@@ -207,6 +333,21 @@ static void Png_Reconstruct(cc_uint8 type, cc_uint8 bytesPerPixel, cc_uint8* lin
 #define PNG_Do_RGB_A__8()         Bitmap_Set(*dst, src[0], src[1], src[2], src[3]); dst++; src += 4;
 #define PNG_Do_Palette__8()       *dst-- = palette[*src--];
 
+#ifdef PNG_SIMD_SSE2
+/* Converts 4 pixels of R,G,B,A bytes into BitmapCols */
+static CC_INLINE __m128i Png_MakeBitmapCols(__m128i src) {
+	const __m128i mask = _mm_set1_epi32(0xFF);
+	__m128i r = _mm_and_si128(src, mask);
+	__m128i g = _mm_and_si128(_mm_srli_epi32(src,  8), mask);
+	__m128i b = _mm_and_si128(_mm_srli_epi32(src, 16), mask);
+	__m128i a = _mm_srli_epi32(src, 24);
+
+	return _mm_or_si128(
+		_mm_or_si128(_mm_slli_epi32(r, BITMAPCOLOR_R_SHIFT), _mm_slli_epi32(g, BITMAPCOLOR_G_SHIFT)),
+		_mm_or_si128(_mm_slli_epi32(b, BITMAPCOLOR_B_SHIFT), _mm_slli_epi32(a, BITMAPCOLOR_A_SHIFT)));
+}
+#endif
+
 #define PNG_Mask_1(i) (7  - (i & 7))
 #define PNG_Mask_2(i) ((3 - (i & 3)) * 2)
 #define PNG_Mask_4(i) ((1 - (i & 1)) * 4)
@@ -245,6 +386,16 @@ static void Png_Expand_RGB_8(int width, BitmapCol* palette, cc_uint8* src, Bitma
 	src += (width - 1) * 3;
 	dst += (width - 1);
 
+#ifdef PNG_SIMD_SSE2
+	/* 4 byte reads of each pixel include the next pixel's first byte, which is replaced with alpha */
+	/* NOTE: The last pixel's read is still within the bitmap, as rows were allocated 4 bytes per pixel */
+	for (; width >= 4; width -= 4, src -= 12, dst -= 4) {
+		__m128i rgb = _mm_setr_epi32(Png_ReadI32(src - 9), Png_ReadI32(src - 6),
+									Png_ReadI32(src - 3), Png_ReadI32(src));
+		rgb = _mm_or_si128(rgb, _mm_set1_epi32((int)0xFF000000));
+		_mm_storeu_si128((__m128i*)(dst - 3), Png_MakeBitmapCols(rgb));
+	}
+#endif
 	for (; width >= 4; width -= 4) {
 		PNG_Do_RGB__8(); PNG_Do_RGB__8(); 
 		PNG_Do_RGB__8(); PNG_Do_RGB__8();
@@ -293,6 +444,12 @@ static void Png_Expand_GRAYSCALE_A_8(int width, BitmapCol* palette, cc_uint8* sr
 static void Png_Expand_RGB_A_8(int width, BitmapCol* palette, cc_uint8* src, BitmapCol* dst) {
 	/* Processed in forward order */
 
+#ifdef PNG_SIMD_SSE2
+	for (; width >= 4; width -= 4, src += 16, dst += 4) {
+		__m128i rgba = _mm_loadu_si128((const __m128i*)src);
+		_mm_storeu_si128((__m128i*)dst, Png_MakeBitmapCols(rgba));
+	}
+#endif
 	for (; width >= 4; width -= 4) {
 		PNG_Do_RGB_A__8(); PNG_Do_RGB_A__8();
 		PNG_Do_RGB_A__8(); PNG_Do_RGB_A__8();
@@ -404,6 +561,7 @@ cc_result Png_Decode(struct Bitmap* bmp, struct Stream* stream) {
 
 	bmp->width = 0; bmp->height = 0;
 	bmp->scan0 = NULL;
+	if (Png_TakeDecoded(bmp, stream)) return 0;
 
 	res = Stream_Read(stream, tmp, PNG_SIG_SIZE);
 	if (res) return res;
@@ -698,25 +856,18 @@ static void Png_EncodeRow(const cc_uint8* cur, const cc_uint8* prior, cc_uint8*
 }
 
 static BitmapCol* DefaultGetRow(struct Bitmap* bmp, int y, void* ctx) { return Bitmap_GetRow(bmp, y); }
-static cc_result Png_EncodeCore(struct Bitmap* bmp, struct Stream* stream, cc_uint8* buffer,
+static cc_result Png_EncodeCore(struct Bitmap* bmp, struct Stream* stream, cc_uint8* buffer, struct ZLibState* zlState,
 					Png_RowGetter getRow, cc_bool alpha, void* ctx) {
 	cc_uint8 tmp[32];
 	cc_uint8* prevLine = buffer;
 	cc_uint8*  curLine = buffer + (bmp->width * 4) * 1;
 	cc_uint8* bestLine = buffer + (bmp->width * 4) * 2;
 
-#if CC_BUILD_MAXSTACK <= (64 * 1024)
-	struct ZLibState* zlState = (struct ZLibState*)Mem_TryAlloc(1, sizeof(struct ZLibState));
-#else
-	struct ZLibState _zlState;
-	struct ZLibState* zlState = &_zlState;
-#endif
 	struct Stream chunk, zlStream;
 	cc_uint32 stream_end, stream_beg;
 	int y, lineSize;
 	cc_result res;
 
-	if (!zlState) return ERR_OUT_OF_MEMORY;
 	/* stream may not start at 0 (e.g. when making default.zip) */
 	if ((res = stream->Position(stream, &stream_beg))) return res;
 
@@ -779,12 +930,20 @@ static cc_result Png_EncodeCore(struct Bitmap* bmp, struct Stream* stream, cc_ui
 
 cc_result Png_Encode(struct Bitmap* bmp, struct Stream* stream, 
 					Png_RowGetter getRow, cc_bool alpha, void* ctx) {
+	struct ZLibState* zlState;
+	cc_uint8* buffer;
 	cc_result res;
+
 	/* Add 1 for scanline filter type byter */
-	cc_uint8* buffer = (cc_uint8*)Mem_TryAlloc(3, bmp->width * 4 + 1);
+	buffer = (cc_uint8*)Mem_TryAlloc(3, bmp->width * 4 + 1);
 	if (!buffer) return ERR_NOT_SUPPORTED;
 
-	res = Png_EncodeCore(bmp, stream, buffer, getRow, alpha, ctx);
+	/* ZLib compression state is too large to put on the stack */
+	zlState = (struct ZLibState*)Mem_TryAlloc(1, sizeof(struct ZLibState));
+	if (!zlState) { Mem_Free(buffer); return ERR_OUT_OF_MEMORY; }
+
+	res = Png_EncodeCore(bmp, stream, buffer, zlState, getRow, alpha, ctx);
+	Mem_Free(zlState);
 	Mem_Free(buffer);
 	return res;
 }
@@ -130,6 +130,10 @@ CC_API void Bitmap_Scale(struct Bitmap* dst, struct Bitmap* src,
 
 /* Whether data starts with PNG format signature/identifier. */
 cc_bool Png_Detect(const cc_uint8* data, cc_uint32 len);
+/* Initialises a readonly stream over the data of a .png file, which has already been decoded into the given bitmap. */
+/* Png_Decode on this stream then takes ownership of that bitmap, instead of decoding the data all over again. */
+/* NOTE: If Png_Decode is never called on the stream, the caller must still free bmp->scan0 afterwards */
+void Png_MakeDecodedStream(struct Stream* stream, struct Bitmap* bmp, void* data, cc_uint32 len);
 typedef BitmapCol* (*Png_RowGetter)(struct Bitmap* bmp, int row, void* ctx);
 /*
   Decodes a bitmap in PNG format. Partially based off information from
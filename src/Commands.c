@@ -18,6 +18,8 @@
 #include "Options.h"
 #include "Drawer2D.h"
 #include "Audio.h"
+#include "Protocol.h"
+#include "Platform.h"
 
 #define COMMANDS_PREFIX "/client"
 #define COMMANDS_PREFIX_SPACE "/client "
@@ -305,6 +307,81 @@ static struct ChatCommand MotdCommand = {
 	}
 };
 
+#define NETSTATS_MAX_SHOWN 8
+static void NetStatsCommand_Show(void) {
+	cc_uint8 opcodes[256];
+	struct ProtocolStats* s;
+	const char* name;
+	int i, j, count = 0;
+	int packets, kb, handlerMS, avgUS;
+	cc_uint8 opcode;
+
+	/* Sort received opcodes by time spent handling them, using insertion sort */
+	for (i = 0; i < 256; i++)
+	{
+		if (!Protocol_Stats[i].Packets) continue;
+		s = &Protocol_Stats[i];
+
+		for (j = count; j > 0 && Protocol_Stats[opcodes[j - 1]].HandlerTicks < s->HandlerTicks; j--)
+		{
+			opcodes[j] = opcodes[j - 1];
+		}
+		opcodes[j] = (cc_uint8)i;
+		count++;
+	}
+
+	if (!count) {
+		Chat_AddRaw("&e/client netstats: &fNo packets have been received yet."); return;
+	}
+	Chat_AddRaw("&eOpcodes with the most time spent handling them:");
+
+	for (i = 0; i < count && i < NETSTATS_MAX_SHOWN; i++)
+	{
+		opcode = opcodes[i];
+		s      = &Protocol_Stats[opcode];
+		name   = Protocol_GetOpcodeName(opcode);
+
+		packets   = (int)s->Packets;
+		kb        = (int)(s->Bytes / 1024);
+		handlerMS = (int)(Stopwatch_ElapsedMicroseconds(0, s->HandlerTicks) / 1000);
+		avgUS     = (int)(Stopwatch_ElapsedMicroseconds(0, s->HandlerTicks) / s->Packets);
+
+		Chat_Add4("  &b%c &e(%b)&f: %i packets, %i KB,", name ? name : "Unknown", &opcode, &packets, &kb);
+		Chat_Add2("    &f%i ms handling (%i us each)", &handlerMS, &avgUS);
+	}
+}
+
+static void NetStatsCommand_Execute(const cc_string* args, int argsCount) {
+	static const cc_string path = String_FromConst("netstats.csv");
+	if (Server.IsSinglePlayer) {
+		Chat_AddRaw("&eThis command can only be used in multiplayer.");
+		return;
+	}
+
+	if (!argsCount) {
+		NetStatsCommand_Show();
+	} else if (String_CaselessEqualsConst(args, "reset")) {
+		Protocol_ResetStats();
+		Chat_AddRaw("&e/client netstats: &fStatistics reset.");
+	} else if (String_CaselessEqualsConst(args, "csv")) {
+		if (Protocol_SaveStats(&path)) return;
+		Chat_Add1("&e/client netstats: &fSaved statistics to %s", &path);
+	} else {
+		Chat_Add1("&e/client netstats: &cUnrecognised argument &f\"%s\"&c.", args);
+	}
+}
+
+static struct ChatCommand NetStatsCommand = {
+	"NetStats", NetStatsCommand_Execute,
+	COMMAND_FLAG_UNSPLIT_ARGS,
+	{
+		"&a/client netstats [reset/csv]",
+		"&eDisplays the packets that took the longest time to handle.",
+		"&breset: &eResets the per packet statistics.",
+		"&bcsv: &eSaves the statistics for every packet to netstats.csv",
+	}
+};
+
 /*#######################################################################################################################*
 *-------------------------------------------------------PlaceCommand-----------------------------------------------------*
 *########################################################################################################################*/
@@ -806,6 +883,7 @@ static void OnInit(void) {
 	Commands_Register(&TeleportCommand);
 	Commands_Register(&ClearDeniedCommand);
 	Commands_Register(&MotdCommand);
+	Commands_Register(&NetStatsCommand);
 	Commands_Register(&PlaceCommand);
 	Commands_Register(&BlockEditCommand);
 	Commands_Register(&CuboidCommand);
@@ -287,6 +287,7 @@ static int Huffman_Decode(struct InflateState* state, struct HuffmanTable* table
 	return -1;
 }
 
+#ifndef INFLATE_WIDE_DECODE
 /* Inline the common <= 9 bits case */
 #define Huffman_UNSAFE_Decode(state, table, result) \
 {\
@@ -326,6 +327,7 @@ static int Huffman_UNSAFE_Decode_Slow(struct InflateState* state, struct Huffman
 	state->AvailIn = 0;
 	return 0;
 }
+#endif
 
 void Inflate_Init2(struct InflateState* state, struct Stream* source) {
 	state->State = INFLATE_STATE_HEADER;
@@ -380,6 +382,9 @@ static const cc_uint8 codelens_order[INFLATE_MAX_CODELENS] = {
 	16,17,18,0,8,7,9,6,10,5,11,4,12,3,13,2,14,1,15 
 };
 
+#ifndef INFLATE_WIDE_DECODE
+#define Inflate_BuildMultiTable(s)
+
 static void Inflate_InflateFast(struct InflateState* s) {
 	/* huffman variables */
 	cc_uint32 lit, len, dist;
@@ -455,6 +460,218 @@ static void Inflate_InflateFast(struct InflateState* s) {
 		s->Output += (copyLen - partLen);
 	}
 }
+#else
+#if defined __GNUC__
+	#define Inflate_Copy8(dst, src) __builtin_memcpy(dst, src, 8)
+#else
+	#define Inflate_Copy8(dst, src) *(cc_uint64*)(dst) = *(const cc_uint64*)(src)
+#endif
+#if defined __SSE2__ || defined _M_X64
+	#include <emmintrin.h>
+	#define Inflate_Copy16(dst, src) _mm_storeu_si128((__m128i*)(dst), _mm_loadu_si128((const __m128i*)(src)))
+#else
+	#define Inflate_Copy16(dst, src) Inflate_Copy8(dst, src); Inflate_Copy8((dst) + 8, (src) + 8)
+#endif
+
+#define Inflate_BuildMultiTable(s) Huffman_BuildMulti(&s->Table.Lits, s->LitsMulti)
+
+/* Multi-symbol table entry layout: */
+/*  bits 0-8 first value, bits 9-16 second literal, bits 17-20 total bits, bits 21-22 number of values */
+#define MULTI_VALUE1(entry) ((entry) & 0x1FF)
+#define MULTI_VALUE2(entry) (((entry) >> 9) & 0xFF)
+#define MULTI_LEN(entry)    (((entry) >> 17) & 0xF)
+#define MULTI_COUNT(entry)  ((entry) >> 21)
+
+/* Builds a table for decoding up to two literals from INFLATE_MULTI_BITS bits at once */
+/* NOTE: Only codewords that are in the fast lookup table are handled */
+static void Huffman_BuildMulti(struct HuffmanTable* table, cc_uint32* multi) {
+	cc_uint32 i, len1, len2, value1, value2;
+	int packed;
+
+	for (i = 0; i < (1 << INFLATE_MULTI_BITS); i++) {
+		packed = table->fast[i & ((1 << INFLATE_FAST_BITS) - 1)];
+		if (packed < 0) { multi[i] = 0; continue; }
+
+		len1   = packed >> INFLATE_FAST_LEN_SHIFT;
+		value1 = packed &  INFLATE_FAST_VAL_MASK;
+		multi[i] = value1 | (len1 << 17) | (1 << 21);
+		if (value1 >= 256) continue;
+
+		/* Try to fit another literal in the remaining bits */
+		packed = table->fast[(i >> len1) & ((1 << INFLATE_FAST_BITS) - 1)];
+		if (packed < 0) continue;
+
+		len2   = packed >> INFLATE_FAST_LEN_SHIFT;
+		value2 = packed &  INFLATE_FAST_VAL_MASK;
+		if (value2 >= 256 || len1 + len2 > INFLATE_MULTI_BITS) continue;
+		multi[i] = value1 | (value2 << 9) | ((len1 + len2) << 17) | (2 << 21);
+	}
+}
+
+/* Slow, bit by bit lookup for codewords longer than INFLATE_FAST_BITS */
+static int Huffman_DecodeWideSlow(struct HuffmanTable* table, cc_uint64 bits, cc_uint32* len) {
+	cc_uint32 i, codeword;
+
+	codeword = Huffman_ReverseBits((cc_uint32)bits & ((1 << INFLATE_FAST_BITS) - 1), INFLATE_FAST_BITS);
+	for (i = INFLATE_FAST_BITS + 1; i < INFLATE_MAX_BITS; i++) {
+		codeword = (codeword << 1) | ((cc_uint32)(bits >> (i - 1)) & 1);
+
+		if (codeword < table->endCodewords[i]) {
+			*len = i;
+			return table->values[table->firstOffsets[i] + (codeword - table->firstCodewords[i])];
+		}
+	}
+	return -1;
+}
+
+#define Inflate_WideConsume(count) bits >>= (count); numBits -= (count);
+#define Inflate_WideDecode(table, result) \
+	packed = table.fast[bits & ((1 << INFLATE_FAST_BITS) - 1)];\
+	if (packed >= 0) {\
+		Inflate_WideConsume(packed >> INFLATE_FAST_LEN_SHIFT);\
+		result = packed & INFLATE_FAST_VAL_MASK;\
+	} else {\
+		result = Huffman_DecodeWideSlow(&table, bits, &consumedBits);\
+		if (result == -1) { Inflate_Fail(s, INF_ERR_INVALID_CODE); break; }\
+		Inflate_WideConsume(consumedBits);\
+	}
+
+static void Inflate_InflateFast(struct InflateState* s) {
+	/* bit buffer variables */
+	cc_uint64 bits, value;
+	cc_uint32 numBits, rewind;
+	cc_uint8* in;
+	cc_uint8* inEnd;
+
+	/* huffman variables */
+	cc_uint32 entry, lit, len, dist;
+	cc_uint32 lenIdx, distIdx, consumedBits;
+	int packed, value1;
+
+	/* window variables */
+	cc_uint8* window;
+	cc_uint8* src;
+	cc_uint8* dst;
+	cc_uint32 curIdx, startIdx, availOut, step;
+	cc_uint32 i, copyStart, copyLen, partLen;
+
+	bits    = s->Bits;
+	numBits = s->NumBits;
+	in      = s->NextIn;
+	inEnd   = s->NextIn + s->AvailIn;
+
+	window    = s->Window;
+	curIdx    = s->WindowIndex;
+	copyStart = s->WindowIndex;
+	copyLen   = 0;
+	availOut  = s->AvailOut;
+
+#define INFLATE_FAST_COPY_MAX (INFLATE_WINDOW_SIZE - INFLATE_FASTINF_OUT)
+	while (availOut >= INFLATE_FASTINF_OUT && (inEnd - in) >= 8 && copyLen < INFLATE_FAST_COPY_MAX) {
+		/* Refill bit buffer to at least 56 bits, which is enough for a length and distance */
+		/* with their extra bits (at most 15 + 5 + 15 + 13 bits) */
+		Inflate_Copy8(&value, in);
+		bits |= value << numBits;
+		in   += (63 - numBits) >> 3;
+		numBits |= 56;
+
+		entry = s->LitsMulti[bits & ((1 << INFLATE_MULTI_BITS) - 1)];
+		if (MULTI_COUNT(entry) == 2) {
+			Inflate_WideConsume(MULTI_LEN(entry));
+			window[curIdx] = (cc_uint8)MULTI_VALUE1(entry);
+			curIdx = (curIdx + 1) & INFLATE_WINDOW_MASK;
+			window[curIdx] = (cc_uint8)MULTI_VALUE2(entry);
+			curIdx = (curIdx + 1) & INFLATE_WINDOW_MASK;
+
+			availOut -= 2; copyLen += 2;
+			continue;
+		}
+
+		if (entry) {
+			Inflate_WideConsume(MULTI_LEN(entry));
+			lit = MULTI_VALUE1(entry);
+		} else {
+			value1 = Huffman_DecodeWideSlow(&s->Table.Lits, bits, &consumedBits);
+			if (value1 == -1) { Inflate_Fail(s, INF_ERR_INVALID_CODE); break; }
+			Inflate_WideConsume(consumedBits);
+			lit = value1;
+		}
+
+		if (lit < 256) {
+			window[curIdx] = (cc_uint8)lit;
+			curIdx = (curIdx + 1) & INFLATE_WINDOW_MASK;
+			availOut--; copyLen++;
+			continue;
+		} else if (lit == 256) {
+			s->State = Inflate_NextBlockState(s);
+			break;
+		}
+
+		lenIdx = lit - 257;
+		len    = len_base[lenIdx] + ((cc_uint32)bits & ((1 << len_bits[lenIdx]) - 1));
+		Inflate_WideConsume(len_bits[lenIdx]);
+
+		Inflate_WideDecode(s->TableDists, distIdx);
+		dist = dist_base[distIdx] + ((cc_uint32)bits & ((1 << dist_bits[distIdx]) - 1));
+		Inflate_WideConsume(dist_bits[distIdx]);
+
+		/* Window infinitely repeats like ...xyz|uvwxyz|uvwxyz|uvw... */
+		/* If start and end don't cross a boundary, can avoid masking index */
+		startIdx = (curIdx - dist) & INFLATE_WINDOW_MASK;
+		if (curIdx >= startIdx && (curIdx + len) < INFLATE_WINDOW_SIZE) {
+			src = &window[startIdx];
+			dst = &window[curIdx];
+			i   = 0;
+
+			/* Source and destination can overlap, but each copy only reads data that */
+			/* has already been written as long as distance is at least the copy size */
+			if (dist >= 16) {
+				for (; i + 16 <= len; i += 16) { Inflate_Copy16(dst + i, src + i); }
+			} else if (dist && dist < 8) {
+				/* Repeat short pattern until it is at least 8 bytes long, then copy using that */
+				for (step = dist; step < 8; step += dist) { }
+				for (; i < step && i < len; i++) { dst[i] = src[i]; }
+				src = dst - step;
+			}
+
+			for (; i + 8 <= len; i += 8) { Inflate_Copy8(dst + i, src + i); }
+			for (; i < len; i++) { dst[i] = src[i]; }
+		} else {
+			for (i = 0; i < len; i++) {
+				window[(curIdx + i) & INFLATE_WINDOW_MASK] = window[(startIdx + i) & INFLATE_WINDOW_MASK];
+			}
+		}
+		curIdx = (curIdx + len) & INFLATE_WINDOW_MASK;
+		availOut -= len; copyLen += len;
+	}
+
+	/* Return whole bytes in the bit buffer that were read by this function back to */
+	/*  the input buffer, so that the remaining bits fit into the 32 bit state->Bits */
+	rewind   = min(numBits >> 3, (cc_uint32)(in - s->NextIn));
+	in      -= rewind;
+	numBits -= rewind * 8;
+
+	s->Bits     = (cc_uint32)(bits & (((cc_uint64)1 << numBits) - 1));
+	s->NumBits  = numBits;
+	s->AvailIn -= (cc_uint32)(in - s->NextIn);
+	s->NextIn   = in;
+
+	s->AvailOut    = availOut;
+	s->WindowIndex = curIdx;
+	if (!copyLen) return;
+
+	if (copyStart + copyLen < INFLATE_WINDOW_SIZE) {
+		Mem_Copy(s->Output, &s->Window[copyStart], copyLen);
+		s->Output += copyLen;
+	} else {
+		partLen = INFLATE_WINDOW_SIZE - copyStart;
+		Mem_Copy(s->Output, &s->Window[copyStart], partLen);
+		s->Output += partLen;
+		Mem_Copy(s->Output, s->Window, copyLen - partLen);
+		s->Output += (copyLen - partLen);
+	}
+}
+#endif
 
 void Inflate_Process(struct InflateState* s) {
 	cc_uint32 len, dist, nlen;
@@ -488,6 +705,7 @@ void Inflate_Process(struct InflateState* s) {
 			case 1: { /* Fixed/static huffman compressed */
 				(void)Huffman_Build(&s->Table.Lits, fixed_lits,  INFLATE_MAX_LITS);
 				(void)Huffman_Build(&s->TableDists, fixed_dists, INFLATE_MAX_DISTS);
+				Inflate_BuildMultiTable(s);
 				s->State = Inflate_NextCompressState(s);
 			} break;
 
@@ -600,6 +818,7 @@ void Inflate_Process(struct InflateState* s) {
 				if (res) { Inflate_Fail(s, res); return; }
 				res = Huffman_Build(&s->TableDists, s->Buffer + s->NumLits, s->NumDists);
 				if (res) { Inflate_Fail(s, res); return; }
+				Inflate_BuildMultiTable(s);
 			}
 			break;
 		}
@@ -778,6 +997,10 @@ void Inflate_MakeStream2(struct Stream* stream, struct InflateState* state, stru
 void GZip_MakeStream(struct Stream* stream, struct GZipState* state, struct Stream* underlying) { 
 	Process_Abort("Should never be called");
 }
+
+cc_result GZip_MakeParallelStream(struct Stream* stream, struct Stream* underlying, int level) {
+	return ERR_NOT_SUPPORTED;
+}
 #else
 
 /* these are copies of len_base and dist_base, with UINT16_MAX instead of 0 for sentinel cutoff */
@@ -792,19 +1015,37 @@ static const cc_uint16 deflate_dist[31] = {
 	1025,1537,2049,3073,4097,6145,8193,12289,16385,24577,UInt16_MaxValue
 };
 
+/* How much effort to spend searching for matches for each compression level */
+static const struct DeflateLevel {
+	cc_uint16 maxChain; /* Maximum number of hash chain entries to explore */
+	cc_uint16 lazyLen;  /* Only try for a longer match at next byte when current match is shorter than this */
+	cc_uint16 niceLen;  /* Stop searching as soon as a match is at least this long */
+} deflate_levels[DEFLATE_LEVEL_COUNT] = {
+	{    4,   0,  16 }, /* DEFLATE_LEVEL_FAST (0 lazyLen = greedy matching) */
+	{   32,  16, 128 }, /* DEFLATE_LEVEL_DEFAULT */
+	{ 4096, 258, 258 }  /* DEFLATE_LEVEL_BEST */
+};
+
 /* Pushes given bits, but does not write them */
 #define Deflate_PushBits(state, value, bits) state->Bits |= (value) << state->NumBits; state->NumBits += (bits);
 /* Pushes bits of the huffman codeword bits for the given literal, but does not write them */
 #define Deflate_PushLit(state, value) Deflate_PushBits(state, state->LitsCodewords[value], state->LitsLens[value])
-/* Pushes given bits (reversing for huffman code), but does not write them */
-#define Deflate_PushHuff(state, value, bits) Deflate_PushBits(state, Huffman_ReverseBits(value, bits), bits)
+/* Pushes bits of the huffman codeword bits for the given distance, but does not write them */
+#define Deflate_PushDist(state, value) Deflate_PushBits(state, state->DistsCodewords[value], state->DistsLens[value])
 /* Writes given byte to output */
 #define Deflate_WriteByte(state) *state->NextOut++ = state->Bits; state->AvailOut--; state->Bits >>= 8; state->NumBits -= 8;
 /* Flushes bits in buffer to output buffer */
 #define Deflate_FlushBits(state) while (state->NumBits >= 8) { Deflate_WriteByte(state); }
+/* Pads bits in buffer with 0 bits to a byte boundary, then flushes them to output buffer */
+#define Deflate_AlignBits(state) if (state->NumBits) { state->NumBits = 8; Deflate_WriteByte(state); }
 
 #define MIN_MATCH_LEN 3
 #define MAX_MATCH_LEN 258
+/* Number of literal/length and distance codes actually usable in DEFLATE */
+#define DEFLATE_NUM_LITS  286
+#define DEFLATE_NUM_DISTS 30
+/* Max number of bytes a single symbol/code can add to the output buffer */
+#define DEFLATE_OUT_RESERVE 20
 
 /* Number of bytes that match (are the same) from a and b */
 static int Deflate_MatchLen(cc_uint8* a, cc_uint8* b, int maxLen) {
@@ -815,33 +1056,117 @@ static int Deflate_MatchLen(cc_uint8* a, cc_uint8* b, int maxLen) {
 
 /* Hashes 3 bytes of data */
 static cc_uint32 Deflate_Hash(cc_uint8* src) {
-	return (cc_uint32)((src[0] << 8) ^ (src[1] << 4) ^ (src[2])) & DEFLATE_HASH_MASK;
+	cc_uint32 value = src[0] | (src[1] << 8) | (src[2] << 16);
+	return (cc_uint32)(value * 2654435761U) >> (32 - DEFLATE_HASH_BITS);
 }
 
-/* Writes a literal to state->Output */
-static void Deflate_Lit(struct DeflateState* state, int lit) {
-	Deflate_PushLit(state, lit);
-	Deflate_FlushBits(state);
+/* Returns the index of the highest set bit */
+static int Deflate_Log2(cc_uint32 value) {
+	int bits = 0;
+	while (value >>= 1) bits++;
+	return bits;
 }
 
-/* Writes a length-distance pair to state->Output */
-static void Deflate_LenDist(struct DeflateState* state, int len, int dist) {
-	int j;
-	/* TODO: Do we actually need the if (len_bits[j]) ????????? does writing 0 bits matter??? */
+/* Returns the length code (i.e. index into deflate_len) for the given match length */
+static int Deflate_LenCode(int len) {
+	int value = len - MIN_MATCH_LEN, bits;
+	if (len == MAX_MATCH_LEN) return 28;
+	if (value < 8) return value;
 
-	for (j = 0; len >= deflate_len[j + 1]; j++);
-	Deflate_PushLit(state, j + 257);
-	if (len_bits[j]) { Deflate_PushBits(state, len - deflate_len[j], len_bits[j]); }
-	Deflate_FlushBits(state);
+	bits = Deflate_Log2(value);
+	return 4 * (bits - 1) + ((value >> (bits - 2)) & 3);
+}
 
-	for (j = 0; dist >= deflate_dist[j + 1]; j++);
-	Deflate_PushHuff(state, j, 5);
-	if (dist_bits[j]) { Deflate_PushBits(state, dist - deflate_dist[j], dist_bits[j]); }
-	Deflate_FlushBits(state);
+/* Returns the distance code (i.e. index into deflate_dist) for the given match distance */
+static int Deflate_DistCode(int dist) {
+	int value = dist - 1, bits;
+	if (value < 4) return value;
+
+	bits = Deflate_Log2(value);
+	return 2 * bits + ((value >> (bits - 1)) & 1);
+}
+
+/* Writes buffered output data to the destination stream */
+static cc_result Deflate_FlushOutput(struct DeflateState* state) {
+	cc_result res = Stream_Write(state->Dest, state->Output, DEFLATE_OUT_SIZE - state->AvailOut);
+	state->NextOut  = state->Output;
+	state->AvailOut = DEFLATE_OUT_SIZE;
+	return res;
+}
+
+/* Ensures there is enough room in output buffer for another symbol/code */
+#define Deflate_ReserveOutput(state) if (state->AvailOut < DEFLATE_OUT_RESERVE && (res = Deflate_FlushOutput(state))) return res;
+
+
+/*########################################################################################################################*
+*-------------------------------------------------Deflate LZ77 matching---------------------------------------------------*
+*#########################################################################################################################*/
+/* Adds a literal to the list of symbols for the current block */
+static void Deflate_AddLit(struct DeflateState* state, int lit) {
+	state->SymLits[state->NumSyms]    = lit;
+	state->SymDists[state->NumSyms++] = 0;
+	state->LitsFreqs[lit]++;
+}
+
+/* Adds a length-distance pair to the list of symbols for the current block */
+static void Deflate_AddMatch(struct DeflateState* state, int len, int dist) {
+	state->SymLits[state->NumSyms]    = len - MIN_MATCH_LEN;
+	state->SymDists[state->NumSyms++] = dist;
+	state->LitsFreqs[257 + Deflate_LenCode(len)]++;
+	state->DistsFreqs[Deflate_DistCode(dist)]++;
+}
+
+/* Inserts the data starting at the given position into the hash chains */
+static void Deflate_Insert(struct DeflateState* state, int pos, cc_uint32 hash) {
+	state->Prev[pos]  = state->Head[hash];
+	state->Head[hash] = pos;
+}
+
+/* Finds the longest match starting at the given position that is longer than bestLen */
+/* Returns 0 if no such match was found */
+static int Deflate_FindMatch(struct DeflateState* state, const struct DeflateLevel* level, 
+							int cur, cc_uint32 hash, int maxLen, int bestLen, int* bestDist) {
+	cc_uint8* input = state->Input;
+	cc_uint8* src   = &input[cur];
+	cc_uint8* match;
+	int chain, pos, matchLen, found = 0;
+
+	/* Match must be at least 3 bytes */
+	if (bestLen < MIN_MATCH_LEN - 1) bestLen = MIN_MATCH_LEN - 1;
+	if (bestLen >= maxLen) return 0;
+
+	pos = state->Head[hash];
+	for (chain = level->maxChain; pos != 0 && chain > 0; chain--) {
+		match = &input[pos];
+
+		/* Quickly reject candidates that can't possibly be longer than current best */
+		if (match[bestLen] == src[bestLen] && match[0] == src[0] && match[1] == src[1]) {
+			matchLen = Deflate_MatchLen(match, src, maxLen);
+
+			if (matchLen > bestLen) {
+				bestLen   = matchLen;
+				found     = matchLen;
+				*bestDist = cur - pos;
+				if (bestLen >= level->niceLen || bestLen >= maxLen) break;
+			}
+		}
+		pos = state->Prev[pos];
+	}
+	return found;
+}
+
+/* Inserts all the positions within a match (except for the first) into the hash chains */
+static void Deflate_InsertMatch(struct DeflateState* state, int pos, int len, int end) {
+	int i, last = min(pos + len, end - (MIN_MATCH_LEN - 1));
+
+	for (i = pos + 1; i < last; i++) {
+		Deflate_Insert(state, i, Deflate_Hash(&state->Input[i]));
+	}
 }
 
 /* Moves "current block" to "previous block", adjusting state if needed. */
 static void Deflate_MoveBlock(struct DeflateState* state) {
+	cc_uint16 prev;
 	int i;
 	Mem_Copy(state->Input, state->Input + DEFLATE_BLOCK_SIZE, DEFLATE_BLOCK_SIZE);
 	state->InputPosition = DEFLATE_BLOCK_SIZE;
@@ -850,96 +1175,404 @@ static void Deflate_MoveBlock(struct DeflateState* state) {
 	for (i = 0; i < Array_Elems(state->Head); i++) {
 		state->Head[i] = state->Head[i] < DEFLATE_BLOCK_SIZE ? 0 : (state->Head[i] - DEFLATE_BLOCK_SIZE);
 	}
-	for (i = 0; i < Array_Elems(state->Prev); i++) {
-		state->Prev[i] = state->Prev[i] < DEFLATE_BLOCK_SIZE ? 0 : (state->Prev[i] - DEFLATE_BLOCK_SIZE);
+	/* hash chains of "current block" become the hash chains of "previous block" */
+	for (i = 0; i < DEFLATE_BLOCK_SIZE; i++) {
+		prev = state->Prev[i + DEFLATE_BLOCK_SIZE];
+		state->Prev[i] = prev < DEFLATE_BLOCK_SIZE ? 0 : (prev - DEFLATE_BLOCK_SIZE);
 	}
 }
 
-/* Compresses current block of data */
-static cc_result Deflate_FlushBlock(struct DeflateState* state, int len) {
-	cc_uint32 hash, nextHash;
-	int bestLen, maxLen, matchLen, depth;
-	int bestPos, pos, nextPos;
-	cc_uint16 oldHead;
-	cc_uint8* input;
-	cc_uint8* cur;
-	cc_result res;
-
-	if (!state->WroteHeader) {
-		state->WroteHeader = true;
-		Deflate_PushBits(state, 3, 3); /* final block TRUE, block type FIXED */
-	}
+/* Converts the given length of data in current block into a list of literals and length-distance pairs */
+static void Deflate_FindSymbols(struct DeflateState* state, int len) {
+	const struct DeflateLevel* level = &deflate_levels[state->Level];
+	cc_uint8* input = state->Input;
+	int pos = DEFLATE_BLOCK_SIZE, end = DEFLATE_BLOCK_SIZE + len;
+	int curLen, curDist = 0, prevLen = 0, prevDist = 0, maxLen;
+	cc_bool prevLit = false;
+	cc_uint32 hash;
 
 	/* Based off descriptions from http://www.gzip.org/algorithm.txt and
 	https://github.com/nothings/stb/blob/master/stb_image_write.h */
-	input = state->Input;
-	cur   = input + DEFLATE_BLOCK_SIZE;
-
-	/* Compress current block of data */
-	/* Use > instead of >=, because also try match at one byte after current */
-	while (len > MIN_MATCH_LEN) {
-		hash   = Deflate_Hash(cur);
-		maxLen = min(len, MAX_MATCH_LEN);
-
-		bestLen = MIN_MATCH_LEN - 1; /* Match must be at least 3 bytes */
-		bestPos = 0;
-
-		/* Find longest match starting at this byte */
-		/* Only explore up to 5 previous matches, to avoid slow performance */
-		/* (i.e prefer quickly saving maps/screenshots to completely optimal filesize) */
-		pos = state->Head[hash];
-		for (depth = 0; pos != 0 && depth < 5; depth++) {
-			matchLen = Deflate_MatchLen(&input[pos], cur, maxLen);
-			if (matchLen > bestLen) { bestLen = matchLen; bestPos = pos; }
-			pos = state->Prev[pos];
+	while (pos < end) {
+		maxLen = min(end - pos, MAX_MATCH_LEN);
+		curLen = 0;
+
+		if (maxLen >= MIN_MATCH_LEN) {
+			hash = Deflate_Hash(&input[pos]);
+			/* Don't bother searching when match at previous byte is already long enough */
+			if (prevLen < level->lazyLen || !level->lazyLen) {
+				curLen = Deflate_FindMatch(state, level, pos, hash, maxLen, prevLen, &curDist);
+			}
+			Deflate_Insert(state, pos, hash);
 		}
 
-		/* Insert this entry into the hash chain */
-		pos = (int)(cur - input);
-		oldHead = state->Head[hash];
-		state->Head[hash] = pos;
-		state->Prev[pos]  = oldHead;
-
-		/* Lazy evaluation: Find longest match starting at next byte */
-		/* If that's longer than the longest match at current byte, throwaway this match */
-		if (bestPos) {
-			nextHash = Deflate_Hash(cur + 1);
-			nextPos  = state->Head[nextHash];
-			maxLen   = min(len - 1, MAX_MATCH_LEN);
-
-			for (depth = 0; nextPos != 0 && depth < 5; depth++) {
-				matchLen = Deflate_MatchLen(&input[nextPos], cur + 1, maxLen);
-				if (matchLen > bestLen) { bestPos = 0; break; }
-				nextPos = state->Prev[nextPos];
+		if (!level->lazyLen) {
+			/* Greedy matching: always immediately use match at current byte */
+			if (curLen) {
+				Deflate_AddMatch(state, curLen, curDist);
+				Deflate_InsertMatch(state, pos, curLen, end);
+				pos += curLen;
+			} else {
+				Deflate_AddLit(state, input[pos]);
+				pos++;
 			}
+		} else if (prevLen && curLen <= prevLen) {
+			/* Lazy matching: match at previous byte is at least as long as match at current byte */
+			Deflate_AddMatch(state, prevLen, prevDist);
+			Deflate_InsertMatch(state, pos, prevLen - 1, end);
+
+			pos    += prevLen - 1;
+			prevLen = 0;
+			prevLit = false;
+		} else {
+			/* Lazy matching: previous byte isn't part of a match, but current byte might be */
+			if (prevLit) Deflate_AddLit(state, input[pos - 1]);
+
+			prevLen  = curLen;
+			prevDist = curDist;
+			prevLit  = true;
+			pos++;
 		}
+	}
+	if (prevLit) Deflate_AddLit(state, input[pos - 1]);
+}
 
-		if (bestPos) {
-			Deflate_LenDist(state, bestLen, pos - bestPos);
-			len -= bestLen; cur += bestLen;
+
+/*########################################################################################################################*
+*-------------------------------------------------Deflate huffman coding--------------------------------------------------*
+*#########################################################################################################################*/
+/* Computes optimal huffman code lengths from the given sorted frequencies (in-place) */
+/* Based on "In-Place Calculation of Minimum-Redundancy Codes" by Moffat and Katajainen */
+static void Deflate_CalcCodeLengths(int* A, int n) {
+	int root, leaf, next, avail, used, depth;
+
+	A[0] += A[1]; root = 0; leaf = 2;
+	/* First pass, left to right, setting parent pointers */
+	for (next = 1; next < n - 1; next++) {
+		if (leaf >= n || A[root] < A[leaf]) {
+			A[next] = A[root]; A[root++] = next;
 		} else {
-			Deflate_Lit(state, *cur);
-			len--; cur++;
+			A[next] = A[leaf++];
 		}
 
-		/* leave room for a few bytes and literals at end */
-		if (state->AvailOut >= 20) continue;
-		res = Stream_Write(state->Dest, state->Output, DEFLATE_OUT_SIZE - state->AvailOut);
-		state->NextOut  = state->Output;
-		state->AvailOut = DEFLATE_OUT_SIZE;
-		if (res) return res;
+		if (leaf >= n || (root < next && A[root] < A[leaf])) {
+			A[next] += A[root]; A[root++] = next;
+		} else {
+			A[next] += A[leaf++];
+		}
+	}
+
+	/* Second pass, right to left, setting internal depths */
+	A[n - 2] = 0;
+	for (next = n - 3; next >= 0; next--) { A[next] = A[A[next]] + 1; }
+
+	/* Third pass, right to left, setting leaf depths */
+	avail = 1; used = 0; depth = 0;
+	root  = n - 2; next = n - 1;
+
+	while (avail > 0) {
+		while (root >= 0 && A[root] == depth) { used++; root--; }
+		while (avail > used) { A[next--] = depth; avail--; }
+
+		avail = 2 * used; depth++; used = 0;
 	}
+}
+
+/* Computes huffman code lengths, that are at most maxBits long, for the given symbol frequencies */
+static void Deflate_BuildLengths(const cc_uint16* freqs, int count, int maxBits, cc_uint8* lens) {
+	cc_uint16 syms[INFLATE_MAX_LITS];
+	int A[INFLATE_MAX_LITS];
+	int numCodes[INFLATE_MAX_BITS];
+	int i, j, n = 0, sym, len;
+	cc_uint32 total;
+
+	/* Insertion sort used symbols by ascending frequency */
+	for (i = 0; i < count; i++) {
+		lens[i] = 0;
+		if (!freqs[i]) continue;
+
+		for (j = n++; j > 0 && freqs[syms[j - 1]] > freqs[i]; j--) {
+			syms[j] = syms[j - 1];
+		}
+		syms[j] = i;
+	}
+
+	/* Ensure there are always at least two codes, as a single code with 0 bits is not valid */
+	if (n < 2) {
+		sym = n ? syms[0] : 0;
+		lens[sym] = 1; lens[sym ? 0 : 1] = 1;
+		return;
+	}
+
+	for (i = 0; i < n; i++) A[i] = freqs[syms[i]];
+	Deflate_CalcCodeLengths(A, n);
+
+	/* Count number of codes of each length, limiting to maxBits */
+	for (i = 0; i <= maxBits; i++) numCodes[i] = 0;
+	for (i = 0; i < n; i++) numCodes[min(A[i], maxBits)]++;
+
+	/* If some lengths had to be limited, the code is now oversubscribed. */
+	/* So lengthen codes until the huffman code is complete again */
+	total = 0;
+	for (i = maxBits; i > 0; i--) total += (cc_uint32)numCodes[i] << (maxBits - i);
+
+	while (total != (1UL << maxBits)) {
+		numCodes[maxBits]--;
+		for (i = maxBits - 1; i > 0; i--) {
+			if (!numCodes[i]) continue;
+			numCodes[i]--; numCodes[i + 1] += 2; break;
+		}
+		total--;
+	}
+
+	/* Assign longest codes to least frequent symbols */
+	sym = 0;
+	for (len = maxBits; len > 0; len--) {
+		for (i = 0; i < numCodes[len]; i++) { lens[syms[sym++]] = len; }
+	}
+}
+
+/* Constructs a huffman encoding table (for values to codewords) */
+static void Deflate_BuildTable(const cc_uint8* lens, int count, cc_uint16* codewords, cc_uint8* bitlens) {
+	int i, j, offset, codeword;
+	struct HuffmanTable table;
+
+	/* NOTE: Can ignore since lens table is not user controlled */
+	(void)Huffman_Build(&table, lens, count);
+	for (i = 0; i < INFLATE_MAX_BITS; i++) {
+		if (!table.endCodewords[i]) continue;
+		count = table.endCodewords[i] - table.firstCodewords[i];
+
+		for (j = 0; j < count; j++) {
+			offset   = table.values[table.firstOffsets[i] + j];
+			codeword = table.firstCodewords[i] + j;
+			bitlens[offset]   = i;
+			codewords[offset] = Huffman_ReverseBits(codeword, i);
+		}
+	}
+}
+
+/* Run length encodes the given code lengths, using code length codes 16/17/18 for repeats */
+static int Deflate_EncodeLengths(const cc_uint8* lens, int count, cc_uint8* codes, cc_uint8* extra) {
+	int i = 0, n = 0, run, value, rep;
+
+	while (i < count) {
+		value = lens[i];
+		for (run = 1; i + run < count && lens[i + run] == value; run++) { }
+		i += run;
+
+		if (!value) {
+			/* 18 = repeat zero 11-138 times, 17 = repeat zero 3-10 times */
+			for (; run >= 11; run -= rep) {
+				rep = min(run, 138);
+				codes[n] = 18; extra[n++] = rep - 11;
+			}
+			if (run >= 3) {
+				codes[n] = 17; extra[n++] = run - 3; run = 0;
+			}
+		} else {
+			/* 16 = repeat previous code length 3-6 times */
+			codes[n] = value; extra[n++] = 0; run--;
+			for (; run >= 3; run -= rep) {
+				rep = min(run, 6);
+				codes[n] = 16; extra[n++] = rep - 3;
+			}
+		}
+
+		for (; run > 0; run--) { codes[n] = value; extra[n++] = 0; }
+	}
+	return n;
+}
+
+static const cc_uint8 codelens_bits[3] = { 2, 3, 7 };
+/* Number of extra bits needed to encode all the symbols in current block */
+static cc_uint32 Deflate_ExtraBits(struct DeflateState* state) {
+	cc_uint32 i, bits = 0;
+	for (i = 0; i < 29; i++) bits += state->LitsFreqs[257 + i] * len_bits[i];
+	for (i = 0; i < DEFLATE_NUM_DISTS; i++) bits += state->DistsFreqs[i] * dist_bits[i];
+	return bits;
+}
+
+/* Number of bits needed to huffman encode all the symbols in current block with the given code lengths */
+static cc_uint32 Deflate_CodeBits(struct DeflateState* state, const cc_uint8* litLens, const cc_uint8* distLens) {
+	cc_uint32 i, bits = 0;
+	for (i = 0; i < DEFLATE_NUM_LITS;  i++) bits += state->LitsFreqs[i]  * litLens[i];
+	for (i = 0; i < DEFLATE_NUM_DISTS; i++) bits += state->DistsFreqs[i] * distLens[i];
+	return bits;
+}
+
+
+/*########################################################################################################################*
+*--------------------------------------------------Deflate block output---------------------------------------------------*
+*#########################################################################################################################*/
+/* Writes the list of symbols for the current block to the output, then the end of block symbol */
+static cc_result Deflate_WriteSymbols(struct DeflateState* state) {
+	int i, j, len, dist;
+	cc_result res;
+
+	for (i = 0; i < state->NumSyms; i++) {
+		Deflate_ReserveOutput(state);
+		dist = state->SymDists[i];
+
+		if (!dist) {
+			Deflate_PushLit(state, state->SymLits[i]);
+			Deflate_FlushBits(state);
+			continue;
+		}
+		len = state->SymLits[i] + MIN_MATCH_LEN;
+
+		j = Deflate_LenCode(len);
+		Deflate_PushLit(state, j + 257);
+		Deflate_FlushBits(state);
+		Deflate_PushBits(state, len - deflate_len[j], len_bits[j]);
+		Deflate_FlushBits(state);
+
+		j = Deflate_DistCode(dist);
+		Deflate_PushDist(state, j);
+		Deflate_FlushBits(state);
+		Deflate_PushBits(state, dist - deflate_dist[j], dist_bits[j]);
+		Deflate_FlushBits(state);
+	}
+
+	Deflate_ReserveOutput(state);
+	Deflate_PushLit(state, 256);
+	Deflate_FlushBits(state);
+	return 0;
+}
+
+/* Writes the current block as uncompressed data */
+static cc_result Deflate_WriteStored(struct DeflateState* state, int len, cc_bool final) {
+	cc_uint8* src = state->Input + DEFLATE_BLOCK_SIZE;
+	cc_uint32 count;
+	cc_result res;
+
+	Deflate_ReserveOutput(state);
+	Deflate_PushBits(state, final, 3); /* block type STORED */
+	Deflate_FlushBits(state);
+	Deflate_AlignBits(state);
+
+	Deflate_PushBits(state, len, 16);
+	Deflate_FlushBits(state);
+	Deflate_PushBits(state, len ^ 0xFFFF, 16);
+	Deflate_FlushBits(state);
 
-	/* literals for last few bytes */
 	while (len > 0) {
-		Deflate_Lit(state, *cur);
-		len--; cur++;
+		Deflate_ReserveOutput(state);
+		count = min((cc_uint32)len, state->AvailOut);
+		Mem_Copy(state->NextOut, src, count);
+
+		state->NextOut  += count;
+		state->AvailOut -= count;
+		src += count; len -= count;
 	}
+	return 0;
+}
 
-	res = Stream_Write(state->Dest, state->Output, DEFLATE_OUT_SIZE - state->AvailOut);
-	state->NextOut  = state->Output;
-	state->AvailOut = DEFLATE_OUT_SIZE;
+/* Writes the huffman code lengths for the current block */
+static cc_result Deflate_WriteDynamicHeader(struct DeflateState* state, int numLits, int numDists, int numCodelens,
+											const cc_uint8* codelensLens, const cc_uint8* codes, const cc_uint8* extra, int numCodes) {
+	cc_uint16 codewords[INFLATE_MAX_CODELENS];
+	cc_uint8  bitlens[INFLATE_MAX_CODELENS];
+	int i, code;
+	cc_result res;
+
+	Deflate_BuildTable(codelensLens, INFLATE_MAX_CODELENS, codewords, bitlens);
+	Deflate_PushBits(state, numLits  - 257, 5);
+	Deflate_PushBits(state, numDists - 1,   5);
+	Deflate_FlushBits(state);
+	Deflate_PushBits(state, numCodelens - 4, 4);
+	Deflate_FlushBits(state);
+
+	for (i = 0; i < numCodelens; i++) {
+		Deflate_ReserveOutput(state);
+		Deflate_PushBits(state, codelensLens[codelens_order[i]], 3);
+		Deflate_FlushBits(state);
+	}
+
+	for (i = 0; i < numCodes; i++) {
+		Deflate_ReserveOutput(state);
+		code = codes[i];
+		Deflate_PushBits(state, codewords[code], bitlens[code]);
+		Deflate_FlushBits(state);
 
+		if (code < 16) continue;
+		Deflate_PushBits(state, extra[i], codelens_bits[code - 16]);
+		Deflate_FlushBits(state);
+	}
+	return 0;
+}
+
+/* Compresses current block of data, then writes it to the output using the smallest block type */
+static cc_result Deflate_FlushBlock(struct DeflateState* state, int len, cc_bool final) {
+	cc_uint8 lens[DEFLATE_NUM_LITS + DEFLATE_NUM_DISTS];
+	cc_uint8 litLens[INFLATE_MAX_LITS], distLens[INFLATE_MAX_DISTS];
+	cc_uint8 codes[DEFLATE_NUM_LITS + DEFLATE_NUM_DISTS], extra[DEFLATE_NUM_LITS + DEFLATE_NUM_DISTS];
+	cc_uint16 codelensFreqs[INFLATE_MAX_CODELENS];
+	cc_uint8  codelensLens[INFLATE_MAX_CODELENS];
+	int i, numLits, numDists, numCodelens, numCodes;
+	cc_uint32 extraBits, dynamicBits, fixedBits, storedBits;
+	cc_result res;
+
+	Deflate_FindSymbols(state, len);
+	state->LitsFreqs[256] = 1; /* end of block symbol */
+
+	/* Work out the huffman code lengths for a dynamic block */
+	Deflate_BuildLengths(state->LitsFreqs,  DEFLATE_NUM_LITS,  15, litLens);
+	Deflate_BuildLengths(state->DistsFreqs, DEFLATE_NUM_DISTS, 15, distLens);
+
+	for (numLits  = DEFLATE_NUM_LITS;  numLits  > 257 && !litLens[numLits - 1];   numLits--)  { }
+	for (numDists = DEFLATE_NUM_DISTS; numDists > 1   && !distLens[numDists - 1]; numDists--) { }
+
+	Mem_Copy(lens,           litLens,  numLits);
+	Mem_Copy(lens + numLits, distLens, numDists);
+	numCodes = Deflate_EncodeLengths(lens, numLits + numDists, codes, extra);
+
+	Mem_Set(codelensFreqs, 0, sizeof(codelensFreqs));
+	for (i = 0; i < numCodes; i++) codelensFreqs[codes[i]]++;
+	Deflate_BuildLengths(codelensFreqs, INFLATE_MAX_CODELENS, 7, codelensLens);
+
+	for (numCodelens = INFLATE_MAX_CODELENS; numCodelens > 4 && !codelensLens[codelens_order[numCodelens - 1]]; numCodelens--) { }
+
+	/* Work out how many bits each block type would need */
+	extraBits   = Deflate_ExtraBits(state);
+	dynamicBits = 3 + 5 + 5 + 4 + 3 * numCodelens + Deflate_CodeBits(state, litLens, distLens) + extraBits;
+	for (i = 0; i < numCodes; i++) {
+		dynamicBits += codelensLens[codes[i]];
+		if (codes[i] >= 16) dynamicBits += codelens_bits[codes[i] - 16];
+	}
+
+	fixedBits  = 3 + Deflate_CodeBits(state, fixed_lits, fixed_dists) + extraBits;
+	storedBits = 3 + ((8 - ((state->NumBits + 3) & 7)) & 7) + 32 + len * 8;
+
+	if (dynamicBits < fixedBits && dynamicBits <= storedBits) {
+		Deflate_ReserveOutput(state);
+		Deflate_PushBits(state, final | (2 << 1), 3); /* block type DYNAMIC */
+
+		res = Deflate_WriteDynamicHeader(state, numLits, numDists, numCodelens, 
+										codelensLens, codes, extra, numCodes);
+		if (res) return res;
+
+		Deflate_BuildTable(litLens,  DEFLATE_NUM_LITS,  state->LitsCodewords,  state->LitsLens);
+		Deflate_BuildTable(distLens, DEFLATE_NUM_DISTS, state->DistsCodewords, state->DistsLens);
+		res = Deflate_WriteSymbols(state);
+	} else if (fixedBits <= storedBits) {
+		Deflate_ReserveOutput(state);
+		Deflate_PushBits(state, final | (1 << 1), 3); /* block type FIXED */
+
+		Deflate_BuildTable(fixed_lits,  INFLATE_MAX_LITS,  state->LitsCodewords,  state->LitsLens);
+		Deflate_BuildTable(fixed_dists, INFLATE_MAX_DISTS, state->DistsCodewords, state->DistsLens);
+		res = Deflate_WriteSymbols(state);
+	} else {
+		res = Deflate_WriteStored(state, len, final);
+	}
+	if (res) return res;
+
+	/* Reset symbols for next block */
+	state->NumSyms = 0;
+	Mem_Set(state->LitsFreqs,  0, sizeof(state->LitsFreqs));
+	Mem_Set(state->DistsFreqs, 0, sizeof(state->DistsFreqs));
+
+	res = Deflate_FlushOutput(state);
 	Deflate_MoveBlock(state);
 	return res;
 }
@@ -966,52 +1599,55 @@ static cc_result Deflate_StreamWrite(struct Stream* stream, const cc_uint8* data
 		data += len;
 
 		if (state->InputPosition == DEFLATE_BUFFER_SIZE) {
-			res = Deflate_FlushBlock(state, DEFLATE_BLOCK_SIZE);
+			res = Deflate_FlushBlock(state, DEFLATE_BLOCK_SIZE, false);
 			if (res) return res;
 		}
 	}
 	return 0;
 }
 
-/* Flushes any buffered data, then writes terminating symbol */
-static cc_result Deflate_StreamClose(struct Stream* stream) {
-	struct DeflateState* state;
+/* Flushes any buffered data, leaving the output aligned to a byte boundary */
+/* When not the final block, the output can then have further DEFLATE data appended to it */
+static cc_result Deflate_Finish(struct DeflateState* state, cc_bool final) {
+	int len = state->InputPosition - DEFLATE_BLOCK_SIZE;
 	cc_result res;
 
-	state = (struct DeflateState*)stream->meta.inflate;
-	res   = Deflate_FlushBlock(state, state->InputPosition - DEFLATE_BLOCK_SIZE);
-	if (res) return res;
-
-	/* Write huffman encoded "literal 256" to terminate symbols */
-	Deflate_PushLit(state, 256);
-	Deflate_FlushBits(state);
+	if (len || final) {
+		res = Deflate_FlushBlock(state, len, final);
+		if (res) return res;
+	}
 
-	/* In case last byte still has a few extra bits */
-	if (state->NumBits) {
-		while (state->NumBits < 8) { Deflate_PushBits(state, 0, 1); }
+	if (!final) {
+		/* Empty stored block to get to a byte boundary */
+		Deflate_PushBits(state, 0, 3);
+		Deflate_FlushBits(state);
+		Deflate_AlignBits(state);
+		Deflate_PushBits(state, 0x0000, 16);
+		Deflate_FlushBits(state);
+		Deflate_PushBits(state, 0xFFFF, 16);
 		Deflate_FlushBits(state);
 	}
 
-	return Stream_Write(state->Dest, state->Output, DEFLATE_OUT_SIZE - state->AvailOut);
+	/* In case last byte still has a few extra bits */
+	Deflate_AlignBits(state);
+	return Deflate_FlushOutput(state);
 }
 
-/* Constructs a huffman encoding table (for values to codewords) */
-static void Deflate_BuildTable(const cc_uint8* lens, int count, cc_uint16* codewords, cc_uint8* bitlens) {
-	int i, j, offset, codeword;
-	struct HuffmanTable table;
+/* Flushes any buffered data as the final block */
+static cc_result Deflate_StreamClose(struct Stream* stream) {
+	struct DeflateState* state = (struct DeflateState*)stream->meta.inflate;
+	return Deflate_Finish(state, true);
+}
 
-	/* NOTE: Can ignore since lens table is not user controlled */
-	(void)Huffman_Build(&table, lens, count);
-	for (i = 0; i < INFLATE_MAX_BITS; i++) {
-		if (!table.endCodewords[i]) continue;
-		count = table.endCodewords[i] - table.firstCodewords[i];
+/* Primes the hash chains with data that precedes the data to be compressed */
+/* (i.e. so that the first block of data can reference the end of the preceding data) */
+static void Deflate_SetDictionary(struct DeflateState* state, const cc_uint8* data, int len) {
+	int i, beg = DEFLATE_BLOCK_SIZE - len;
+	Mem_Copy(state->Input + beg, data, len);
 
-		for (j = 0; j < count; j++) {
-			offset   = table.values[table.firstOffsets[i] + j];
-			codeword = table.firstCodewords[i] + j;
-			bitlens[offset]   = i;
-			codewords[offset] = Huffman_ReverseBits(codeword, i);
-		}
+	/* Position 0 is used to indicate no entry in the hash chain */
+	for (i = max(beg, 1); i < DEFLATE_BLOCK_SIZE - (MIN_MATCH_LEN - 1); i++) {
+		Deflate_Insert(state, i, Deflate_Hash(&state->Input[i]));
 	}
 }
 
@@ -1029,11 +1665,13 @@ void Deflate_MakeStream(struct Stream* stream, struct DeflateState* state, struc
 	state->NextOut  = state->Output;
 	state->AvailOut = DEFLATE_OUT_SIZE;
 	state->Dest     = underlying;
-	state->WroteHeader = false;
+	state->Level    = DEFLATE_LEVEL_DEFAULT;
 
+	state->NumSyms  = 0;
+	Mem_Set(state->LitsFreqs,  0, sizeof(state->LitsFreqs));
+	Mem_Set(state->DistsFreqs, 0, sizeof(state->DistsFreqs));
 	Mem_Set(state->Head, 0, sizeof(state->Head));
 	Mem_Set(state->Prev, 0, sizeof(state->Prev));
-	Deflate_BuildTable(fixed_lits, INFLATE_MAX_LITS, state->LitsCodewords, state->LitsLens);
 }
 
 
@@ -1066,10 +1704,14 @@ static cc_result GZip_StreamWrite(struct Stream* stream, const cc_uint8* data, c
 }
 
 static cc_result GZip_StreamWriteFirst(struct Stream* stream, const cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
-	static cc_uint8 header[10] = { 0x1F, 0x8B, 0x08 }; /* GZip header */
+	cc_uint8 header[10] = { 0x1F, 0x8B, 0x08 }; /* GZip header */
 	struct GZipState* state = (struct GZipState*)stream->meta.inflate;
 	cc_result res;
 
+	/* XFL field: 2 = maximum compression, 4 = fastest compression */
+	if (state->Base.Level == DEFLATE_LEVEL_BEST) header[8] = 2;
+	if (state->Base.Level == DEFLATE_LEVEL_FAST) header[8] = 4;
+
 	if ((res = Stream_Write(state->Base.Dest, header, sizeof(header)))) return res;
 	stream->Write = GZip_StreamWrite;
 	return GZip_StreamWrite(stream, data, count, modified);
@@ -1114,10 +1756,14 @@ static cc_result ZLib_StreamWrite(struct Stream* stream, const cc_uint8* data, c
 }
 
 static cc_result ZLib_StreamWriteFirst(struct Stream* stream, const cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
-	static cc_uint8 header[2] = { 0x78, 0x9C }; /* ZLib header */
+	cc_uint8 header[2] = { 0x78, 0x9C }; /* ZLib header */
 	struct ZLibState* state = (struct ZLibState*)stream->meta.inflate;
 	cc_result res;
 
+	/* FLEVEL field in second byte (checksum bits adjusted to match) */
+	if (state->Base.Level == DEFLATE_LEVEL_BEST) header[1] = 0xDA;
+	if (state->Base.Level == DEFLATE_LEVEL_FAST) header[1] = 0x01;
+
 	if ((res = Stream_Write(state->Base.Dest, header, sizeof(header)))) return res;
 	stream->Write = ZLib_StreamWrite;
 	return ZLib_StreamWrite(stream, data, count, modified);
@@ -1129,6 +1775,292 @@ void ZLib_MakeStream(struct Stream* stream, struct ZLibState* state, struct Stre
 	stream->Write = ZLib_StreamWriteFirst;
 	stream->Close = ZLib_StreamClose;
 }
+
+
+/*########################################################################################################################*
+*-------------------------------------------------Parallel GZip (compress)------------------------------------------------*
+*#########################################################################################################################*/
+#if defined CC_BUILD_COOPTHREADED
+cc_result GZip_MakeParallelStream(struct Stream* stream, struct Stream* underlying, int level) {
+	return ERR_NOT_SUPPORTED;
+}
+#else
+/* Input data is split into chunks, which are compressed independently on worker threads into */
+/*  byte aligned DEFLATE data, and then concatenated together into a single GZIP stream. */
+/* Each chunk is primed with the end of the preceding chunk, so hardly any compression is lost */
+#define GZIP_PAR_WORKERS 4
+#define GZIP_PAR_JOBS (GZIP_PAR_WORKERS * 2)
+#define GZIP_PAR_CHUNK_SIZE (256 * 1024)
+
+enum GZipJobState { GZIP_JOB_FREE, GZIP_JOB_PENDING, GZIP_JOB_ACTIVE, GZIP_JOB_DONE };
+struct GZipJob {
+	cc_uint8* input;     /* DEFLATE_BLOCK_SIZE bytes of dictionary, followed by the chunk of data */
+	cc_uint32 inputLen;  /* Number of bytes of data in the chunk */
+	cc_uint32 dictLen;   /* Number of bytes of preceding data the chunk is primed with */
+	cc_uint8* output;    /* Compressed DEFLATE data */
+	cc_uint32 outputLen, outputCap;
+	cc_uint32 crc32, id;
+	cc_bool final;
+	cc_uint8 state;
+	cc_result res;
+};
+
+static struct GZipParallel {
+	struct GZipJob jobs[GZIP_PAR_JOBS];
+	void* workers[GZIP_PAR_WORKERS];
+	void* mutex;
+	void* workWaitable; /* Signalled when a job is submitted */
+	void* doneWaitable; /* Signalled when a job is completed */
+	struct Stream* dest;
+	int curJob, level;
+	cc_uint32 nextId, crc32, size;
+	cc_bool quit;
+	cc_result res;
+} gzPar;
+
+static cc_result GZipJob_WriteOutput(struct Stream* stream, const cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
+	struct GZipJob* job = (struct GZipJob*)stream->meta.inflate;
+	cc_uint8* output;
+	cc_uint32 cap;
+	*modified = 0;
+
+	if (job->outputLen + count > job->outputCap) {
+		cap    = max(job->outputCap * 2, job->outputLen + count);
+		output = (cc_uint8*)Mem_TryRealloc(job->output, cap, 1);
+		if (!output) return ERR_OUT_OF_MEMORY;
+
+		job->output    = output;
+		job->outputCap = cap;
+	}
+
+	Mem_Copy(job->output + job->outputLen, data, count);
+	job->outputLen += count;
+	*modified = count;
+	return 0;
+}
+
+static void GZipJob_Compress(struct GZipJob* job, struct DeflateState* state) {
+	cc_uint8* data = job->input + DEFLATE_BLOCK_SIZE;
+	struct Stream output, stream;
+	cc_result res;
+
+	Stream_Init(&output);
+	output.meta.inflate = job;
+	output.Write        = GZipJob_WriteOutput;
+
+	Deflate_MakeStream(&stream, state, &output);
+	state->Level = gzPar.level;
+	Deflate_SetDictionary(state, data - job->dictLen, job->dictLen);
+
+	res = Stream_Write(&stream, data, job->inputLen);
+	if (!res) res = Deflate_Finish(state, job->final);
+
+	job->crc32 = Utils_CRC32(data, job->inputLen);
+	job->res   = res;
+}
+
+/* Returns the oldest job that is waiting to be compressed */
+static struct GZipJob* GZipParallel_NextJob(void) {
+	struct GZipJob* next = NULL;
+	int i;
+
+	for (i = 0; i < GZIP_PAR_JOBS; i++) {
+		struct GZipJob* job = &gzPar.jobs[i];
+		if (job->state != GZIP_JOB_PENDING) continue;
+		if (!next || job->id < next->id) next = job;
+	}
+	return next;
+}
+
+static void GZipParallel_WorkerLoop(void) {
+	struct DeflateState* state = (struct DeflateState*)Mem_TryAlloc(1, sizeof(struct DeflateState));
+	struct GZipJob* job;
+	cc_bool quit, more;
+
+	for (;;) {
+		Mutex_Lock(gzPar.mutex);
+		{
+			job = GZipParallel_NextJob();
+			if (job) job->state = GZIP_JOB_ACTIVE;
+			more = GZipParallel_NextJob() != NULL;
+			quit = gzPar.quit;
+		}
+		Mutex_Unlock(gzPar.mutex);
+		/* Wake up another worker, in case multiple jobs were submitted */
+		if (more || (quit && !job)) Waitable_Signal(gzPar.workWaitable);
+
+		if (job) {
+			if (state) {
+				GZipJob_Compress(job, state);
+			} else {
+				job->res = ERR_OUT_OF_MEMORY;
+			}
+
+			Mutex_Lock(gzPar.mutex);
+			job->state = GZIP_JOB_DONE;
+			Mutex_Unlock(gzPar.mutex);
+			Waitable_Signal(gzPar.doneWaitable);
+		} else if (quit) {
+			break;
+		} else {
+			Waitable_Wait(gzPar.workWaitable);
+		}
+	}
+	Mem_Free(state);
+}
+
+/* Waits for the given job to be compressed, then writes its output */
+static cc_result GZipParallel_WriteJob(struct GZipJob* job) {
+	cc_uint8 state;
+	cc_result res;
+
+	for (;;) {
+		Mutex_Lock(gzPar.mutex);
+		state = job->state;
+		Mutex_Unlock(gzPar.mutex);
+
+		if (state == GZIP_JOB_DONE) break;
+		Waitable_Wait(gzPar.doneWaitable);
+	}
+	job->state = GZIP_JOB_FREE;
+
+	if (job->res) return job->res;
+	if ((res = Stream_Write(gzPar.dest, job->output, job->outputLen))) return res;
+
+	gzPar.crc32 = Utils_CRC32Combine(gzPar.crc32, job->crc32, job->inputLen);
+	gzPar.size += job->inputLen;
+	return 0;
+}
+
+/* Submits the current job to be compressed, then prepares the next job */
+static cc_result GZipParallel_Submit(cc_bool final) {
+	struct GZipJob* job = &gzPar.jobs[gzPar.curJob];
+	struct GZipJob* next;
+	cc_result res;
+
+	job->final = final;
+	job->id    = gzPar.nextId++;
+
+	Mutex_Lock(gzPar.mutex);
+	job->state = GZIP_JOB_PENDING;
+	Mutex_Unlock(gzPar.mutex);
+	Waitable_Signal(gzPar.workWaitable);
+	if (final) return 0;
+
+	/* Next job might still be in use from earlier (i.e. it's the oldest job) */
+	gzPar.curJob = (gzPar.curJob + 1) % GZIP_PAR_JOBS;
+	next = &gzPar.jobs[gzPar.curJob];
+	if (next->state != GZIP_JOB_FREE && (res = GZipParallel_WriteJob(next))) return res;
+
+	next->dictLen   = min(job->inputLen, DEFLATE_BLOCK_SIZE);
+	next->inputLen  = 0;
+	next->outputLen = 0;
+	Mem_Copy(next->input + DEFLATE_BLOCK_SIZE - next->dictLen, 
+			  job->input + DEFLATE_BLOCK_SIZE + job->inputLen - next->dictLen, next->dictLen);
+	return 0;
+}
+
+static cc_result GZipParallel_StreamWrite(struct Stream* stream, const cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
+	struct GZipJob* job;
+	cc_uint32 len;
+	*modified = 0;
+	if (gzPar.res) return gzPar.res;
+
+	while (count > 0) {
+		job = &gzPar.jobs[gzPar.curJob];
+		len = min(count, GZIP_PAR_CHUNK_SIZE - job->inputLen);
+		Mem_Copy(job->input + DEFLATE_BLOCK_SIZE + job->inputLen, data, len);
+
+		job->inputLen += len;
+		*modified     += len;
+		data  += len;
+		count -= len;
+
+		if (job->inputLen < GZIP_PAR_CHUNK_SIZE) continue;
+		if ((gzPar.res = GZipParallel_Submit(false))) return gzPar.res;
+	}
+	return 0;
+}
+
+static void GZipParallel_Free(void) {
+	int i;
+	Mutex_Lock(gzPar.mutex);
+	gzPar.quit = true;
+	Mutex_Unlock(gzPar.mutex);
+	Waitable_Signal(gzPar.workWaitable);
+
+	for (i = 0; i < GZIP_PAR_WORKERS; i++) {
+		if (gzPar.workers[i]) Thread_Join(gzPar.workers[i]);
+		gzPar.workers[i] = NULL;
+	}
+
+	for (i = 0; i < GZIP_PAR_JOBS; i++) {
+		Mem_Free(gzPar.jobs[i].input);
+		Mem_Free(gzPar.jobs[i].output);
+	}
+	Mutex_Free(gzPar.mutex);
+	Waitable_Free(gzPar.workWaitable);
+	Waitable_Free(gzPar.doneWaitable);
+	gzPar.mutex = NULL;
+}
+
+static cc_result GZipParallel_StreamClose(struct Stream* stream) {
+	cc_uint8 data[8];
+	cc_result res = gzPar.res;
+	int i;
+	if (!res) res = GZipParallel_Submit(true);
+
+	/* Write out all remaining jobs, from oldest to newest */
+	for (i = 1; i <= GZIP_PAR_JOBS && !res; i++) {
+		struct GZipJob* job = &gzPar.jobs[(gzPar.curJob + i) % GZIP_PAR_JOBS];
+		if (job->state != GZIP_JOB_FREE) res = GZipParallel_WriteJob(job);
+	}
+	GZipParallel_Free();
+	if (res) return res;
+
+	Stream_SetU32_LE(&data[0], gzPar.crc32);
+	Stream_SetU32_LE(&data[4], gzPar.size);
+	return Stream_Write(gzPar.dest, data, sizeof(data));
+}
+
+cc_result GZip_MakeParallelStream(struct Stream* stream, struct Stream* underlying, int level) {
+	cc_uint8 header[10] = { 0x1F, 0x8B, 0x08 }; /* GZip header */
+	int i;
+	/* Only one parallel GZip stream can be active at a time */
+	if (gzPar.mutex) return ERR_NOT_SUPPORTED;
+
+	Mem_Set(&gzPar, 0, sizeof(gzPar));
+	gzPar.mutex        = Mutex_Create("GZip jobs");
+	gzPar.workWaitable = Waitable_Create("GZip work");
+	gzPar.doneWaitable = Waitable_Create("GZip done");
+	gzPar.dest  = underlying;
+	gzPar.level = level;
+
+	for (i = 0; i < GZIP_PAR_JOBS; i++) {
+		struct GZipJob* job = &gzPar.jobs[i];
+		job->input     = (cc_uint8*)Mem_TryAlloc(DEFLATE_BLOCK_SIZE + GZIP_PAR_CHUNK_SIZE, 1);
+		job->output    = (cc_uint8*)Mem_TryAlloc(GZIP_PAR_CHUNK_SIZE / 4, 1);
+		job->outputCap = GZIP_PAR_CHUNK_SIZE / 4;
+		if (!job->input || !job->output) { GZipParallel_Free(); return ERR_OUT_OF_MEMORY; }
+	}
+
+	for (i = 0; i < GZIP_PAR_WORKERS; i++) {
+		Thread_Run(&gzPar.workers[i], GZipParallel_WorkerLoop, 64 * 1024, "GZip worker");
+		/* Threading might not be supported at all on this platform */
+		if (!gzPar.workers[i]) { GZipParallel_Free(); return ERR_NOT_SUPPORTED; }
+	}
+
+	/* XFL field: 2 = maximum compression, 4 = fastest compression */
+	if (level == DEFLATE_LEVEL_BEST) header[8] = 2;
+	if (level == DEFLATE_LEVEL_FAST) header[8] = 4;
+	gzPar.res = Stream_Write(underlying, header, sizeof(header));
+
+	Stream_Init(stream);
+	stream->Write = GZipParallel_StreamWrite;
+	stream->Close = GZipParallel_StreamClose;
+	return 0;
+}
+#endif
 #endif
 
 
@@ -33,6 +33,15 @@ cc_result GZipHeader_Read(struct Stream* s, struct GZipHeader* header);
 #define INFLATE_WINDOW_SIZE 0x8000UL
 #define INFLATE_WINDOW_MASK 0x7FFFUL
 
+/* On little endian 64 bit CPUs, a faster decoder is used that refills a 64 bit bit buffer */
+/*  8 bytes at a time, decodes pairs of literals using a multi-symbol lookup table, */
+/*  and copies matches 8+ bytes at a time. Other CPUs use the simpler byte-by-byte decoder. */
+#if defined _M_X64 || defined _M_ARM64 || \
+	((defined __x86_64__ || defined __aarch64__) && defined __BYTE_ORDER__ && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+	#define INFLATE_WIDE_DECODE
+	#define INFLATE_MULTI_BITS 11
+#endif
+
 struct HuffmanTable {
 	cc_int16 fast[1 << INFLATE_FAST_BITS];      /* Fast lookup table for huffman codes */
 	cc_uint16 firstCodewords[INFLATE_MAX_BITS]; /* Starting codeword for each bit length */
@@ -41,6 +50,9 @@ struct HuffmanTable {
 	cc_uint16 values[INFLATE_MAX_LITS];         /* Values/Symbols list */
 };
 
+/* NOTE: On CPUs using INFLATE_WIDE_DECODE, this struct is larger than in 1.3.7 (LitsMulti was added at the end). */
+/*  Plugins that allocate InflateState themselves must be recompiled against this header, */
+/*  otherwise the decoder overruns their memory. Offsets of the other members are unchanged. */
 struct InflateState {
 	cc_uint8 State;
 	cc_bool LastBlock; /* Whether the last DEFLATE block has been encounted in the stream */
@@ -67,6 +79,9 @@ struct InflateState {
 	struct HuffmanTable TableDists;         /* Values represent distances back */
 	cc_uint8 Window[INFLATE_WINDOW_SIZE];    /* Holds circular buffer of recent output data, used for LZ77 */
 	cc_result result;
+#ifdef INFLATE_WIDE_DECODE
+	cc_uint32 LitsMulti[1 << INFLATE_MULTI_BITS]; /* Decodes up to two literals at once */
+#endif
 };
 
 /* Initialises DEFLATE decompressor state to defaults. */
@@ -83,8 +98,20 @@ CC_API void Inflate_MakeStream2(struct Stream* stream, struct InflateState* stat
 #define DEFLATE_BLOCK_SIZE  16384
 #define DEFLATE_BUFFER_SIZE 32768
 #define DEFLATE_OUT_SIZE 8192
-#define DEFLATE_HASH_SIZE 0x1000UL
-#define DEFLATE_HASH_MASK 0x0FFFUL
+#define DEFLATE_HASH_BITS 14
+#define DEFLATE_HASH_SIZE (1UL << DEFLATE_HASH_BITS)
+
+/* Compression level, trading off between speed and compressed size */
+enum DEFLATE_LEVEL { 
+	DEFLATE_LEVEL_FAST,    /* Greedy matching, only briefly searches for matches */
+	DEFLATE_LEVEL_DEFAULT, /* Lazy matching, reasonable balance between speed and compressed size */
+	DEFLATE_LEVEL_BEST,    /* Lazy matching, thoroughly searches for matches */
+	DEFLATE_LEVEL_COUNT
+};
+
+/* NOTE: The layout and size of this struct changed after 1.3.7 (WroteHeader was removed, and the hash table */
+/*  and buffers for dynamic huffman blocks were added). Plugins that allocate DeflateState, GZipState or */
+/*  ZLibState themselves must be recompiled against this header, otherwise the encoder overruns their memory. */
 struct DeflateState {
 	cc_uint32 Bits;         /* Holds bits across byte boundaries */
 	cc_uint32 NumBits;      /* Number of bits in Bits buffer */
@@ -94,8 +121,12 @@ struct DeflateState {
 	cc_uint32 AvailOut;   /* Max number of bytes that can be written to Output buffer */
 	struct Stream* Dest; /* Destination that Output buffer is written to */
 
-	cc_uint16 LitsCodewords[INFLATE_MAX_LITS]; /* Codewords for each value */
-	cc_uint8 LitsLens[INFLATE_MAX_LITS];       /* Bit lengths of each codeword */
+	cc_uint16 LitsCodewords[INFLATE_MAX_LITS];   /* Codewords for each literal/length value */
+	cc_uint8 LitsLens[INFLATE_MAX_LITS];         /* Bit lengths of each literal/length codeword */
+	cc_uint16 DistsCodewords[INFLATE_MAX_DISTS]; /* Codewords for each distance value */
+	cc_uint8 DistsLens[INFLATE_MAX_DISTS];       /* Bit lengths of each distance codeword */
+	cc_uint16 LitsFreqs[INFLATE_MAX_LITS];       /* Number of times each literal/length value occurs in current block */
+	cc_uint16 DistsFreqs[INFLATE_MAX_DISTS];     /* Number of times each distance value occurs in current block */
 	
 	cc_uint8 Input[DEFLATE_BUFFER_SIZE];
 	cc_uint8 Output[DEFLATE_OUT_SIZE];
@@ -103,10 +134,15 @@ struct DeflateState {
 	cc_uint16 Prev[DEFLATE_BUFFER_SIZE];
 	/* NOTE: The largest possible value that can get */
 	/*  stored in Head/Prev is <= DEFLATE_BUFFER_SIZE */
-	cc_bool WroteHeader;
+	cc_uint8 SymLits[DEFLATE_BLOCK_SIZE];  /* Literal value, or (match length - 3), of each symbol in current block */
+	cc_uint16 SymDists[DEFLATE_BLOCK_SIZE]; /* Match distance of each symbol in current block, 0 for literals */
+	int NumSyms, Level;
 };
 /* Compresses input data using DEFLATE, then writes compressed output to another stream. Write only stream. */
 /* DEFLATE compression is pure compressed data, there is no header or footer. */
+/* NOTE: Compression level defaults to DEFLATE_LEVEL_DEFAULT. */
+/*  To use a different level, change state->Level after calling this, but before writing any data. */
+/*  (this also applies to GZip_MakeStream and ZLib_MakeStream, via state->Base.Level) */
 CC_API void Deflate_MakeStream(struct Stream* stream, struct DeflateState* state, struct Stream* underlying);
 
 struct GZipState { struct DeflateState Base; cc_uint32 Crc32, Size; };
@@ -114,6 +150,11 @@ struct GZipState { struct DeflateState Base; cc_uint32 Crc32, Size; };
 /* GZIP compression is GZIP header, followed by DEFLATE compressed data, followed by GZIP footer. */
 CC_API  void GZip_MakeStream(      struct Stream* stream, struct GZipState* state, struct Stream* underlying);
 typedef void (*FP_GZip_MakeStream)(struct Stream* stream, struct GZipState* state, struct Stream* underlying);
+/* Compresses input data using GZIP on multiple threads, then writes compressed output to another stream. Write only stream. */
+/* Output is a regular GZIP stream, but compressing large amounts of data is much faster than GZip_MakeStream. */
+/* NOTE: Only one such stream can be in use at a time. The stream must always be closed, even when writing fails. */
+/* Returns ERR_NOT_SUPPORTED when threading is unavailable (or already in use), in which case use GZip_MakeStream instead. */
+cc_result GZip_MakeParallelStream(struct Stream* stream, struct Stream* underlying, int level);
 
 struct ZLibState { struct DeflateState Base; cc_uint32 Adler32; };
 /* Compresses input data using ZLIB, then writes compressed output to another stream. Write only stream. */
@@ -204,6 +204,308 @@ cc_bool Entity_TouchesAnyWater(struct Entity* e) {
 }
 
 
+/*########################################################################################################################*
+*-------------------------------------------------------Skin cache--------------------------------------------------------*
+*#########################################################################################################################*/
+/* Downloaded skins are cached on disc, so that when a skin is next needed, the request */
+/*  can include its ETag and the server can respond with just '304 Not Modified' */
+/* Each line in etags.txt is "[skin hash] [file slot] [ETag] [skin]", from least to most recently used */
+/* NOTE: The hash only speeds up lookups, since different skins may have the same hash */
+#define SKINCACHE_DIR   "skincache"
+#define SKINCACHE_ETAGS "skincache/etags.txt"
+#ifdef CC_BUILD_LOWMEM
+	#define SKINCACHE_MAX_FILES 128
+	#define SKINLRU_MAX_SKINS   8
+	#define SKINLRU_MAX_BYTES   (256 * 1024)
+#else
+	#define SKINCACHE_MAX_FILES 1024
+	#define SKINLRU_MAX_SKINS   64
+	#define SKINLRU_MAX_BYTES   (16 * 1024 * 1024)
+#endif
+/* Recently decoded skins are reused for this long before being downloaded again */
+#define SKINLRU_MAX_AGE (5 * 60)
+
+static struct StringsBuffer skinETags;
+static cc_uint8 skinSlotsUsed[SKINCACHE_MAX_FILES / 8];
+static cc_bool skinCacheLoaded, skinCacheInvalid, skinCacheDirty;
+
+static void SkinCache_MakeKey(cc_string* key, const cc_string* skin) {
+	String_AppendUInt32(key, Utils_CRC32((const cc_uint8*)skin->buffer, skin->length));
+}
+
+static void SkinCache_MakePath(cc_string* path, int slot) {
+	String_Format1(path, SKINCACHE_DIR "/%i.png", &slot);
+}
+
+/* Parses an entry in etags.txt, returning whether it is valid */
+/* NOTE: ETags never contain spaces, but skin names might */
+static cc_bool SkinCache_ParseEntry(const cc_string* entry, int* slot, cc_string* etag, cc_string* skin) {
+	cc_string key, value, slotStr;
+	String_UNSAFE_Separate(entry,  ' ', &key,     &value);
+	String_UNSAFE_Separate(&value, ' ', &slotStr, &value);
+	String_UNSAFE_Separate(&value, ' ', etag,     skin);
+
+	return Convert_ParseInt(&slotStr, slot) && *slot >= 0 && *slot < SKINCACHE_MAX_FILES 
+		&& etag->length && skin->length;
+}
+
+#define SkinCache_IsUsed(slot)  (skinSlotsUsed[(slot) >> 3] &   (1 << ((slot) & 7)))
+#define SkinCache_SetUsed(slot)  skinSlotsUsed[(slot) >> 3] |=  (1 << ((slot) & 7))
+#define SkinCache_SetUnused(slot) skinSlotsUsed[(slot) >> 3] &= ~(1 << ((slot) & 7))
+
+static cc_bool SkinCache_FilterEntry(const cc_string* entry) {
+	cc_string etag, skin;
+	int slot;
+	/* Skip entries that are invalid or that share a file with an earlier entry */
+	if (!SkinCache_ParseEntry(entry, &slot, &etag, &skin) || SkinCache_IsUsed(slot)) return false;
+
+	SkinCache_SetUsed(slot);
+	return true;
+}
+
+static cc_bool SkinCache_Load(void) {
+	if (skinCacheLoaded) return !skinCacheInvalid;
+	skinCacheLoaded  = true;
+	skinCacheInvalid = Platform_ReadonlyFilesystem || !Utils_EnsureDirectory(SKINCACHE_DIR);
+
+	/* Entries with the same skin hash must not replace each other, so lines are loaded as is */
+	if (!skinCacheInvalid) EntryList_Load(&skinETags, SKINCACHE_ETAGS, '\0', SkinCache_FilterEntry);
+	return !skinCacheInvalid;
+}
+
+static void SkinCache_SaveTask(struct ScheduledTask* task) {
+	if (!skinCacheDirty) return;
+	EntryList_Save(&skinETags, SKINCACHE_ETAGS);
+	skinCacheDirty = false;
+}
+
+/* Returns the index of the entry for the given skin, or -1 if the skin isn't cached */
+static int SkinCache_Find(const cc_string* skin, int* slot, cc_string* etag) {
+	cc_string key; char keyBuffer[STRING_INT_CHARS];
+	cc_string entry, curKey, value, name;
+	int i;
+
+	if (!SkinCache_Load()) return -1;
+	String_InitArray(key, keyBuffer);
+	SkinCache_MakeKey(&key, skin);
+
+	for (i = 0; i < skinETags.count; i++)
+	{
+		entry = StringsBuffer_UNSAFE_Get(&skinETags, i);
+		String_UNSAFE_Separate(&entry, ' ', &curKey, &value);
+		if (!String_Equals(&curKey, &key)) continue;
+
+		if (SkinCache_ParseEntry(&entry, slot, etag, &name) && String_Equals(&name, skin)) return i;
+	}
+	return -1;
+}
+
+/* Returns the ETag of the given skin, or an empty string if it isn't cached on disc */
+static cc_string SkinCache_GetETag(const cc_string* skin) {
+	cc_string path; char pathBuffer[FILENAME_SIZE];
+	cc_filepath raw_path;
+	cc_string etag;
+	int slot;
+
+	if (SkinCache_Find(skin, &slot, &etag) == -1) return String_Empty;
+	String_InitArray(path, pathBuffer);
+	SkinCache_MakePath(&path, slot);
+
+	/* File might have been deleted by the user */
+	Platform_EncodePath(&raw_path, &path);
+	return File_Exists(&raw_path) ? etag : String_Empty;
+}
+
+static void SkinCache_SetEntry(const cc_string* skin, int slot, const cc_string* etag) {
+	cc_string entry; char entryBuffer[STRING_SIZE * 3];
+	String_InitArray(entry, entryBuffer);
+
+	SkinCache_MakeKey(&entry, skin);
+	String_Format3(&entry, " %i %s %s", &slot, etag, skin);
+	StringsBuffer_Add(&skinETags, &entry);
+	skinCacheDirty = true;
+}
+
+/* Marks the given skin as the most recently used cached skin */
+static void SkinCache_Touch(const cc_string* skin) {
+	cc_string etag; char etagBuffer[STRING_SIZE];
+	cc_string tmp;
+	int i, slot;
+
+	i = SkinCache_Find(skin, &slot, &tmp);
+	if (i == -1) return;
+	String_InitArray(etag, etagBuffer);
+	String_AppendString(&etag, &tmp);
+
+	StringsBuffer_Remove(&skinETags, i);
+	SkinCache_SetEntry(skin, slot, &etag);
+}
+
+/* Removes the given skin from the cache (e.g. because its file is missing) */
+static void SkinCache_Remove(const cc_string* skin) {
+	cc_string etag;
+	int i, slot;
+
+	i = SkinCache_Find(skin, &slot, &etag);
+	if (i == -1) return;
+
+	StringsBuffer_Remove(&skinETags, i);
+	SkinCache_SetUnused(slot);
+	skinCacheDirty = true;
+}
+
+/* Returns a slot for a newly cached skin, evicting the least recently used skin if needed */
+static int SkinCache_AllocSlot(void) {
+	cc_string entry, etag, skin;
+	int i, slot;
+
+	for (i = 0; i < SKINCACHE_MAX_FILES && skinETags.count < SKINCACHE_MAX_FILES; i++)
+	{
+		if (!SkinCache_IsUsed(i)) { SkinCache_SetUsed(i); return i; }
+	}
+	if (!skinETags.count) return 0;
+
+	/* Reuse the file of the least recently used skin */
+	entry = StringsBuffer_UNSAFE_Get(&skinETags, 0);
+	if (!SkinCache_ParseEntry(&entry, &slot, &etag, &skin)) slot = 0;
+	StringsBuffer_Remove(&skinETags, 0);
+	return slot;
+}
+
+/* Writes a downloaded skin to the cache */
+static void SkinCache_Store(const cc_string* skin, struct HttpRequest* req) {
+	cc_string path; char pathBuffer[FILENAME_SIZE];
+	cc_string etag, oldETag;
+	cc_result res;
+	int i, slot;
+
+	/* Skins without an ETag can't be revalidated, so don't bother caching them */
+	etag = String_FromRawArray(req->etag);
+	if (!etag.length || !SkinCache_Load()) return;
+
+	i = SkinCache_Find(skin, &slot, &oldETag);
+	if (i >= 0) {
+		StringsBuffer_Remove(&skinETags, i);
+	} else {
+		slot = SkinCache_AllocSlot();
+	}
+
+	String_InitArray(path, pathBuffer);
+	SkinCache_MakePath(&path, slot);
+
+	res = Stream_WriteAllTo(&path, req->data, req->size);
+	if (res) {
+		Logger_SysWarn2(res, "caching skin", skin);
+		SkinCache_SetUnused(slot); return;
+	}
+	SkinCache_SetEntry(skin, slot, &etag);
+}
+
+/* Opens the file for the given cached skin */
+static cc_result SkinCache_Open(const cc_string* skin, struct Stream* stream) {
+	cc_string path; char pathBuffer[FILENAME_SIZE];
+	cc_string etag;
+	int slot;
+
+	if (SkinCache_Find(skin, &slot, &etag) == -1) return ReturnCode_FileNotFound;
+	String_InitArray(path, pathBuffer);
+	SkinCache_MakePath(&path, slot);
+	return Stream_OpenFile(stream, &path);
+}
+
+
+/* Recently decoded skins are kept in memory, so that e.g. when reconnecting to a server */
+/*  or when a player with a recently seen skin spawns, the skin doesn't need to be fetched again */
+static struct SkinLRUEntry {
+	char skin[STRING_SIZE];
+	struct Bitmap bmp; /* NOTE: Stored before the hat is cleared */
+	float uScale, vScale;
+	double added, lastUsed;
+} skinLRU[SKINLRU_MAX_SKINS];
+static int skinLRUBytes;
+
+static void SkinLRU_Free(struct SkinLRUEntry* e) {
+	skinLRUBytes -= Bitmap_DataSize(e->bmp.width, e->bmp.height);
+	Mem_Free(e->bmp.scan0);
+	e->bmp.scan0 = NULL;
+	e->skin[0]   = '\0';
+}
+
+static struct SkinLRUEntry* SkinLRU_Find(const cc_string* skin) {
+	struct SkinLRUEntry* e;
+	cc_string eSkin;
+	int i;
+
+	for (i = 0; i < SKINLRU_MAX_SKINS; i++)
+	{
+		e = &skinLRU[i];
+		if (!e->bmp.scan0) continue;
+
+		eSkin = String_FromRawArray(e->skin);
+		if (!String_Equals(&eSkin, skin)) continue;
+
+		/* Ensure changed skins are eventually fetched again */
+		if (Game.Time - e->added > SKINLRU_MAX_AGE) { SkinLRU_Free(e); return NULL; }
+		e->lastUsed = Game.Time;
+		return e;
+	}
+	return NULL;
+}
+
+/* Returns the least recently used skin, or a free entry if there is one and allowFree is set */
+static struct SkinLRUEntry* SkinLRU_Oldest(cc_bool allowFree) {
+	struct SkinLRUEntry* oldest = NULL;
+	int i;
+
+	for (i = 0; i < SKINLRU_MAX_SKINS; i++)
+	{
+		if (!skinLRU[i].bmp.scan0) {
+			if (allowFree) return &skinLRU[i];
+			continue;
+		}
+		if (!oldest || skinLRU[i].lastUsed < oldest->lastUsed) oldest = &skinLRU[i];
+	}
+	return oldest;
+}
+
+static void SkinLRU_Add(const cc_string* skin, struct Bitmap* bmp, float uScale, float vScale) {
+	struct SkinLRUEntry* e;
+	int size = Bitmap_DataSize(bmp->width, bmp->height);
+	/* Don't let one large skin push out many other skins */
+	if (size > SKINLRU_MAX_BYTES / 4 || skin->length >= STRING_SIZE) return;
+
+	if ((e = SkinLRU_Find(skin))) SkinLRU_Free(e);
+	while (skinLRUBytes + size > SKINLRU_MAX_BYTES)
+	{
+		SkinLRU_Free(SkinLRU_Oldest(false));
+	}
+
+	e = SkinLRU_Oldest(true);
+	if (e->bmp.scan0) SkinLRU_Free(e);
+	e->bmp.scan0 = (BitmapCol*)Mem_TryAlloc(size, 1);
+	if (!e->bmp.scan0) return;
+
+	Mem_Copy(e->bmp.scan0, bmp->scan0, size);
+	e->bmp.width  = bmp->width;
+	e->bmp.height = bmp->height;
+	e->uScale     = uScale;
+	e->vScale     = vScale;
+	e->added      = Game.Time;
+	e->lastUsed   = Game.Time;
+
+	String_CopyToRawArray(e->skin, skin);
+	skinLRUBytes += size;
+}
+
+static void SkinLRU_Clear(void) {
+	int i;
+	for (i = 0; i < SKINLRU_MAX_SKINS; i++)
+	{
+		if (skinLRU[i].bmp.scan0) SkinLRU_Free(&skinLRU[i]);
+	}
+}
+
+
 /*########################################################################################################################*
 *------------------------------------------------------Entity skins-------------------------------------------------------*
 *#########################################################################################################################*/
@@ -222,11 +524,17 @@ static void Entity_ResetSkin(struct Entity* e) {
 	e->vScale 		= 1.0f;
 }
 
+static cc_bool ApplyRecentSkin(struct Entity* e, const cc_string* skin);
+
+static void RequestSkin(struct Entity* e, const cc_string* skin, const cc_string* etag) {
+	cc_uint8 flags = e == &LocalPlayer_Instances[0].Base ? HTTP_FLAG_NOCACHE : 0;
+	e->_skinReqID     = Http_AsyncGetSkinEx(skin, flags, etag);
+	e->SkinFetchState = SKIN_FETCH_DOWNLOADING;
+}
+
 static void CheckSkin_Unchecked(struct Entity* e) {
-	cc_string skin, eSkin;
+	cc_string skin, eSkin, etag;
 	struct Entity* other;
-	cc_uint8 flags;
-	cc_result res;
 	int i;
 
 	skin = String_FromRawArray(e->SkinRaw);
@@ -250,9 +558,11 @@ static void CheckSkin_Unchecked(struct Entity* e) {
 		return;
 	}
 
-	flags = e == &LocalPlayer_Instances[0].Base ? HTTP_FLAG_NOCACHE : 0;
-	e->_skinReqID     = Http_AsyncGetSkin(&skin, flags);
-	e->SkinFetchState = SKIN_FETCH_DOWNLOADING;
+	/* Local player's skin is always revalidated, since the user may have just changed it */
+	if (e != &LocalPlayer_Instances[0].Base && ApplyRecentSkin(e, &skin)) return;
+
+	etag = SkinCache_GetETag(&skin);
+	RequestSkin(e, &skin, &etag);
 }
 
 /* Copies or resets skin data for all entity with same skin */
@@ -337,12 +647,8 @@ static cc_result EnsurePow2Skin(struct Entity* e, struct Bitmap* bmp) {
 	return 0;
 }
 
-static cc_result ApplySkin(struct Entity* e, struct Bitmap* bmp, struct Stream* src, cc_string* skin) {
-	cc_result res;
-	if ((res = Png_Decode(bmp, src))) return res;
-
-	Gfx_DeleteTexture(&e->TextureId);
-	if ((res = EnsurePow2Skin(e, bmp))) return res;
+/* Creates the texture for the skin, then shares it with all entities using the same skin */
+static void UploadSkin(struct Entity* e, struct Bitmap* bmp, const cc_string* skin) {
 	e->SkinType = Utils_CalcSkinType(bmp);
 
 	if (!Gfx_CheckTextureSize(bmp->width, bmp->height, 0)) {
@@ -354,9 +660,40 @@ static cc_result ApplySkin(struct Entity* e, struct Bitmap* bmp, struct Stream*
 		e->TextureId = Gfx_CreateTexture(bmp, TEXTURE_FLAG_MANAGED, false);
 		Entity_SetSkinAll(e, false);
 	}
+}
+
+static cc_result ApplySkin(struct Entity* e, struct Bitmap* bmp, struct Stream* src, cc_string* skin) {
+	cc_result res;
+	if ((res = Png_Decode(bmp, src))) return res;
+
+	Gfx_DeleteTexture(&e->TextureId);
+	if ((res = EnsurePow2Skin(e, bmp))) return res;
+
+	SkinLRU_Add(skin, bmp, e->uScale, e->vScale);
+	UploadSkin(e, bmp, skin);
 	return 0;
 }
 
+/* Applies a recently decoded skin, returning false if the skin wasn't decoded recently */
+static cc_bool ApplyRecentSkin(struct Entity* e, const cc_string* skin) {
+	struct SkinLRUEntry* recent = SkinLRU_Find(skin);
+	struct Bitmap bmp;
+	if (!recent) return false;
+
+	/* Copy the bitmap, as the hat might be cleared */
+	Bitmap_TryAllocate(&bmp, recent->bmp.width, recent->bmp.height);
+	if (!bmp.scan0) return false;
+	Mem_Copy(bmp.scan0, recent->bmp.scan0, Bitmap_DataSize(bmp.width, bmp.height));
+
+	e->uScale = recent->uScale;
+	e->vScale = recent->vScale;
+	e->SkinFetchState = SKIN_FETCH_COMPLETED;
+
+	UploadSkin(e, &bmp, skin);
+	Mem_Free(bmp.scan0);
+	return true;
+}
+
 static void LogInvalidSkin(cc_result res, const cc_string* skin, const cc_uint8* data, int size) {
 	cc_string msg; char msgBuffer[256];
 	String_InitArray(msg, msgBuffer);
@@ -370,6 +707,34 @@ static void LogInvalidSkin(cc_result res, const cc_string* skin, const cc_uint8*
 	Logger_WarnFunc(&msg);
 }
 
+/* Applies the skin from the cache, after the server said it hasn't changed */
+static void CheckSkin_NotModified(struct Entity* e, cc_string* skin) {
+	struct Stream stream, buffered;
+	cc_uint8 buffer[4096];
+	struct Bitmap bmp;
+	cc_result res;
+
+	res = SkinCache_Open(skin, &stream);
+	if (res) {
+		if (res != ReturnCode_FileNotFound) Logger_SysWarn2(res, "opening cached skin", skin);
+		/* Cached skin is gone, so download the whole skin again */
+		SkinCache_Remove(skin);
+		RequestSkin(e, skin, &String_Empty); return;
+	}
+
+	SkinCache_Touch(skin);
+	Stream_ReadonlyBuffered(&buffered, &stream, buffer, sizeof(buffer));
+
+	if ((res = ApplySkin(e, &bmp, &buffered, skin))) {
+		Logger_SysWarn2(res, "decoding cached skin", skin);
+		SkinCache_Remove(skin);
+	}
+
+	Mem_Free(bmp.scan0);
+	/* No point logging error for closing readonly file */
+	(void)stream.Close(&stream);
+}
+
 static void CheckSkin_Downloading(struct Entity* e) {
 	struct HttpRequest item;
 	struct Stream mem;
@@ -379,13 +744,19 @@ static void CheckSkin_Downloading(struct Entity* e) {
 
 	if (!Http_GetResult(e->_skinReqID, &item)) return;
 	Entity_SetSkinAll(e, true);
+	skin = String_FromRawArray(e->SkinRaw);
+
+	if (item.statusCode == 304) {
+		CheckSkin_NotModified(e, &skin); return;
+	}
 	if (!item.success) return;
 
 	Stream_ReadonlyMemory(&mem, item.data, item.size);
-	skin = String_FromRawArray(e->SkinRaw);
 
 	if ((res = ApplySkin(e, &bmp, &mem, &skin))) {
 		LogInvalidSkin(res, &skin, item.data, item.size);
+	} else {
+		SkinCache_Store(&skin, &item);
 	}
 
 	Mem_Free(bmp.scan0);
@@ -1200,6 +1571,7 @@ static void Entities_Init(void) {
 	}
 	Entities.CurPlayer = &LocalPlayer_Instances[0];
 	LocalPlayer_HookBinds();
+	ScheduledTask_Add(10, SkinCache_SaveTask);
 }
 
 static void Entities_Free(void) {
@@ -1209,6 +1581,9 @@ static void Entities_Free(void) {
 		Entities_Remove(i);
 	}
 	sources_head = NULL;
+
+	SkinCache_SaveTask(NULL);
+	SkinLRU_Clear();
 }
 
 struct IGameComponent Entities_Component = {
@@ -139,5 +139,9 @@ enum CC_ERRORS {
 	PNG_ERR_16BITSAMPLES = 0xCCDED071UL, /* Image uses 16 bit samples, which is unimplemented */
 	ERR_NO_NETWORKING    = 0xCCDED072UL, /* No working network connection */
 	ERR_NON_WRITABLE_FS  = 0xCCDED073UL, /* No writable filesystem detected */
+	SNAP_ERR_IDENTIFIER  = 0xCCDED074UL, /* Snapshot bytes #1-#4 aren't "CCSN" */
+	SNAP_ERR_VERSION     = 0xCCDED075UL, /* Snapshot format version isn't supported */
+	SNAP_ERR_LAYOUT      = 0xCCDED076UL, /* Snapshot header offsets/dimensions are invalid */
+	DELTA_ERR_CHUNK      = 0xCCDED077UL, /* Delta file refers to a chunk outside the map */
 };
 #endif
@@ -17,11 +17,14 @@
 #include "TexturePack.h"
 #include "Utils.h"
 #include "Audio.h"
+#include "Options.h"
 
 #ifdef CC_BUILD_FILESYSTEM
 static struct LocationUpdate* spawn_point;
 static struct MapImporter* imp_head;
 static struct MapImporter* imp_tail;
+static cc_bool Delta_Apply(const cc_string* path);
+static void Autosave_SetPath(const cc_string* path, cc_bool full);
 
 
 /*########################################################################################################################*
@@ -68,6 +71,7 @@ cc_result Map_LoadFrom(const cc_string* path) {
 	struct MapImporter* imp;
 	struct Stream stream;
 	cc_filepath raw_path;
+	cc_bool hasUuid, deltaOk = true;
 	cc_result res;
 
 	Game_Reset();
@@ -87,8 +91,13 @@ cc_result Map_LoadFrom(const cc_string* path) {
 	/* No point logging error for closing readonly file */
 	(void)stream.Close(&stream);
 	if (res) Logger_IOWarn2(res, "decoding", &raw_path);
+	/* Deltas are matched against the UUID read from the map file */
+	if (!res) deltaOk = Delta_Apply(path);
+	hasUuid = World_HasUuid();
 
 	World_SetNewMap(World.Blocks, World.Width, World.Height, World.Length);
+	/* Maps without a UUID are given a new one, which must be saved to the map file before deltas can refer to it */
+	if (!res) Autosave_SetPath(path, !hasUuid || !deltaOk);
 	if (!spawn_point) LocalPlayer_CalcDefaultSpawn(Entities.CurPlayer, &update);
 	LocalPlayers_MoveToSpawn(&update);
 
@@ -320,10 +329,11 @@ enum NbtTagType {
 	NBT_F64, NBT_I8S, NBT_STR, NBT_LIST, NBT_DICT
 };
 
-#define NBT_SMALL_SIZE  STRING_SIZE
 #define NBT_STRING_SIZE STRING_SIZE
+#define NBT_BUFFER_SIZE (64 * 1024)
+/* Byte arrays larger than this are read straight into their own allocation */
+#define NBT_INLINE_SIZE (NBT_BUFFER_SIZE / 4)
 
-#define NbtTag_IsSmall(tag) ((tag)->dataSize <= NBT_SMALL_SIZE)
 #define IsTag(tag, tagName) (String_CaselessEqualsConst(&tag->name, tagName))
 struct NbtTag;
 
@@ -340,15 +350,25 @@ struct NbtTag {
 		cc_int32  i32;
 		cc_uint32 u32;
 		float     f32;
-		cc_uint8  small[NBT_SMALL_SIZE];
-		cc_uint8* big; /* malloc for big byte arrays */
 		struct { cc_string text; char buffer[STRING_SIZE * 2]; } str;
 	} value;
+	/* Data for byte arrays. Points into the reader's buffer, unless ownsData is true */
+	/*  (in which case it was allocated and will be freed after the callback) */
+	cc_uint8* data;
+	cc_bool ownsData;
 	char _nameBuffer[NBT_STRING_SIZE];
 	cc_result result;
 	int listIndex;
 };
 
+/* Reads NBT data from a memory buffer, which is refilled from the source stream when necessary */
+struct NbtReader {
+	struct Stream* source; /* NULL when buffer contains all of the data */
+	cc_uint8* base;
+	cc_uint8* cur;
+	cc_uint8* end;
+};
+
 static cc_uint8 NbtTag_U8(struct NbtTag* tag) {
 	if (tag->type == NBT_I8) return tag->value.u8; 
 	
@@ -392,7 +412,7 @@ static cc_uint8* NbtTag_U8_Array(struct NbtTag* tag, int minSize) {
 	if (tag->type != NBT_I8S)    { tag->result = NBT_ERR_EXPECTED_ARR;  return NULL; }
 	if (tag->dataSize < minSize) { tag->result = NBT_ERR_ARR_TOO_SMALL; return NULL; }
 
-	return NbtTag_IsSmall(tag) ? tag->value.small : tag->value.big;
+	return tag->data;
 }
 
 static cc_string NbtTag_String(struct NbtTag* tag) {
@@ -402,27 +422,60 @@ static cc_string NbtTag_String(struct NbtTag* tag) {
 	return String_Empty;
 }
 
-static cc_result Nbt_ReadString(struct Stream* stream, cc_string* str) {
-	cc_uint8 buffer[NBT_STRING_SIZE * 4];
+/* Ensures at least 'count' bytes of data are available in the buffer */
+static cc_result NbtReader_Ensure(struct NbtReader* r, cc_uint32 count) {
+	cc_uint32 left = (cc_uint32)(r->end - r->cur), read;
+	cc_result res;
+
+	if (left >= count) return 0;
+	if (!r->source)    return ERR_END_OF_STREAM;
+
+	/* Move leftover data to start of buffer, then fill up the rest of the buffer */
+	Mem_Move(r->base, r->cur, left);
+	r->cur = r->base;
+	r->end = r->base + left;
+
+	while (left < count) {
+		res = r->source->Read(r->source, r->end, NBT_BUFFER_SIZE - left, &read);
+		if (res)   return res;
+		if (!read) return ERR_END_OF_STREAM;
+
+		r->end += read; left += read;
+	}
+	return 0;
+}
+
+static cc_result NbtReader_ReadArray(struct NbtReader* r, cc_uint8* dst, cc_uint32 count) {
+	cc_uint32 left = min(count, (cc_uint32)(r->end - r->cur));
+	Mem_Copy(dst, r->cur, left);
+	r->cur += left;
+
+	if (left == count) return 0;
+	if (!r->source)    return ERR_END_OF_STREAM;
+	/* Read the rest straight from the source (e.g. inflate directly into destination) */
+	return Stream_Read(r->source, dst + left, count - left);
+}
+
+static cc_result Nbt_ReadString(struct NbtReader* r, cc_string* str) {
 	int len;
 	cc_result res;
 
-	if ((res = Stream_Read(stream, buffer, 2)))   return res;
-	len = Stream_GetU16_BE(buffer);
+	if ((res = NbtReader_Ensure(r, 2))) return res;
+	len = Stream_GetU16_BE(r->cur);
 
-	if (len > Array_Elems(buffer)) return CW_ERR_STRING_LEN;
-	if ((res = Stream_Read(stream, buffer, len))) return res;
+	if (len > NBT_STRING_SIZE * 4) return CW_ERR_STRING_LEN;
+	if ((res = NbtReader_Ensure(r, 2 + len))) return res;
 
-	String_AppendUtf8(str, buffer, len);
+	String_AppendUtf8(str, r->cur + 2, len);
+	r->cur += 2 + len;
 	return 0;
 }
 
 typedef void (*Nbt_Callback)(struct NbtTag* tag);
-static cc_result Nbt_ReadTag(cc_uint8 typeId, cc_bool readTagName, struct Stream* stream, 
+static cc_result Nbt_ReadTag(cc_uint8 typeId, cc_bool readTagName, struct NbtReader* r, 
 							struct NbtTag* parent, Nbt_Callback callback, int listIndex) {
 	struct NbtTag tag;
 	cc_uint8 childType;
-	cc_uint8 tmp[5];	
 	cc_result res;
 	cc_uint32 i, count;
 	
@@ -431,65 +484,80 @@ static cc_result Nbt_ReadTag(cc_uint8 typeId, cc_bool readTagName, struct Stream
 	tag.parent    = parent;
 	tag.dataSize  = 0;
 	tag.listIndex = listIndex;
+	tag.data      = NULL;
+	tag.ownsData  = false;
 	String_InitArray(tag.name, tag._nameBuffer);
 
 	if (readTagName) {
-		res = Nbt_ReadString(stream, &tag.name);
+		res = Nbt_ReadString(r, &tag.name);
 		if (res) return res;
 	}
 
 	switch (typeId) {
 	case NBT_I8:
-		res = stream->ReadU8(stream, &tag.value.u8);
+		if ((res = NbtReader_Ensure(r, 1))) break;
+		tag.value.u8 = *r->cur++;
 		break;
 	case NBT_I16:
-		res = Stream_Read(stream, tmp, 2);
-		tag.value.u16 = Stream_GetU16_BE(tmp);
+		if ((res = NbtReader_Ensure(r, 2))) break;
+		tag.value.u16 = Stream_GetU16_BE(r->cur);
+		r->cur += 2;
 		break;
 	case NBT_I32:
 	case NBT_F32:
-		res = Stream_ReadU32_BE(stream, &tag.value.u32);
+		if ((res = NbtReader_Ensure(r, 4))) break;
+		tag.value.u32 = Stream_GetU32_BE(r->cur);
+		r->cur += 4;
 		break;
 	case NBT_I64:
 	case NBT_F64:
-		res = stream->Skip(stream, 8);
+		if ((res = NbtReader_Ensure(r, 8))) break;
+		r->cur += 8;
 		break; /* (8) data */
 
 	case NBT_I8S:
-		if ((res = Stream_ReadU32_BE(stream, &tag.dataSize))) break;
-
-		if (NbtTag_IsSmall(&tag)) {
-			res = Stream_Read(stream, tag.value.small, tag.dataSize);
+		if ((res = NbtReader_Ensure(r, 4))) break;
+		tag.dataSize = Stream_GetU32_BE(r->cur);
+		r->cur += 4;
+
+		if (tag.dataSize <= NBT_INLINE_SIZE) {
+			/* Small arrays are just referenced directly in the buffer */
+			if ((res = NbtReader_Ensure(r, tag.dataSize))) break;
+			tag.data = r->cur;
+			r->cur  += tag.dataSize;
 		} else {
-			tag.value.big = (cc_uint8*)Mem_TryAlloc(tag.dataSize, 1);
-			if (!tag.value.big) return ERR_OUT_OF_MEMORY;
+			tag.data = (cc_uint8*)Mem_TryAlloc(tag.dataSize, 1);
+			if (!tag.data) return ERR_OUT_OF_MEMORY;
+			tag.ownsData = true;
 
-			res = Stream_Read(stream, tag.value.big, tag.dataSize);
-			if (res) Mem_Free(tag.value.big);
+			res = NbtReader_ReadArray(r, tag.data, tag.dataSize);
+			if (res) Mem_Free(tag.data);
 		}
 		break;
 	case NBT_STR:
 		String_InitArray(tag.value.str.text, tag.value.str.buffer);
-		res = Nbt_ReadString(stream, &tag.value.str.text);
+		res = Nbt_ReadString(r, &tag.value.str.text);
 		break;
 
 	case NBT_LIST:
-		if ((res = Stream_Read(stream, tmp, 5))) break;
-		childType = tmp[0];
-		count = Stream_GetU32_BE(&tmp[1]);
+		if ((res = NbtReader_Ensure(r, 5))) break;
+		childType = r->cur[0];
+		count = Stream_GetU32_BE(&r->cur[1]);
+		r->cur += 5;
 
 		for (i = 0; i < count; i++) {
-			res = Nbt_ReadTag(childType, false, stream, &tag, callback, i);
+			res = Nbt_ReadTag(childType, false, r, &tag, callback, i);
 			if (res) break;
 		}
 		break;
 
 	case NBT_DICT:
 		for (;;) {
-			if ((res = stream->ReadU8(stream, &childType))) break;
+			if ((res = NbtReader_Ensure(r, 1))) break;
+			childType = *r->cur++;
 			if (childType == NBT_END) break;
 
-			res = Nbt_ReadTag(childType, true, stream, &tag, callback, 0);
+			res = Nbt_ReadTag(childType, true, r, &tag, callback, 0);
 			if (res) break;
 		}
 		break;
@@ -500,37 +568,54 @@ static cc_result Nbt_ReadTag(cc_uint8 typeId, cc_bool readTagName, struct Stream
 	if (res) return res;
 	tag.result = 0;
 	callback(&tag);
-	/* NOTE: callback must set DataBig to NULL, if doesn't want it to be freed */
-	if (!NbtTag_IsSmall(&tag)) Mem_Free(tag.value.big);
+	/* NOTE: callback must use Nbt_TakeArray, if it doesn't want data to be freed */
+	if (tag.ownsData) Mem_Free(tag.data);
 	return tag.result;
 }
 
 
 static BlockRaw* Nbt_TakeArray(struct NbtTag* tag, const char* type) {
 	BlockRaw* ptr;
-	if (NbtTag_IsSmall(tag)) {
-		/* Small data is stored inline in tha tag, so need to copy it out */
+	if (!tag->ownsData) {
+		/* Small data just points into the reader's buffer, so need to copy it out */
 		ptr = (BlockRaw*)Mem_Alloc(tag->dataSize, 1, type);
-		Mem_Copy(ptr, tag->value.small, tag->dataSize);
+		Mem_Copy(ptr, tag->data, tag->dataSize);
 	} else {
-		ptr = tag->value.big;
-		tag->value.big = NULL; /* So Nbt_ReadTag doesn't call Mem_Free on the array */
+		ptr = tag->data;
+		tag->ownsData = false; /* So Nbt_ReadTag doesn't call Mem_Free on the array */
 	}
 	return ptr;
 }
 
+/* Reads the root compound tag from uncompressed NBT data */
+static cc_result Nbt_ReadRoot(struct NbtReader* r, Nbt_Callback callback) {
+	cc_result res;
+
+	if ((res = NbtReader_Ensure(r, 1))) return res;
+	if (*r->cur++ != NBT_DICT) return CW_ERR_ROOT_TAG;
+	return Nbt_ReadTag(NBT_DICT, true, r, NULL, callback, 0);
+}
+
 static cc_result Nbt_Read(struct Stream* stream, Nbt_Callback callback) {
 	struct Stream compStream;
 	struct InflateState state;
+	struct NbtReader reader;
 	cc_result res;
-	cc_uint8 tag;
 
 	Inflate_MakeStream2(&compStream, &state, stream);
 	if ((res = Map_SkipGZipHeader(stream))) return res;
-	if ((res = compStream.ReadU8(&compStream, &tag))) return res;
 
-	if (tag != NBT_DICT) return CW_ERR_ROOT_TAG;
-	return Nbt_ReadTag(NBT_DICT, true, &compStream, NULL, callback, 0);
+	reader.base = (cc_uint8*)Mem_TryAlloc(NBT_BUFFER_SIZE, 1);
+	if (!reader.base) return ERR_OUT_OF_MEMORY;
+
+	/* Decompress into the buffer in large chunks, instead of pulling each tag through the stream */
+	reader.source = &compStream;
+	reader.cur    = reader.base;
+	reader.end    = reader.base;
+
+	res = Nbt_ReadRoot(&reader, callback);
+	Mem_Free(reader.base);
+	return res;
 }
 
 
@@ -665,7 +750,7 @@ static void Cw_Callback_1(struct NbtTag* tag) {
 		if (tag->dataSize != WORLD_UUID_LEN) {
 			tag->result = CW_ERR_UUID_LEN;
 		} else {
-			Mem_Copy(World.Uuid, tag->value.small, WORLD_UUID_LEN);
+			Mem_Copy(World.Uuid, tag->data, WORLD_UUID_LEN);
 		}
 		return;
 	}
@@ -1574,7 +1659,8 @@ static cc_result Cw_WriteBockDef(struct Stream* stream, int b) {
 	return Stream_Write(stream, buffer, (int)(cur - buffer));
 }
 
-cc_result Cw_Save(struct Stream* stream) {
+/* Writes the ClassicWorld NBT tags, optionally omitting the block arrays */
+static cc_result Cw_WriteWorld(struct Stream* stream, cc_bool writeBlocks) {
 	struct LocalPlayer* p = Entities.CurPlayer;
 	cc_uint8 buffer[2048];
 	cc_uint8* cur;
@@ -1604,13 +1690,18 @@ cc_result Cw_Save(struct Stream* stream) {
 		cur  = Nbt_WriteUInt8(cur,  "H", Math_Deg2Packed(p->SpawnYaw));
 		cur  = Nbt_WriteUInt8(cur,  "P", Math_Deg2Packed(p->SpawnPitch));
 	} *cur++ = NBT_END;
-	cur = Nbt_WriteArray(cur, "BlockArray", World.Volume);
-
 	if ((res = Stream_Write(stream, buffer, (int)(cur - buffer)))) return res;
-	if ((res = Stream_Write(stream, World.Blocks, World.Volume)))  return res;
+
+	if (writeBlocks) {
+		cur = buffer;
+		cur = Nbt_WriteArray(cur, "BlockArray", World.Volume);
+
+		if ((res = Stream_Write(stream, buffer, (int)(cur - buffer)))) return res;
+		if ((res = Stream_Write(stream, World.Blocks, World.Volume)))  return res;
+	}
 
 #ifdef EXTENDED_BLOCKS
-	if (World.Blocks != World.Blocks2) {
+	if (writeBlocks && World.Blocks != World.Blocks2) {
 		cur = buffer;
 		cur = Nbt_WriteArray(cur, "BlockArray2", World.Volume);
 
@@ -1681,6 +1772,10 @@ cc_result Cw_Save(struct Stream* stream) {
 	return Stream_Write(stream, cw_end, sizeof(cw_end));
 }
 
+cc_result Cw_Save(struct Stream* stream) {
+	return Cw_WriteWorld(stream, true);
+}
+
 
 /*########################################################################################################################*
 *---------------------------------------------------Schematic export------------------------------------------------------*
@@ -1860,6 +1955,470 @@ cc_result Dat_Save(struct Stream* stream) {
 }
 
 
+/*########################################################################################################################*
+*-----------------------------------------------ClassiCube snapshot format------------------------------------------------*
+*#########################################################################################################################*/
+#define SNAP_VERSION     1
+#define SNAP_HEADER_SIZE 32
+#define SNAP_ALIGNMENT   4096
+#define SNAP_MAX_META    (16 * 1024 * 1024)
+#define Snapshot_Align(offset) (((offset) + (SNAP_ALIGNMENT - 1)) & ~(SNAP_ALIGNMENT - 1))
+/* ClassiCube snapshot is an uncompressed native map format, intended for quick saving/loading.
+   Block arrays are stored raw and page aligned, so they could also be memory mapped directly.
+	U8[4] "Identifier"    (must be "CCSN")
+	U16   "Version"       (only '1' supported)
+	U16   "Reserved"
+	U16   "Width", "Height", "Length"
+	U16   "Reserved"
+	U32   "MetadataSize"
+	U32   "BlocksOffset"  (multiple of 4096)
+	U32   "Blocks2Offset" (multiple of 4096, or 0 if no upper 8 bits array)
+	U32   "Reserved"
+	U8*   "Metadata"      (uncompressed ClassicWorld NBT, but without BlockArray/BlockArray2)
+	U8*   "Blocks", "Blocks2"
+}*/
+
+static cc_result Snapshot_ReadMetadata(struct Stream* stream, cc_uint32 size) {
+	struct NbtReader reader;
+	cc_uint8* data;
+	cc_result res;
+
+	if (size > SNAP_MAX_META) return SNAP_ERR_LAYOUT;
+	data = (cc_uint8*)Mem_TryAlloc(size, 1);
+	if (!data) return ERR_OUT_OF_MEMORY;
+
+	/* Reading metadata in one go avoids many tiny file reads when parsing the NBT tags */
+	if (!(res = Stream_Read(stream, data, size))) {
+		reader.source = NULL;
+		reader.base   = data;
+		reader.cur    = data;
+		reader.end    = data + size;
+		res = Nbt_ReadRoot(&reader, Cw_Callback);
+	}
+	Mem_Free(data);
+	return res;
+}
+
+static cc_result Snapshot_ReadArray(struct Stream* stream, cc_uint32* pos, cc_uint32 offset, BlockRaw** blocks) {
+	cc_result res;
+	if (offset < *pos || (offset & (SNAP_ALIGNMENT - 1))) return SNAP_ERR_LAYOUT;
+	if ((res = stream->Skip(stream, offset - *pos))) return res;
+
+	*blocks = (BlockRaw*)Mem_TryAlloc(World.Volume, 1);
+	if (!(*blocks)) return ERR_OUT_OF_MEMORY;
+
+	*pos = offset + World.Volume;
+	return Stream_Read(stream, *blocks, World.Volume);
+}
+
+/* Imports a world from a .ccsnap ClassiCube snapshot file */
+static cc_result Snapshot_Load(struct Stream* stream) {
+	cc_uint8 header[SNAP_HEADER_SIZE];
+	cc_uint32 metaSize, offset, offset2, pos;
+	int width, height, length;
+	cc_result res;
+
+	if ((res = Stream_Read(stream, header, sizeof(header)))) return res;
+	if (!Mem_Equal(header, "CCSN", 4))               return SNAP_ERR_IDENTIFIER;
+	if (Stream_GetU16_LE(&header[4]) != SNAP_VERSION) return SNAP_ERR_VERSION;
+
+	width    = Stream_GetU16_LE(&header[8]);
+	height   = Stream_GetU16_LE(&header[10]);
+	length   = Stream_GetU16_LE(&header[12]);
+	metaSize = Stream_GetU32_LE(&header[16]);
+	offset   = Stream_GetU32_LE(&header[20]);
+	offset2  = Stream_GetU32_LE(&header[24]);
+
+	if ((res = Snapshot_ReadMetadata(stream, metaSize))) return res;
+	/* Header dimensions are authoritative, since block arrays are laid out based on them */
+	World.Width  = width; World.Height = height; World.Length = length;
+	World.Volume = width * height * length;
+	pos = SNAP_HEADER_SIZE + metaSize;
+
+	if ((res = Snapshot_ReadArray(stream, &pos, offset, &World.Blocks))) return res;
+	if (!offset2) return 0;
+
+#ifdef EXTENDED_BLOCKS
+	{
+		BlockRaw* blocks2 = NULL;
+		res = Snapshot_ReadArray(stream, &pos, offset2, &blocks2);
+		if (blocks2) World_SetMapUpper(blocks2);
+	}
+#endif
+	return res;
+}
+
+static cc_result Snapshot_WritePadding(struct Stream* stream, cc_uint32* pos) {
+	static const cc_uint8 zeroes[SNAP_ALIGNMENT] = { 0 };
+	cc_uint32 end = Snapshot_Align(*pos);
+	cc_result res = Stream_Write(stream, zeroes, end - *pos);
+
+	*pos = end;
+	return res;
+}
+
+cc_result Snapshot_Save(struct Stream* stream) {
+	cc_uint8 header[SNAP_HEADER_SIZE] = { 0 };
+	cc_uint32 metaEnd, pos, offset2 = 0;
+	cc_result res;
+
+	/* Header is written again at end, once metadata size is known */
+	if ((res = Stream_Write(stream, header, sizeof(header)))) return res;
+	if ((res = Cw_WriteWorld(stream, false)))                 return res;
+	if ((res = stream->Position(stream, &metaEnd)))           return res;
+
+	pos = metaEnd;
+	if ((res = Snapshot_WritePadding(stream, &pos)))              return res;
+	Mem_Copy(header, "CCSN", 4);
+	Stream_SetU16_LE(&header[4],  SNAP_VERSION);
+	Stream_SetU16_LE(&header[8],  World.Width);
+	Stream_SetU16_LE(&header[10], World.Height);
+	Stream_SetU16_LE(&header[12], World.Length);
+	Stream_SetU32_LE(&header[16], metaEnd - SNAP_HEADER_SIZE);
+	Stream_SetU32_LE(&header[20], pos);
+
+	if ((res = Stream_Write(stream, World.Blocks, World.Volume))) return res;
+	pos += World.Volume;
+
+#ifdef EXTENDED_BLOCKS
+	if (World.Blocks != World.Blocks2) {
+		if ((res = Snapshot_WritePadding(stream, &pos)))               return res;
+		offset2 = pos;
+		if ((res = Stream_Write(stream, World.Blocks2, World.Volume))) return res;
+	}
+#endif
+	Stream_SetU32_LE(&header[24], offset2);
+
+	if ((res = stream->Seek(stream, 0))) return res;
+	return Stream_Write(stream, header, sizeof(header));
+}
+
+
+/*########################################################################################################################*
+*-------------------------------------------------------Map delta format--------------------------------------------------*
+*#########################################################################################################################*/
+#define DELTA_VERSION     1
+#define DELTA_HEADER_SIZE 28
+#define DELTA_CHUNK_HDR   7
+/* Map delta files store the chunks of a .cw map that were modified since the map was last fully saved.
+   On each autosave the modified chunks are appended, then applied in order when the map is next loaded.
+	U8[4] "Identifier" (must be "CCDL")
+	U16   "Version"    (only '1' supported)
+	U16   "Width", "Height", "Length"
+	U8[16] "UUID"      (must match UUID of the .cw map)
+	CHUNK {
+		U8  "Flags"    (1 = has upper 8 bits of blocks)
+		U16 "ChunkX", "ChunkY", "ChunkZ"
+		U8* "Blocks"   (only the blocks inside the map, in YZX order)
+		U8* "Blocks2"  (only present if Flags & 1)
+	}
+}*/
+static cc_uint32 delta_size;
+static cc_string autosave_path; static char autosave_buffer[FILENAME_SIZE];
+
+static void Delta_GetPath(const cc_string* path, cc_filepath* raw_path) {
+	cc_string str; char strBuffer[FILENAME_SIZE];
+	String_InitArray(str, strBuffer);
+
+	String_Format1(&str, "%s.delta", path);
+	Platform_EncodePath(raw_path, &str);
+}
+
+/* Calculates the size of the given chunk, after clipping it to the map boundaries */
+static int Delta_ChunkBounds(int cx, int cy, int cz, int* xCount, int* yCount, int* zCount) {
+	*xCount = min(CHUNK_SIZE, World.Width  - (cx << CHUNK_SHIFT));
+	*yCount = min(CHUNK_SIZE, World.Height - (cy << CHUNK_SHIFT));
+	*zCount = min(CHUNK_SIZE, World.Length - (cz << CHUNK_SHIFT));
+	return *xCount * *yCount * *zCount;
+}
+
+static void Delta_CopyChunk(BlockRaw* blocks, cc_uint8* data, int cx, int cy, int cz, cc_bool save) {
+	int xCount, yCount, zCount, x1, y1, z1, y, z, index;
+	Delta_ChunkBounds(cx, cy, cz, &xCount, &yCount, &zCount);
+	x1 = cx << CHUNK_SHIFT; y1 = cy << CHUNK_SHIFT; z1 = cz << CHUNK_SHIFT;
+
+	for (y = y1; y < y1 + yCount; y++) 
+	{
+		for (z = z1; z < z1 + zCount; z++) 
+		{
+			index = World_Pack(x1, y, z);
+			if (save) {
+				Mem_Copy(data, &blocks[index], xCount);
+			} else {
+				Mem_Copy(&blocks[index], data, xCount);
+			}
+			data += xCount;
+		}
+	}
+}
+
+static cc_result Delta_ReadChunk(struct Stream* stream, cc_uint32* read) {
+	cc_uint8 data[DELTA_CHUNK_HDR + CHUNK_SIZE_3 * 2];
+	int cx, cy, cz, xCount, yCount, zCount, size;
+	cc_uint8 flags;
+	cc_result res;
+
+	if ((res = Stream_Read(stream, data, DELTA_CHUNK_HDR))) return res;
+	flags = data[0];
+	cx = Stream_GetU16_LE(&data[1]);
+	cy = Stream_GetU16_LE(&data[3]);
+	cz = Stream_GetU16_LE(&data[5]);
+	if (cx >= World.ChunksX || cy >= World.ChunksY || cz >= World.ChunksZ) return DELTA_ERR_CHUNK;
+
+	size = Delta_ChunkBounds(cx, cy, cz, &xCount, &yCount, &zCount);
+	if (flags & 1) size *= 2;
+	/* Chunk is only applied once fully read, so truncated chunks are just ignored */
+	if ((res = Stream_Read(stream, data, size))) return res;
+	Delta_CopyChunk(World.Blocks, data, cx, cy, cz, false);
+	*read = DELTA_CHUNK_HDR + size;
+
+#ifdef EXTENDED_BLOCKS
+	if ((flags & 1) && !World.Blocks2) {
+		World.Blocks2 = (BlockRaw*)Mem_TryAllocCleared(World.Volume, 1);
+		if (!World.Blocks2) return ERR_OUT_OF_MEMORY;
+		World_SetMapUpper(World.Blocks2);
+	}
+
+	if (flags & 1) {
+		Delta_CopyChunk(World.Blocks2, data + (size >> 1), cx, cy, cz, false);
+	} else if (World.Blocks2) {
+		Mem_Set(data, 0, size);
+		Delta_CopyChunk(World.Blocks2, data, cx, cy, cz, false);
+	}
+#endif
+	return 0;
+}
+
+/* Applies the delta file (if any) associated with the given map file to the world */
+/* Returns false if the delta file is damaged, in which case the whole map must be saved again */
+static cc_bool Delta_Apply(const cc_string* path) {
+	static const cc_string cw = String_FromConst(".cw");
+	cc_uint8 header[DELTA_HEADER_SIZE];
+	cc_uint32 read, position;
+	struct Stream stream;
+	cc_filepath raw_path;
+	cc_result res;
+
+	delta_size = 0;
+	if (!World.Blocks || !String_CaselessEnds(path, &cw)) return true;
+	Delta_GetPath(path, &raw_path);
+	if (!File_Exists(&raw_path)) return true;
+
+	if ((res = Stream_OpenPath(&stream, &raw_path))) {
+		Logger_IOWarn2(res, "opening", &raw_path); return false;
+	}
+	res = Stream_Read(&stream, header, sizeof(header));
+	/* Importers only set width/height/length, but chunk counts are needed too */
+	World_SetDimensions(World.Width, World.Height, World.Length);
+
+	/* Delta files for an older version of the map (e.g. overwritten by another program) are ignored */
+	if (res || !Mem_Equal(header, "CCDL", 4) || Stream_GetU16_LE(&header[4]) != DELTA_VERSION
+		|| Stream_GetU16_LE(&header[6]) != World.Width  || Stream_GetU16_LE(&header[8])  != World.Height
+		|| Stream_GetU16_LE(&header[10]) != World.Length || !Mem_Equal(&header[12], World.Uuid, WORLD_UUID_LEN)) {
+		(void)stream.Close(&stream); return true;
+	}
+
+	/* Only count chunks that were fully read, so appending resumes right after the last one */
+	delta_size = DELTA_HEADER_SIZE;
+	while (!(res = Delta_ReadChunk(&stream, &read))) { delta_size += read; }
+
+	/* Reaching the end exactly after a chunk is the only clean way for the file to end */
+	if (res == ERR_END_OF_STREAM && !stream.Position(&stream, &position) && position == delta_size) res = 0;
+	(void)stream.Close(&stream);
+	if (!res) return true;
+
+	/* Chunks appended after damaged data would never be read back, so the delta can't be extended */
+	Logger_IOWarn2(res, "applying", &raw_path);
+	return false;
+}
+
+/* Appends all the chunks modified since the world was last saved to the map's delta file */
+static cc_result Delta_Save(const cc_string* path) {
+	cc_uint8 data[DELTA_CHUNK_HDR + CHUNK_SIZE_3 * 2];
+	int cx, cy, cz, xCount, yCount, zCount, size, index = 0;
+	struct Stream stream;
+	cc_filepath raw_path;
+	cc_uint8 flags = 0;
+	cc_result res, closeRes;
+
+#ifdef EXTENDED_BLOCKS
+	if (World.Blocks != World.Blocks2) flags = 1;
+#endif
+	Delta_GetPath(path, &raw_path);
+
+	if (delta_size) {
+		if ((res = Stream_AppendPath(&stream, &raw_path))) return res;
+	} else {
+		if ((res = Stream_CreatePath(&stream, &raw_path))) return res;
+		Mem_Copy(data, "CCDL", 4);
+		Stream_SetU16_LE(&data[4],  DELTA_VERSION);
+		Stream_SetU16_LE(&data[6],  World.Width);
+		Stream_SetU16_LE(&data[8],  World.Height);
+		Stream_SetU16_LE(&data[10], World.Length);
+		Mem_Copy(&data[12], World.Uuid, WORLD_UUID_LEN);
+
+		res = Stream_Write(&stream, data, DELTA_HEADER_SIZE);
+		delta_size = DELTA_HEADER_SIZE;
+	}
+
+	for (cz = 0; !res && cz < World.ChunksZ; cz++) 
+	{
+		for (cy = 0; !res && cy < World.ChunksY; cy++) 
+		{
+			for (cx = 0; !res && cx < World.ChunksX; cx++, index++) 
+			{
+				if (!World_IsChunkDirty(index)) continue;
+				data[0] = flags;
+				Stream_SetU16_LE(&data[1], cx);
+				Stream_SetU16_LE(&data[3], cy);
+				Stream_SetU16_LE(&data[5], cz);
+
+				size = Delta_ChunkBounds(cx, cy, cz, &xCount, &yCount, &zCount);
+				Delta_CopyChunk(World.Blocks, data + DELTA_CHUNK_HDR, cx, cy, cz, true);
+#ifdef EXTENDED_BLOCKS
+				if (flags) {
+					Delta_CopyChunk(World.Blocks2, data + DELTA_CHUNK_HDR + size, cx, cy, cz, true);
+					size *= 2;
+				}
+#endif
+				res = Stream_Write(&stream, data, DELTA_CHUNK_HDR + size);
+				delta_size += DELTA_CHUNK_HDR + size;
+			}
+		}
+	}
+
+	closeRes = stream.Close(&stream);
+	return res ? res : closeRes;
+}
+
+/* Truncates the delta file (if any) associated with the given map file */
+static void Delta_Discard(const cc_string* path) {
+	struct Stream stream;
+	cc_filepath raw_path;
+
+	delta_size = 0;
+	Delta_GetPath(path, &raw_path);
+	if (!File_Exists(&raw_path)) return;
+
+	if (Stream_CreatePath(&stream, &raw_path)) return;
+	(void)stream.Close(&stream);
+}
+
+
+/*########################################################################################################################*
+*-------------------------------------------------------Autosaving--------------------------------------------------------*
+*#########################################################################################################################*/
+static int autosave_interval;
+static double autosave_last;
+static cc_bool autosave_full;
+
+static void Autosave_SetPath(const cc_string* path, cc_bool full) {
+	static const cc_string cw = String_FromConst(".cw");
+	autosave_path.length = 0;
+	if (!String_CaselessEnds(path, &cw)) return;
+
+	String_Copy(&autosave_path, path);
+	autosave_last = Game.Time;
+	autosave_full = full;
+}
+
+void Autosave_OnSaved(const cc_string* path) {
+	static const cc_string cw = String_FromConst(".cw");
+	if (!String_CaselessEnds(path, &cw)) return;
+
+	/* Map file now contains all changes, so previous delta file is outdated */
+	Delta_Discard(path);
+	Autosave_SetPath(path, false);
+	World_ClearDirty();
+}
+
+static cc_result Autosave_SaveFull(const cc_string* path) {
+	cc_string tmp; char tmpBuffer[FILENAME_SIZE];
+	struct Stream stream, compStream;
+	struct GZipState* state;
+	cc_filepath raw_path, raw_tmp;
+	cc_result res, closeRes;
+
+	state = (struct GZipState*)Mem_TryAlloc(1, sizeof(struct GZipState));
+	if (!state) return ERR_OUT_OF_MEMORY;
+
+	/* Map is written to a temp file first, so a failed save never destroys the existing map and delta */
+	String_InitArray(tmp, tmpBuffer);
+	String_Format1(&tmp, "%s.tmp", path);
+	Platform_EncodePath(&raw_tmp, &tmp);
+	if ((res = Stream_CreatePath(&stream, &raw_tmp))) { Mem_Free(state); return res; }
+
+	/* Favour speed over compression ratio, since this may happen often */
+	if (GZip_MakeParallelStream(&compStream, &stream, DEFLATE_LEVEL_FAST)) {
+		GZip_MakeStream(&compStream, state, &stream);
+		state->Base.Level = DEFLATE_LEVEL_FAST;
+	}
+
+	res = Cw_Save(&compStream);
+	/* Compression stream must still be closed to free its resources */
+	closeRes = compStream.Close(&compStream);
+	if (!res) res = closeRes;
+
+	closeRes = stream.Close(&stream);
+	if (!res) res = closeRes;
+	Mem_Free(state);
+
+	Platform_EncodePath(&raw_path, path);
+	if (!res) res = File_Rename(&raw_tmp, &raw_path);
+	if (res) { (void)File_Delete(&raw_tmp); return res; }
+
+	/* Map file now contains all changes, so previous delta file is outdated */
+	Delta_Discard(path);
+	return 0;
+}
+
+/* Maps not loaded from a .cw file get their own file, so that unrelated maps are never overwritten */
+static void Autosave_MakePath(void) {
+	static const cc_string defName = String_FromConst("autosave");
+	int i;
+	Utils_EnsureDirectory("maps");
+	Utils_EnsureDirectory("maps/autosave");
+
+	String_Format1(&autosave_path, "maps/autosave/%s-", World.Name.length ? &World.Name : &defName);
+	for (i = 0; i < WORLD_UUID_LEN; i++) 
+	{
+		String_AppendHex(&autosave_path, World.Uuid[i]);
+	}
+	String_AppendConst(&autosave_path, ".cw");
+}
+
+static void Autosave_Run(void) {
+	cc_bool full = autosave_full;
+	cc_result res;
+
+	if (!autosave_path.length) {
+		Autosave_MakePath();
+		full = true;
+	}
+	if (!full && !World_CountDirty()) return;
+
+	/* Compact into a full save when the delta file grows too large, to keep loading fast */
+	if (delta_size >= (cc_uint32)World.Volume / 4) full = true;
+	if (World_CountDirty() == World.ChunksCount)   full = true;
+
+	res = full ? Autosave_SaveFull(&autosave_path) : Delta_Save(&autosave_path);
+	/* A failed delta save may leave a truncated chunk behind, so rewrite everything next time */
+	autosave_full = res != 0;
+	if (res) { Logger_SysWarn2(res, "autosaving", &autosave_path); return; }
+
+	World_ClearDirty();
+	World.LastSave = Game.Time;
+}
+
+static void Autosave_Tick(struct ScheduledTask* task) {
+	if (!Server.IsSinglePlayer || !World.Loaded || !World.Blocks) return;
+	if (Game.Time < autosave_last + autosave_interval) return;
+
+	autosave_last = Game.Time;
+	Autosave_Run();
+}
+
+
 /*########################################################################################################################*
 *-------------------------------------------------------Formats component-------------------------------------------------*
 *#########################################################################################################################*/
@@ -1869,19 +2428,255 @@ static struct MapImporter lvl_imp   = { ".lvl",     Lvl_Load };
 static struct MapImporter mine_imp  = { ".mine",    Dat_Load };
 static struct MapImporter fcm_imp   = { ".fcm",     Fcm_Load };
 static struct MapImporter mclvl_imp = { ".mclevel", MCLevel_Load };
+static struct MapImporter snap_imp  = { ".ccsnap",  Snapshot_Load };
 
-static void OnInit(void) {
+static void RegisterImporters(void) {
 	MapImporter_Register(&cw_imp);
 	MapImporter_Register(&dat_imp);
 	MapImporter_Register(&lvl_imp);
 	MapImporter_Register(&mine_imp);
 	MapImporter_Register(&fcm_imp);
 	MapImporter_Register(&mclvl_imp);
+	MapImporter_Register(&snap_imp);
+}
+
+static void OnInit(void) {
+	RegisterImporters();
+	String_InitArray(autosave_path, autosave_buffer);
+	/* Autosaving is disabled by default */
+	autosave_interval = Options_GetInt(OPT_AUTOSAVE_INTERVAL, 0, 24 * 60 * 60, 0);
+	if (autosave_interval) ScheduledTask_Add(1.0, Autosave_Tick);
+}
+
+static void OnNewMap(void) {
+	autosave_path.length = 0;
+	autosave_last = Game.Time;
+	autosave_full = false;
+	delta_size    = 0;
 }
 
 static void OnFree(void) {
 	imp_head = NULL;
 }
+
+
+/*########################################################################################################################*
+*--------------------------------------------------Map import benchmark---------------------------------------------------*
+*#########################################################################################################################*/
+#define MAPBENCH_MAX_IMPORTERS 16
+struct MapBenchStats {
+	struct MapImporter* imp;
+	int maps;
+	cc_uint64 fileSize, rawSize;
+	cc_uint64 inflateTime, parseTime, setupTime;
+	cc_uint64 peakMemory;
+	cc_bool hasPeakMemory;
+};
+
+struct MapBenchState {
+	struct MapBenchStats stats[MAPBENCH_MAX_IMPORTERS];
+	int count, failed;
+};
+
+/* Throughput of the given number of bytes over the given number of microseconds, in MB/s */
+static float MapBench_Throughput(cc_uint64 size, cc_uint64 elapsed) {
+	if (!elapsed) return 0.0f;
+	return (float)((double)size / (double)elapsed);
+}
+
+static void MapBench_Log(const cc_string* name, const struct MapBenchStats* s) {
+	cc_string str; char strBuffer[512];
+	int fileKB     = (int)(s->fileSize   / 1024);
+	int rawKB      = (int)(s->rawSize    / 1024);
+	int peakKB     = (int)(s->peakMemory / 1024);
+	int inflateUS  = (int)s->inflateTime;
+	int parseUS    = (int)s->parseTime;
+	int setupUS    = (int)s->setupTime;
+	float fileRate = MapBench_Throughput(s->fileSize, s->inflateTime + s->parseTime);
+	float rawRate  = MapBench_Throughput(s->rawSize,  s->inflateTime + s->parseTime);
+	String_InitArray(str, strBuffer);
+
+	String_Format3(&str, "%s: %i KB -> %i KB", name, &fileKB, &rawKB);
+	String_Format3(&str, ", inflate %i us, parse %i us, setup %i us", &inflateUS, &parseUS, &setupUS);
+	String_Format2(&str, ", %f2 MB/s (%f2 MB/s uncompressed)", &fileRate, &rawRate);
+
+	if (s->hasPeakMemory) {
+		String_Format1(&str, ", peak +%i KB", &peakKB);
+	} else {
+		String_AppendConst(&str, ", peak n/a");
+	}
+	Platform_Log(str.buffer, str.length);
+}
+
+static void MapBench_Add(struct MapBenchStats* dst, const struct MapBenchStats* src) {
+	dst->maps        += src->maps;
+	dst->fileSize    += src->fileSize;
+	dst->rawSize     += src->rawSize;
+	dst->inflateTime += src->inflateTime;
+	dst->parseTime   += src->parseTime;
+	dst->setupTime   += src->setupTime;
+	dst->peakMemory   = max(dst->peakMemory, src->peakMemory);
+	dst->hasPeakMemory |= src->hasPeakMemory;
+}
+
+/* Inflates the whole file without parsing it, to measure how long decompressing takes */
+/* NOTE: Only GZip compressed files are measured, other files are treated as uncompressed */
+static void MapBench_Inflate(void* data, cc_uint32 size, struct MapBenchStats* s) {
+	static cc_uint8 buffer[64 * 1024];
+	struct InflateState state;
+	struct Stream src, inflate;
+	cc_uint8* bytes = (cc_uint8*)data;
+	cc_uint64 beg, end;
+	cc_uint32 read;
+
+	s->rawSize = size;
+	if (size < 2 || bytes[0] != 0x1F || bytes[1] != 0x8B) return;
+
+	beg = Stopwatch_Measure();
+	Stream_ReadonlyMemory(&src, data, size);
+	if (Map_SkipGZipHeader(&src)) return;
+
+	Inflate_MakeStream2(&inflate, &state, &src);
+	s->rawSize = 0;
+
+	for (;;)
+	{
+		if (inflate.Read(&inflate, buffer, sizeof(buffer), &read) || !read) break;
+		s->rawSize += read;
+	}
+	end = Stopwatch_Measure();
+	s->inflateTime = Stopwatch_ElapsedMicroseconds(beg, end);
+}
+
+static int MapBench_FindSlot(struct MapImporter* imp) {
+	struct MapImporter* cur;
+	int i = 0;
+
+	for (cur = imp_head; cur && i < MAPBENCH_MAX_IMPORTERS; cur = cur->next, i++)
+	{
+		if (cur == imp) return i;
+	}
+	return -1;
+}
+
+static cc_result MapBench_ReadFile(const cc_filepath* path, void** data, cc_uint32* size) {
+	struct Stream stream;
+	cc_result res;
+
+	res = Stream_OpenPath(&stream, path);
+	if (res) return res;
+
+	if (!(res = stream.Length(&stream, size))) {
+		*data = Mem_TryAlloc(*size, 1);
+		res   = *data ? Stream_Read(&stream, (cc_uint8*)*data, *size) : ERR_OUT_OF_MEMORY;
+	}
+
+	/* No point logging error for closing readonly file */
+	(void)stream.Close(&stream);
+	return res;
+}
+
+static void MapBench_ProcessFile(const cc_string* path, void* obj, int isDirectory) {
+	struct MapBenchState* state  = (struct MapBenchState*)obj;
+	struct LocationUpdate update = { 0 };
+	struct MapBenchStats s = { 0 };
+	struct MapImporter* imp;
+	struct Stream stream;
+	cc_filepath raw_path;
+	cc_uint64 beg, mid, end, baseMemory;
+	cc_uint32 size = 0;
+	void* data     = NULL;
+	cc_result res;
+	int slot;
+
+	if (isDirectory) return;
+	imp = MapImporter_Find(path);
+	if (!imp) return;
+	state->count++;
+
+	/* Read the whole file into memory first, so disk I/O isn't included in the timings */
+	Platform_EncodePath(&raw_path, path);
+	res = MapBench_ReadFile(&raw_path, &data, &size);
+
+	if (res) {
+		Logger_IOWarn2(res, "reading", &raw_path);
+		Mem_Free(data);
+		state->failed++;
+		return;
+	}
+
+	s.imp      = imp;
+	s.maps     = 1;
+	s.fileSize = size;
+	MapBench_Inflate(data, size, &s);
+
+	World_Reset();
+	spawn_point = &update;
+	Process_ResetPeakMemory();
+	baseMemory  = Process_GetPeakMemory();
+
+	beg = Stopwatch_Measure();
+	Stream_ReadonlyMemory(&stream, data, size);
+	res = imp->import(&stream);
+	mid = Stopwatch_Measure();
+
+	if (res) {
+		Logger_IOWarn2(res, "decoding", &raw_path);
+		World_Reset();
+		Mem_Free(data);
+		state->failed++;
+		return;
+	}
+	World_SetNewMap(World.Blocks, World.Width, World.Height, World.Length);
+	end = Stopwatch_Measure();
+
+	/* Importers inflate the data again themselves, so subtract to estimate just parsing */
+	s.parseTime = Stopwatch_ElapsedMicroseconds(beg, mid);
+	s.parseTime = s.parseTime > s.inflateTime ? s.parseTime - s.inflateTime : 0;
+	s.setupTime = Stopwatch_ElapsedMicroseconds(mid, end);
+	/* Relative to the memory in use just before importing (which includes the file data) */
+	/* Process_GetPeakMemory returns 0 when peak memory usage can't be measured */
+	s.hasPeakMemory = baseMemory != 0;
+	s.peakMemory    = s.hasPeakMemory ? Process_GetPeakMemory() - baseMemory : 0;
+
+	World_Reset();
+	Mem_Free(data);
+	MapBench_Log(path, &s);
+
+	slot = MapBench_FindSlot(imp);
+	if (slot >= 0) {
+		state->stats[slot].imp = imp;
+		MapBench_Add(&state->stats[slot], &s);
+	}
+}
+
+int Map_RunBenchmark(const cc_string* dir) {
+	static struct MapBenchState state;
+	struct MapBenchStats total = { 0 };
+	cc_string name;
+	cc_result res;
+	int i;
+
+	if (!imp_head) RegisterImporters();
+	Mem_Set(&state, 0, sizeof(state));
+
+	res = Directory_Enum(dir, &state, MapBench_ProcessFile);
+	if (res) { Logger_SysWarn2(res, "enumerating", dir); return 1; }
+
+	for (i = 0; i < MAPBENCH_MAX_IMPORTERS; i++)
+	{
+		if (!state.stats[i].imp) continue;
+		name = String_FromReadonly(state.stats[i].imp->fileExt);
+
+		MapBench_Log(&name, &state.stats[i]);
+		MapBench_Add(&total, &state.stats[i]);
+	}
+
+	name = String_FromReadonly("Total");
+	MapBench_Log(&name, &total);
+	Platform_Log2("Map import benchmark: %i of %i maps failed to load", &state.failed, &state.count);
+	return state.failed;
+}
 #else
 /* No point including map format code when can't save/load maps anyways */
 struct MapImporter* MapImporter_Find(const cc_string* path) { return NULL; }
@@ -1890,12 +2685,18 @@ cc_result Map_LoadFrom(const cc_string* path) { return ERR_NOT_SUPPORTED; }
 cc_result Cw_Save(struct Stream* stream)  { return ERR_NOT_SUPPORTED; }
 cc_result Dat_Save(struct Stream* stream) { return ERR_NOT_SUPPORTED; }
 cc_result Schematic_Save(struct Stream* stream) { return ERR_NOT_SUPPORTED; }
+cc_result Snapshot_Save(struct Stream* stream)  { return ERR_NOT_SUPPORTED; }
+void Autosave_OnSaved(const cc_string* path) { }
+int Map_RunBenchmark(const cc_string* dir) { return 0; }
 
-static void OnInit(void) { }
-static void OnFree(void) { }
+static void OnInit(void)   { }
+static void OnNewMap(void) { }
+static void OnFree(void)   { }
 #endif
 
 struct IGameComponent Formats_Component = {
-	OnInit, /* Init  */
-	OnFree  /* Free  */
+	OnInit,  /* Init  */
+	OnFree,  /* Free  */
+	NULL,    /* Reset */
+	OnNewMap /* OnNewMap */
 };
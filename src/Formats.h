@@ -38,6 +38,20 @@ cc_result Schematic_Save(struct Stream* stream);
 /* Exports a world to a .dat Classic map file */
 /* Used by MineCraft Classic */
 cc_result Dat_Save(struct Stream* stream);
+/* Exports a world to a .ccsnap ClassiCube snapshot file. */
+/* Uncompressed, so much faster to save/load than other formats */
+/* NOTE: stream must support seeking */
+cc_result Snapshot_Save(struct Stream* stream);
+
+/* Notifies autosaving that the world was fully saved to the given file. */
+/* If the file is a .cw map, it becomes the map that future autosaves are written to */
+void Autosave_OnSaved(const cc_string* path);
+
+/* Imports every map file in the given directory on the calling thread, logging how long */
+/*  inflating, parsing and setting up the world took, and the peak memory used, per map and per importer. */
+/* Returns the number of maps that failed to load. */
+/* NOTE: This replaces the current world, and does not apply deltas or move the local player. */
+int Map_RunBenchmark(const cc_string* dir);
 
 CC_END_HEADER
 #endif
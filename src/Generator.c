@@ -7,6 +7,7 @@
 #include "Utils.h"
 #include "Game.h"
 #include "Window.h"
+#include "String.h"
 
 const struct MapGenerator* Gen_Active;
 BlockRaw* Gen_Blocks;
@@ -16,6 +17,23 @@ volatile float Gen_CurrentProgress;
 volatile const char* Gen_CurrentState;
 volatile cc_bool gen_done;
 
+/* How long each step of map generation took, used by the generator benchmark */
+#define GEN_MAX_STEPS 16
+static const char* step_names[GEN_MAX_STEPS];
+static int step_times[GEN_MAX_STEPS];
+static int step_count;
+static cc_uint64 step_beg;
+
+static void Gen_BeginStep(void) { step_beg = Stopwatch_Measure(); }
+
+static void Gen_EndStep(void) {
+	if (step_count >= GEN_MAX_STEPS) return;
+
+	step_names[step_count] = (const char*)Gen_CurrentState;
+	step_times[step_count] = (int)Stopwatch_ElapsedMicroseconds(step_beg, Stopwatch_Measure());
+	step_count++;
+}
+
 /* There are two main types of multitasking: */
 /*  - Pre-emptive multitasking (system automatically switches between threads) */
 /*  - Cooperative multitasking (threads must be manually switched by the app) */
@@ -37,7 +55,7 @@ static cc_uint64 lastRender;
 
 #define GEN_COOP_STEP(index, step) \
 	case index: \
-		step; \
+		Gen_BeginStep(); step; Gen_EndStep(); \
 		gen_step++; \
 		curTime = Stopwatch_Measure(); \
 		if (Stopwatch_ElapsedMS(lastRender, curTime) > 100) { lastRender = curTime; return; }
@@ -46,9 +64,13 @@ static cc_uint64 lastRender;
 #define GEN_COOP_END \
 	}
 
-static void Gen_Run(void) {
-	gen_step = 0;
+static void Gen_ResetSteps(void) {
+	gen_step   = 0;
 	lastRender = Stopwatch_Measure();
+}
+
+static void Gen_Run(void) {
+	Gen_ResetSteps();
 	Gen_Active->Generate();
 }
 
@@ -61,8 +83,9 @@ cc_bool Gen_IsDone(void) {
 /* For systems supporting preemptive threading, there's no point */
 /* bothering with all the cooperative tasking shenanigans */
 #define GEN_COOP_BEGIN
-#define GEN_COOP_STEP(index, step) step;
+#define GEN_COOP_STEP(index, step) Gen_BeginStep(); step; Gen_EndStep();
 #define GEN_COOP_END
+#define Gen_ResetSteps()
 
 static void Gen_DoGen(void) {
 	Gen_Active->Generate();
@@ -80,7 +103,8 @@ cc_bool Gen_IsDone(void) { return gen_done; }
 static void Gen_Reset(void) {
 	Gen_CurrentProgress = 0.0f;
 	Gen_CurrentState    = "";
-	gen_done = false;
+	gen_done   = false;
+	step_count = 0;
 }
 
 void Gen_Start(void) {
@@ -99,7 +123,7 @@ void Gen_Start(void) {
 /*########################################################################################################################*
 *-----------------------------------------------------Flatgrass gen-------------------------------------------------------*
 *#########################################################################################################################*/
-static void FlatgrassGen_MapSet(int yBeg, int yEnd, BlockRaw block) {
+static void FlatgrassGen_MapSet(int yBeg, int yEnd, BlockRaw block, const char* state) {
 	cc_uint32 oneY = (cc_uint32)World.OneY;
 	BlockRaw* ptr = Gen_Blocks;
 	int y, yHeight;
@@ -107,6 +131,7 @@ static void FlatgrassGen_MapSet(int yBeg, int yEnd, BlockRaw block) {
 	yBeg = max(yBeg, 0); yEnd = max(yEnd, 0);
 	yHeight = (yEnd - yBeg) + 1;
 	Gen_CurrentProgress = 0.0f;
+	Gen_CurrentState    = state;
 
 	for (y = yBeg; y <= yEnd; y++) {
 		Mem_Set(ptr + y * oneY, block, oneY);
@@ -119,14 +144,13 @@ static cc_bool FlatgrassGen_Prepare(void) {
 }
 
 static void FlatgrassGen_Generate(void) {
-	Gen_CurrentState = "Setting air blocks";
-	FlatgrassGen_MapSet(World.Height / 2, World.MaxY, BLOCK_AIR);
+	int midY = World.Height / 2;
 
-	Gen_CurrentState = "Setting dirt blocks";
-	FlatgrassGen_MapSet(0, World.Height / 2 - 2, BLOCK_DIRT);
-
-	Gen_CurrentState = "Setting grass blocks";
-	FlatgrassGen_MapSet(World.Height / 2 - 1, World.Height / 2 - 1, BLOCK_GRASS);
+	GEN_COOP_BEGIN
+		GEN_COOP_STEP(0, FlatgrassGen_MapSet(midY,     World.MaxY, BLOCK_AIR,   "Setting air blocks") );
+		GEN_COOP_STEP(1, FlatgrassGen_MapSet(0,        midY - 2,   BLOCK_DIRT,  "Setting dirt blocks") );
+		GEN_COOP_STEP(2, FlatgrassGen_MapSet(midY - 1, midY - 1,   BLOCK_GRASS, "Setting grass blocks") );
+	GEN_COOP_END
 
 	gen_done = true;
 }
@@ -196,6 +220,99 @@ static float ImprovedNoise_Calc(const cc_uint8* p, float x, float y) {
 }
 
 
+/* Noise is evaluated in rows of samples that all share the same y coordinate */
+/* (this lets y related calculations only be done once for the entire row) */
+#define NOISE_ROW_SIZE 64
+
+/* The SIMD path performs exactly the same sequence of float operations as ImprovedNoise_Calc, */
+/*  so that it produces bit-identical results (and therefore identical maps for a given seed) */
+/* x87 FPU and FMA contraction would both change rounding of the scalar path, so not used then */
+#if (defined __x86_64__ || defined _M_X64) && !defined __FMA__
+#include <emmintrin.h>
+/* Vectorised version of Grad for 4 samples, using the per sample gradient directions */
+#define GradV(i, x, y) _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(gradX[i]), x), _mm_mul_ps(_mm_loadu_ps(gradY[i]), y))
+
+static void ImprovedNoise_AccumRow(const cc_uint8* p, const float* xs, float freq, float y, float amplitude, float* sums, int count) {
+	float gradX[4][4], gradY[4][4];
+	int xFloor[4], hash[4];
+	int i, j, k, A, B, X, Y, yFloor;
+	float yFrac, v;
+	__m128 x, u, vy, xm1, yf, ym1;
+	__m128 g22, g12, c1, g21, g11, c2, res;
+	__m128i xi;
+
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one  = _mm_set1_ps(1.0f);
+	const __m128 six  = _mm_set1_ps(6.0f);
+	const __m128 c15  = _mm_set1_ps(15.0f);
+	const __m128 c10  = _mm_set1_ps(10.0f);
+	const __m128 vFreq = _mm_set1_ps(freq);
+	const __m128 vAmp  = _mm_set1_ps(amplitude);
+
+	yFloor = y >= 0 ? (int)y : (int)y - 1;
+	Y     = yFloor & 0xFF;
+	yFrac = y - yFloor;
+	v     = yFrac * yFrac * yFrac * (yFrac * (yFrac * 6 - 15) + 10); /* Fade(y) */
+
+	yf  = _mm_set1_ps(yFrac);
+	ym1 = _mm_set1_ps(yFrac - 1);
+	vy  = _mm_set1_ps(v);
+
+	for (i = 0; i + 4 <= count; i += 4) {
+		x  = _mm_mul_ps(_mm_loadu_ps(xs + i), vFreq);
+		xi = _mm_cvttps_epi32(x);
+		/* x >= 0 ? (int)x : (int)x - 1 (comparison mask is -1 where x is not >= 0) */
+		xi = _mm_add_epi32(xi, _mm_castps_si128(_mm_cmpnge_ps(x, zero)));
+		_mm_storeu_si128((__m128i*)xFloor, xi);
+
+		x  = _mm_sub_ps(x, _mm_cvtepi32_ps(xi));
+		u  = _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(x, x), x),
+				_mm_add_ps(_mm_mul_ps(x, _mm_sub_ps(_mm_mul_ps(x, six), c15)), c10)); /* Fade(x) */
+		xm1 = _mm_sub_ps(x, one);
+
+		/* Permutation table lookups have no efficient SSE2 equivalent */
+		for (j = 0; j < 4; j++) {
+			X = xFloor[j] & 0xFF;
+			A = p[X] + Y; B = p[X + 1] + Y;
+
+			hash[0] = (p[p[A]]     & 0xF) << 1;
+			hash[1] = (p[p[B]]     & 0xF) << 1;
+			hash[2] = (p[p[A + 1]] & 0xF) << 1;
+			hash[3] = (p[p[B + 1]] & 0xF) << 1;
+
+			for (k = 0; k < 4; k++) {
+				gradX[k][j] = (float)(((X_FLAGS >> hash[k]) & 3) - 1);
+				gradY[k][j] = (float)(((Y_FLAGS >> hash[k]) & 3) - 1);
+			}
+		}
+
+		g22 = GradV(0, x,   yf);
+		g12 = GradV(1, xm1, yf);
+		c1  = _mm_add_ps(g22, _mm_mul_ps(u, _mm_sub_ps(g12, g22)));
+
+		g21 = GradV(2, x,   ym1);
+		g11 = GradV(3, xm1, ym1);
+		c2  = _mm_add_ps(g21, _mm_mul_ps(u, _mm_sub_ps(g11, g21)));
+
+		res = _mm_add_ps(c1, _mm_mul_ps(vy, _mm_sub_ps(c2, c1)));
+		_mm_storeu_ps(sums + i, _mm_add_ps(_mm_loadu_ps(sums + i), _mm_mul_ps(res, vAmp)));
+	}
+
+	/* Use scalar path for any leftover samples */
+	for (; i < count; i++) {
+		sums[i] += ImprovedNoise_Calc(p, xs[i] * freq, y) * amplitude;
+	}
+}
+#else
+static void ImprovedNoise_AccumRow(const cc_uint8* p, const float* xs, float freq, float y, float amplitude, float* sums, int count) {
+	int i;
+	for (i = 0; i < count; i++) {
+		sums[i] += ImprovedNoise_Calc(p, xs[i] * freq, y) * amplitude;
+	}
+}
+#endif
+
+
 struct OctaveNoise { cc_uint8 p[8][NOISE_TABLE_SIZE]; int octaves; };
 static void OctaveNoise_Init(struct OctaveNoise* n, RNGState* rnd, int octaves) {
 	int i;
@@ -206,17 +323,18 @@ static void OctaveNoise_Init(struct OctaveNoise* n, RNGState* rnd, int octaves)
 	}
 }
 
-static float OctaveNoise_Calc(const struct OctaveNoise* n, float x, float y) {
+/* Calculates octave noise for count (at most NOISE_ROW_SIZE) samples at (xs[i], y) */
+static void OctaveNoise_CalcRow(const struct OctaveNoise* n, const float* xs, float y, float* sums, int count) {
 	float amplitude = 1, freq = 1;
-	float sum = 0;
 	int i;
 
+	for (i = 0; i < count; i++) { sums[i] = 0; }
+
 	for (i = 0; i < n->octaves; i++) {
-		sum += ImprovedNoise_Calc(n->p[i], x * freq, y * freq) * amplitude;
+		ImprovedNoise_AccumRow(n->p[i], xs, freq, y * freq, amplitude, sums, count);
 		amplitude *= 2.0f;
 		freq *= 0.5f;
 	}
-	return sum;
 }
 
 
@@ -226,9 +344,14 @@ static void CombinedNoise_Init(struct CombinedNoise* n, RNGState* rnd, int octav
 	OctaveNoise_Init(&n->noise2, rnd, octaves2);
 }
 
-static float CombinedNoise_Calc(const struct CombinedNoise* n, float x, float y) {
-	float offset = OctaveNoise_Calc(&n->noise2, x, y);
-	return OctaveNoise_Calc(&n->noise1, x + offset, y);
+/* Calculates combined noise for count (at most NOISE_ROW_SIZE) samples at (xs[i], y) */
+static void CombinedNoise_CalcRow(const struct CombinedNoise* n, const float* xs, float y, float* sums, int count) {
+	float offsets[NOISE_ROW_SIZE];
+	int i;
+	OctaveNoise_CalcRow(&n->noise2, xs, y, offsets, count);
+
+	for (i = 0; i < count; i++) { offsets[i] += xs[i]; }
+	OctaveNoise_CalcRow(&n->noise1, offsets, y, sums, count);
 }
 
 
@@ -265,51 +388,18 @@ static void NotchyGen_FillOblateSpheroid(int x, int y, int z, float radius, Bloc
 	}
 }
 
-#if CC_BUILD_MAXSTACK <= (32 * 1024)
-	#define STACK_FAST 512
-#else
-	#define STACK_FAST 8192
-#endif
-
 static void NotchyGen_FloodFill(int index, BlockRaw block) {
-	int* stack;
-	int stack_default[STACK_FAST]; /* avoid allocating memory if possible */
-	int count = 0, limit = STACK_FAST;
-	int x, y, z;
-
-	stack = stack_default;
-	if (index < 0) return; /* y below map, don't bother starting */
-	stack[count++] = index;
-
-	while (count) {
-		index = stack[--count];
-
-		if (Gen_Blocks[index] != BLOCK_AIR) continue;
-		Gen_Blocks[index] = block;
-
-		x = index  % World.Width;
-		y = index  / World.OneY;
-		z = (index / World.Width) % World.Length;
-
-		/* need to increase stack */
-		if (count >= limit - FACE_COUNT) {
-			Utils_Resize((void**)&stack, &limit, 4, STACK_FAST, STACK_FAST);
-		}
-
-		if (x > 0)          { stack[count++] = index - 1; }
-		if (x < World.MaxX) { stack[count++] = index + 1; }
-		if (z > 0)          { stack[count++] = index - World.Width; }
-		if (z < World.MaxZ) { stack[count++] = index + World.Width; }
-		if (y > 0)          { stack[count++] = index - World.OneY; }
-	}
-	if (limit > STACK_FAST) Mem_Free(stack);
+	World_FloodFill(Gen_Blocks, index, BLOCK_AIR, block);
 }
 
 
 static void NotchyGen_CreateHeightmap(void) {
+	float xs1[NOISE_ROW_SIZE], xs3[NOISE_ROW_SIZE], highXs[NOISE_ROW_SIZE];
+	float low[NOISE_ROW_SIZE], high[NOISE_ROW_SIZE], sel[NOISE_ROW_SIZE];
+	cc_uint8 highCols[NOISE_ROW_SIZE];
 	float hLow, hHigh, height;
 	int hIndex = 0, adjHeight;
-	int x, z;
+	int x, z, i, j, count, highCount;
 
 #if CC_BUILD_MAXSTACK <= (16 * 1024)
 	struct NoiseBuffer { 
@@ -336,21 +426,40 @@ static void NotchyGen_CreateHeightmap(void) {
 	for (z = 0; z < World.Length; z++) {
 		Gen_CurrentProgress = (float)z / World.Length;
 
-		for (x = 0; x < World.Width; x++) {
-			hLow   = CombinedNoise_Calc(n1, x * 1.3f, z * 1.3f) / 6 - 4;
-			height = hLow;
+		for (x = 0; x < World.Width; x += NOISE_ROW_SIZE) {
+			count = min(NOISE_ROW_SIZE, World.Width - x);
+			for (i = 0; i < count; i++) {
+				xs1[i] = (x + i) * 1.3f;
+				xs3[i] = (float)(x + i);
+			}
+
+			CombinedNoise_CalcRow(n1, xs1, z * 1.3f, low, count);
+			OctaveNoise_CalcRow(n3,   xs3, (float)z, sel, count);
 
-			if (OctaveNoise_Calc(n3, (float)x, (float)z) <= 0) {
-				hHigh = CombinedNoise_Calc(n2, x * 1.3f, z * 1.3f) / 5 + 6;
-				height = max(hLow, hHigh);
+			/* High noise is only needed for the columns where the selector is <= 0 */
+			for (i = 0, highCount = 0; i < count; i++) {
+				if (sel[i] > 0) continue;
+				highCols[highCount] = i;
+				highXs[highCount++] = xs1[i];
 			}
+			CombinedNoise_CalcRow(n2, highXs, z * 1.3f, high, highCount);
+
+			for (i = 0, j = 0; i < count; i++) {
+				hLow   = low[i] / 6 - 4;
+				height = hLow;
 
-			height *= 0.5f;
-			if (height < 0) height *= 0.8f;
+				if (j < highCount && highCols[j] == i) {
+					hHigh  = high[j++] / 5 + 6;
+					height = max(hLow, hHigh);
+				}
+
+				height *= 0.5f;
+				if (height < 0) height *= 0.8f;
 
-			adjHeight = (int)(height + waterLevel);
-			minHeight = min(adjHeight, minHeight);
-			heightmap[hIndex++] = adjHeight;
+				adjHeight = (int)(height + waterLevel);
+				minHeight = min(adjHeight, minHeight);
+				heightmap[hIndex++] = adjHeight;
+			}
 		}
 	}
 }
@@ -388,7 +497,8 @@ static void NotchyGen_CreateStrata(void) {
 	int dirtThickness, dirtHeight;
 	int minStoneY, stoneHeight;
 	int hIndex = 0, maxY = World.MaxY, index = 0;
-	int x, y, z;
+	float xs[NOISE_ROW_SIZE], thickness[NOISE_ROW_SIZE];
+	int x, y, z, i, count;
 	struct OctaveNoise n;
 
 	/* Try to bulk fill bottom of the map if possible */
@@ -400,7 +510,16 @@ static void NotchyGen_CreateStrata(void) {
 		Gen_CurrentProgress = (float)z / World.Length;
 
 		for (x = 0; x < World.Width; x++) {
-			dirtThickness = (int)(OctaveNoise_Calc(&n, (float)x, (float)z) / 24 - 4);
+			i = x % NOISE_ROW_SIZE;
+			if (!i) {
+				count = min(NOISE_ROW_SIZE, World.Width - x);
+				for (i = 0; i < count; i++) { xs[i] = (float)(x + i); }
+
+				OctaveNoise_CalcRow(&n, xs, (float)z, thickness, count);
+				i = 0;
+			}
+
+			dirtThickness = (int)(thickness[i] / 24 - 4);
 			dirtHeight    = heightmap[hIndex++];
 			stoneHeight   = dirtHeight + dirtThickness;
 
@@ -562,9 +681,14 @@ static void NotchyGen_FloodFillLava(void) {
 }
 
 static void NotchyGen_CreateSurfaceLayer(void) {	
+	float sandXs[NOISE_ROW_SIZE],  sand[NOISE_ROW_SIZE];
+	float gravelXs[NOISE_ROW_SIZE], gravel[NOISE_ROW_SIZE];
+	int indices[NOISE_ROW_SIZE];
+	cc_uint8 kinds[NOISE_ROW_SIZE];
 	int hIndex = 0, index;
+	int sandCount, gravelCount;
 	BlockRaw above;
-	int x, y, z;
+	int x, y, z, i, count;
 #if CC_BUILD_MAXSTACK <= (16 * 1024)
 	struct NoiseBuffer { 
 		struct OctaveNoise n1, n2;
@@ -585,18 +709,44 @@ static void NotchyGen_CreateSurfaceLayer(void) {
 	for (z = 0; z < World.Length; z++) {
 		Gen_CurrentProgress = (float)z / World.Length;
 
-		for (x = 0; x < World.Width; x++) {
-			y = heightmap[hIndex++];
-			if (y < 0 || y >= World.Height) continue;
-
-			index = World_Pack(x, y, z);
-			above = y >= World.MaxY ? BLOCK_AIR : Gen_Blocks[index + World.OneY];
+		for (x = 0; x < World.Width; x += NOISE_ROW_SIZE) {
+			count = min(NOISE_ROW_SIZE, World.Width - x);
+			sandCount = 0; gravelCount = 0;
+
+			/* Work out which columns need sand or gravel noise, so only those are calculated */
+			for (i = 0; i < count; i++) {
+				kinds[i] = BLOCK_AIR;
+				y = heightmap[hIndex++];
+				if (y < 0 || y >= World.Height) continue;
+
+				index = World_Pack(x + i, y, z);
+				above = y >= World.MaxY ? BLOCK_AIR : Gen_Blocks[index + World.OneY];
+				indices[i] = index;
+
+				/* TODO: update heightmap */
+				if (above == BLOCK_STILL_WATER) {
+					kinds[i] = BLOCK_GRAVEL;
+					gravelXs[gravelCount++] = (float)(x + i);
+				} else if (above == BLOCK_AIR && y <= waterLevel) {
+					kinds[i] = BLOCK_SAND;
+					sandXs[sandCount++] = (float)(x + i);
+				} else if (above == BLOCK_AIR) {
+					kinds[i] = BLOCK_GRASS;
+				}
+			}
 
-			/* TODO: update heightmap */
-			if (above == BLOCK_STILL_WATER && (OctaveNoise_Calc(n2, (float)x, (float)z) > 12)) {
-				Gen_Blocks[index] = BLOCK_GRAVEL;
-			} else if (above == BLOCK_AIR) {
-				Gen_Blocks[index] = (y <= waterLevel && (OctaveNoise_Calc(n1, (float)x, (float)z) > 8)) ? BLOCK_SAND : BLOCK_GRASS;
+			OctaveNoise_CalcRow(n1, sandXs,   (float)z, sand,   sandCount);
+			OctaveNoise_CalcRow(n2, gravelXs, (float)z, gravel, gravelCount);
+			sandCount = 0; gravelCount = 0;
+
+			for (i = 0; i < count; i++) {
+				if (kinds[i] == BLOCK_GRAVEL) {
+					if (gravel[gravelCount++] > 12) Gen_Blocks[indices[i]] = BLOCK_GRAVEL;
+				} else if (kinds[i] == BLOCK_SAND) {
+					Gen_Blocks[indices[i]] = sand[sandCount++] > 8 ? BLOCK_SAND : BLOCK_GRASS;
+				} else if (kinds[i] == BLOCK_GRASS) {
+					Gen_Blocks[indices[i]] = BLOCK_GRASS;
+				}
 			}
 		}
 	}
@@ -851,3 +1001,96 @@ int TreeGen_Grow(int treeX, int treeY, int treeZ, int height, IVec3* coords, Blo
 
 	return count;
 }
+
+
+/*########################################################################################################################*
+*--------------------------------------------------Generator benchmark----------------------------------------------------*
+*#########################################################################################################################*/
+struct GenBenchmark {
+	const char* name;
+	const struct MapGenerator* gen;
+	int width, height, length, seed;
+	cc_uint32 crc; /* Expected CRC32 of the generated blocks */
+};
+
+static const struct GenBenchmark gen_benchmarks[] = {
+	{ "Flatgrass", &FlatgrassGen,  128,  64,  128,           0, 0x1622F464UL },
+	{ "Flatgrass", &FlatgrassGen,  512,  64,  512,           0, 0x1F7C520EUL },
+	{ "Flatgrass", &FlatgrassGen,  160,  96,  100,           0, 0x3FC1CD05UL },
+	{ "Notchy",    &NotchyGen,      64,  64,   64,           0, 0xF56C1E06UL },
+	{ "Notchy",    &NotchyGen,      64,  64,   64,       12345, 0x5EB37333UL },
+	{ "Notchy",    &NotchyGen,     128,  64,  128,           0, 0xFC119DD8UL },
+	{ "Notchy",    &NotchyGen,     128,  64,  128,    -9876543, 0xBAF31EB0UL },
+	{ "Notchy",    &NotchyGen,     256,  64,  256,           0, 0xE2CFB332UL },
+	{ "Notchy",    &NotchyGen,     256,  64,  256,       12345, 0x0B65E26EUL },
+	{ "Notchy",    &NotchyGen,     256, 128,  256,  2147483647, 0xE863B7A7UL },
+	{ "Notchy",    &NotchyGen,     160,  96,  100,         777, 0x0A5E8D6AUL },
+	{ "Notchy",    &NotchyGen,     512,  64,  512,           0, 0xA91A9D7DUL },
+	{ "Notchy",    &NotchyGen,     512,  64,  512,    -9876543, 0x12F53402UL },
+	{ "Notchy",    &NotchyGen,    1024,  64, 1024,       12345, 0x5A83512CUL },
+};
+
+static void Gen_LogBenchmark(const struct GenBenchmark* b, const char* result, int elapsed, cc_uint32 crc) {
+	cc_string str; char strBuffer[256];
+	int i;
+	String_InitArray(str, strBuffer);
+
+	String_Format4(&str, "%c %ix%i", b->name, &b->width, &b->height, &b->length);
+	String_Format4(&str, "x%i, seed %i: %c (CRC32 %h", &b->length, &b->seed, result, &crc);
+	String_Format2(&str, ", expected %h), %i us", &b->crc, &elapsed);
+	Platform_Log(str.buffer, str.length);
+
+	for (i = 0; i < step_count; i++) {
+		Platform_Log2("  %c: %i us", step_names[i], &step_times[i]);
+	}
+}
+
+static cc_bool Gen_RunBenchmarkCase(const struct GenBenchmark* b) {
+	cc_uint64 beg, end;
+	cc_uint32 crc;
+	int elapsed;
+
+	World_SetDimensions(b->width, b->height, b->length);
+	Gen_Active = b->gen;
+	Gen_Seed   = b->seed;
+	Gen_Reset();
+
+	beg = Stopwatch_Measure();
+	Gen_Blocks = (BlockRaw*)Mem_TryAlloc(World.Volume, 1);
+
+	if (!Gen_Blocks || !Gen_Active->Prepare()) {
+		Gen_LogBenchmark(b, "OUT OF MEMORY", 0, 0);
+		Mem_Free(Gen_Blocks);
+		Gen_Blocks = NULL;
+		return false;
+	}
+
+	/* Generate the map on this thread, instead of in the background like Gen_Start */
+	Gen_ResetSteps();
+	while (!gen_done) { Gen_Active->Generate(); }
+	end = Stopwatch_Measure();
+
+	elapsed = (int)Stopwatch_ElapsedMicroseconds(beg, end);
+	crc     = Utils_CRC32(Gen_Blocks, World.Volume);
+	Mem_Free(Gen_Blocks);
+	Gen_Blocks = NULL;
+
+	Gen_LogBenchmark(b, crc == b->crc ? "OK" : "MISMATCH", elapsed, crc);
+	return crc == b->crc;
+}
+
+int Gen_RunBenchmark(void) {
+	struct GameVersion version = Game_Version;
+	int i, failed = 0;
+	/* Flowers and mushrooms are only generated for newer game versions */
+	Game_Version.Version = VERSION_0030;
+
+	for (i = 0; i < Array_Elems(gen_benchmarks); i++) {
+		if (!Gen_RunBenchmarkCase(&gen_benchmarks[i])) failed++;
+	}
+
+	Game_Version = version;
+	World_SetDimensions(0, 0, 0);
+	Platform_Log2("Generator benchmark: %i of %i maps did not match", &failed, &i);
+	return failed;
+}
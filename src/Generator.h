@@ -21,6 +21,11 @@ extern BlockRaw* Gen_Blocks;
 void Gen_Start(void);
 /* Checks whether the map generator has completed yet */
 cc_bool Gen_IsDone(void);
+/* Generates maps of several sizes and seeds on the calling thread, logging the time taken by */
+/*  each generation step, and checks the generated blocks still match the recorded CRC32s. */
+/* Returns the number of generated maps whose blocks did not match. */
+/* NOTE: This overwrites the dimensions of the current world. */
+int Gen_RunBenchmark(void);
 
 
 struct MapGenerator {
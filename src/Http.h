@@ -54,6 +54,9 @@ void HttpRequest_Free(struct HttpRequest* request);
 /* Aschronously performs a http GET request to download a skin. */
 /* If url is a skin, downloads from there. (if not, downloads from SKIN_SERVER/[skinName].png) */
 int Http_AsyncGetSkin(const cc_string* skinName, cc_uint8 flags);
+/* Asynchronously performs a http GET request to download a skin. */
+/* If etag is not empty, the server responds with 304 instead when the skin has not changed. */
+int Http_AsyncGetSkinEx(const cc_string* skinName, cc_uint8 flags, const cc_string* etag);
 /* Asynchronously performs a http GET request. (e.g. to download data) */
 int Http_AsyncGetData(const cc_string* url, cc_uint8 flags);
 /* Asynchronously performs a http HEAD request. (e.g. to get Content-Length header) */
@@ -64,6 +67,11 @@ int Http_AsyncPostData(const cc_string* url, cc_uint8 flags, const void* data, c
 /* Asynchronously performs a http GET request. (e.g. to download data) */
 /* Also sets the If-Modified-Since and If-None-Match headers. (if not NULL)  */
 int Http_AsyncGetDataEx(const cc_string* url, cc_uint8 flags, const cc_string* lastModified, const cc_string* etag, struct StringsBuffer* cookies);
+/* Asynchronously performs a http GET request, saving the contents to the given file while downloading. */
+/* Also sets the If-Modified-Since and If-None-Match headers. (if not NULL)  */
+/* NOTE: The file is only replaced once a response with status 200 has been completely downloaded. */
+/* NOTE: Backends that don't support this leave Data set instead, so check whether Data is NULL. */
+int Http_AsyncGetDataToFile(const cc_string* url, cc_uint8 flags, const cc_string* lastModified, const cc_string* etag, const cc_string* path);
 /* Attempts to remove given request from pending and finished request lists. */
 /* NOTE: Won't cancel the request if it is currently in progress. */
 void Http_TryCancel(int reqID);
@@ -79,7 +87,8 @@ cc_bool Http_DescribeError(cc_result res, cc_string* dst);
 /* NOTE: You MUST check Success for whether it completed successfully. */
 /* (Data may still be non NULL even on error, e.g. on a http 404 error) */
 cc_bool Http_GetResult(int reqID, struct HttpRequest* item);
-/* Retrieves information about the request currently being processed. */
+/* Retrieves information about a request currently being processed. */
+/* NOTE: Multiple requests may be processed at once, in which case the first is returned. */
 cc_bool Http_GetCurrent(int* reqID, int* progress);
 /* Retrieves information about the download progress of the given request. */
 /* NOTE: This may return HTTP_PROGRESS_NOT_WORKING_ON if download has finished. */
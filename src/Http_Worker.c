@@ -19,6 +19,9 @@ cc_bool Http_GetCurrent(int* reqID, int* progress) {
 int Http_AsyncGetSkin(const cc_string* skinName, cc_uint8 flags) {
 	return -1;
 }
+int Http_AsyncGetSkinEx(const cc_string* skinName, cc_uint8 flags, const cc_string* etag) {
+	return -1;
+}
 int Http_AsyncGetData(const cc_string* url, cc_uint8 flags) {
 	return -1;
 }
@@ -31,6 +34,9 @@ int Http_AsyncPostData(const cc_string* url, cc_uint8 flags, const void* data, c
 int Http_AsyncGetDataEx(const cc_string* url, cc_uint8 flags, const cc_string* lastModified, const cc_string* etag, struct StringsBuffer* cookies) {
 	return -1;
 }
+int Http_AsyncGetDataToFile(const cc_string* url, cc_uint8 flags, const cc_string* lastModified, const cc_string* etag, const cc_string* path) {
+	return -1;
+}
 
 int Http_CheckProgress(int reqID) { return -1; }
 
@@ -54,6 +60,7 @@ struct IGameComponent Http_Component = {
 #include "Errors.h"
 #include "PackedCol.h"
 #include "SSL.h"
+#include "Deflate.h"
 
 /*########################################################################################################################*
 *---------------------------------------------------------HttpUrl---------------------------------------------------------*
@@ -235,46 +242,80 @@ static cc_result HttpConnection_Write(struct HttpConnection* conn, const cc_uint
 /*########################################################################################################################*
 *-----------------------------------------------------Connection Pool-----------------------------------------------------*
 *#########################################################################################################################*/
+/* NOTE: There must always be more entries than HTTP worker threads */
 static struct ConnectionPoolEntry {
 	struct HttpConnection conn;
 	cc_string addr;
 	char addrBuffer[STRING_SIZE];
 	cc_bool https;
+	cc_bool inUse; /* Whether a worker thread is currently using this connection */
 } connection_pool[10];
+static void* poolMutex;
 
-static cc_result ConnectionPool_Insert(int i, struct HttpConnection** conn, const struct HttpUrl* url) {
-	struct ConnectionPoolEntry* e = &connection_pool[i];
-	*conn = &e->conn;
-
-	String_InitArray(e->addr, e->addrBuffer);
-	String_Copy(&e->addr, &url->address);
-	e->https = url->https;
-	return HttpConnection_Open(&e->conn, url);
+static cc_bool ConnectionPool_Matches(struct ConnectionPoolEntry* e, const struct HttpUrl* url) {
+	return e->conn.valid && e->https == url->https && String_Equals(&e->addr, &url->address);
 }
 
-static cc_result ConnectionPool_Open(struct HttpConnection** conn, const struct HttpUrl* url) {
+/* Finds an idle connection to the given address, or otherwise an entry to open a new connection in */
+static struct ConnectionPoolEntry* ConnectionPool_Find(const struct HttpUrl* url) {
 	struct ConnectionPoolEntry* e;
-	int i;
+	int i, beg;
 
 	for (i = 0; i < Array_Elems(connection_pool); i++)
 	{
 		e = &connection_pool[i];
-		if (e->conn.valid && e->https == url->https && String_Equals(&e->addr, &url->address)) {
-			*conn = &connection_pool[i].conn;
-			return 0;
-		}
+		if (!e->inUse && ConnectionPool_Matches(e, url)) return e;
 	}
 
 	for (i = 0; i < Array_Elems(connection_pool); i++)
 	{
 		e = &connection_pool[i];
-		if (!e->conn.valid) return ConnectionPool_Insert(i, conn, url);
+		if (!e->inUse && !e->conn.valid) return e;
 	}
 
 	/* TODO: Should we be consistent in which entry gets evicted? */
-	i = (cc_uint8)Stopwatch_Measure() % Array_Elems(connection_pool);
-	HttpConnection_Close(&connection_pool[i].conn);
-	return ConnectionPool_Insert(i, conn, url);
+	beg = (cc_uint8)Stopwatch_Measure();
+	for (i = 0; i < Array_Elems(connection_pool); i++)
+	{
+		e = &connection_pool[(beg + i) % Array_Elems(connection_pool)];
+		if (!e->inUse) return e;
+	}
+	return NULL;
+}
+
+static cc_result ConnectionPool_Open(struct HttpConnection** conn, const struct HttpUrl* url) {
+	struct ConnectionPoolEntry* e;
+
+	Mutex_Lock(poolMutex);
+	{
+		e = ConnectionPool_Find(url);
+		if (e) e->inUse = true;
+	}
+	Mutex_Unlock(poolMutex);
+
+	if (!e) Process_Abort("All HTTP connections in use");
+	*conn = &e->conn;
+	if (ConnectionPool_Matches(e, url)) return 0;
+
+	/* Connecting is done outside the lock, so other workers aren't blocked by slow handshakes */
+	if (e->conn.valid) HttpConnection_Close(&e->conn);
+	String_InitArray(e->addr, e->addrBuffer);
+	String_Copy(&e->addr, &url->address);
+	e->https = url->https;
+	return HttpConnection_Open(&e->conn, url);
+}
+
+/* Makes the given connection available for use by other requests */
+static void ConnectionPool_Release(struct HttpConnection* conn) {
+	int i;
+	Mutex_Lock(poolMutex);
+	{
+		for (i = 0; i < Array_Elems(connection_pool); i++)
+		{
+			if (&connection_pool[i].conn == conn) connection_pool[i].inUse = false;
+		}
+	}
+	Mutex_Unlock(poolMutex);
 }
 
 
@@ -303,12 +344,35 @@ enum HTTP_RESPONSE_STATE {
 	#define SEND_BUFFER_LEN  16384
 #endif
 
+/* Responses are requested to be gzip compressed, and are then decompressed as they arrive */
+/* NOTE: Not requested on systems with very little memory, as inflating needs ~50 KB */
+#ifndef CC_BUILD_TINYMEM
+	#define HTTP_ACCEPT_GZIP
+#endif
+/* Minimum amount the response data buffer is expanded by when decompressing */
+#define HTTP_GZIP_MIN_EXPAND 8192
+
+struct HttpGZipState {
+	struct InflateState inflate;
+	struct GZipHeader header;
+	struct Stream stream;     /* Decompresses data from part */
+	struct Stream part;       /* Compressed data currently being decompressed */
+	cc_uint32 compressedRead; /* Number of compressed bytes received so far */
+	cc_uint8 output[HTTP_GZIP_MIN_EXPAND]; /* Decompressed data, when saving to a file */
+};
+
 struct HttpClientState {
 	enum HTTP_RESPONSE_STATE state;
 	struct HttpConnection* conn;
 	struct HttpRequest* req;
 	cc_uint32 dataLeft; /* Number of bytes still to read from the current chunk or body */
 	cc_bool chunked;    /* Whether content is being transferred using HTTP chunks */
+	cc_bool gzipped;    /* Whether content is compressed using gzip Content-Encoding */
+	cc_bool saving;     /* Whether content is being saved to file instead of buffered in memory */
+	struct HttpGZipState* gz; /* Allocated on demand, when a response is compressed */
+	struct Stream file;       /* File content is being saved to */
+	const cc_string* savePath; /* File content is saved to instead of being buffered in memory (if not empty) */
+	cc_string tempPath; /* File content is saved to, before replacing the destination file once complete */
 	cc_bool autoClose;  /* TODO Whether connection should be dropped after request completed */
 	cc_bool retried;    /* Whether request has been retried due to SSL context being closed/dropped */
 	cc_uint8 redirects; /* Number of times current HTTP request has been redirected */
@@ -317,11 +381,13 @@ struct HttpClientState {
 	struct HttpUrl url; /* Current URL (may not be same as original URL after redirecting) */
 	char _headerBuffer[HTTP_HEADER_MAX_LENGTH];
 	char _locationBuffer[HTTP_LOCATION_MAX_LENGTH];
+	char _tempPathBuffer[FILENAME_SIZE];
 };
 
 static void HttpClientState_Reset(struct HttpClientState* state) {
 	state->state     = HTTP_RESPONSE_STATE_INITIAL;
 	state->chunked   = false;
+	state->gzipped   = false;
 	state->dataLeft  = 0;
 	state->autoClose = false;
 
@@ -329,11 +395,15 @@ static void HttpClientState_Reset(struct HttpClientState* state) {
 	String_InitArray(state->location, state->_locationBuffer);
 }
 
-static void HttpClientState_Init(struct HttpClientState* state, struct HttpRequest* req) {
+static void HttpClientState_Init(struct HttpClientState* state, struct HttpRequest* req, const cc_string* savePath) {
 	cc_string url    = String_FromRawArray(req->url);
 	state->req       = req;
+	state->savePath  = savePath;
 	state->retried   = false;
 	state->redirects = 0;
+	state->gz        = NULL;
+	state->saving    = false;
+	String_InitArray(state->tempPath, state->_tempPathBuffer);
 
 	HttpUrl_Parse(&url, &state->url);
 	HttpClientState_Reset(state);
@@ -342,16 +412,25 @@ static void HttpClientState_Init(struct HttpClientState* state, struct HttpReque
 
 static void HttpClient_Serialise(struct HttpClientState* state) {
 	static const char* verbs[] = { "GET", "HEAD", "POST" };
+#ifdef HTTP_ACCEPT_GZIP
+	static const cc_string gzip = String_FromConst("gzip");
+#endif
+	cc_string userAgent; char userAgentBuffer[STRING_SIZE];
 
 	struct HttpRequest* req = state->req;
 	cc_string* buffer = (cc_string*)req->meta;
+	String_InitArray(userAgent, userAgentBuffer);
+	Http_GetUserAgent(&userAgent);
 	/* TODO move to other functions */
 	/* Write request message headers */
 	String_Format2(buffer, "%c %s HTTP/1.1\r\n",
 					verbs[req->requestType], &state->url.resource);
 
 	Http_AddHeader(req, "Host",       &state->url.address);
-	Http_AddHeader(req, "User-Agent", Http_GetUserAgent_UNSAFE());
+	Http_AddHeader(req, "User-Agent", &userAgent);
+#ifdef HTTP_ACCEPT_GZIP
+	Http_AddHeader(req, "Accept-Encoding", &gzip);
+#endif
 	if (req->data) String_Format1(buffer, "Content-Length: %i\r\n", &req->size);
 
 	Http_SetRequestHeaders(req);
@@ -389,6 +468,8 @@ static void HttpClient_ParseHeader(struct HttpClientState* state, const cc_strin
 
 	if (String_CaselessEqualsConst(&name, "Transfer-Encoding")) {
 		state->chunked = String_CaselessEqualsConst(&value, "chunked");
+	} else if (String_CaselessEqualsConst(&name, "Content-Encoding")) {
+		state->gzipped = String_CaselessEqualsConst(&value, "gzip");
 	} else if (String_CaselessEqualsConst(&name, "Location")) {
 		String_Copy(&state->location, &value);
 	} else if (String_CaselessEqualsConst(&name, "Connection")) {
@@ -439,11 +520,130 @@ static int HttpClient_GetChunkLength(const cc_string* line) {
 	return length;
 }
 
+/* RFC 9110, section 8.4 - Content-Encoding */
+static cc_result HttpClient_BeginInflate(struct HttpClientState* state) {
+	struct HttpGZipState* gz = state->gz;
+	if (!gz) {
+		gz = (struct HttpGZipState*)Mem_TryAlloc(1, sizeof(struct HttpGZipState));
+		if (!gz) return ERR_OUT_OF_MEMORY;
+		state->gz = gz;
+	}
+
+	Inflate_MakeStream2(&gz->stream, &gz->inflate, &gz->part);
+	GZipHeader_Init(&gz->header);
+	gz->compressedRead = 0;
+	return 0;
+}
+
+static cc_result HttpClient_EndSave(struct HttpClientState* state) {
+	if (!state->saving) return 0;
+	state->saving = false;
+	return state->file.Close(&state->file);
+}
+
+/* Prepares to save the content to a file, if the request asked for that */
+/* NOTE: Content is saved to "[file].tmp" first, so that an incomplete download */
+/*  never leaves the destination file partially written */
+static cc_result HttpClient_BeginSave(struct HttpClientState* state) {
+	struct HttpRequest* req = state->req;
+	cc_filepath raw_path;
+	cc_result res;
+	/* Don't let e.g. the contents of a 404 error page overwrite the file */
+	if (!state->savePath->length || req->statusCode != 200) return 0;
+
+	/* Request might be getting retried after the connection was dropped */
+	HttpClient_EndSave(state);
+	req->size = 0;
+
+	state->tempPath.length = 0;
+	String_Format1(&state->tempPath, "%s.tmp", state->savePath);
+	Platform_EncodePath(&raw_path, &state->tempPath);
+	if ((res = Stream_CreatePath(&state->file, &raw_path))) return res;
+
+	state->saving = true;
+	return 0;
+}
+
+/* Replaces the destination file with the temp file if the content was completely downloaded, */
+/*  otherwise just deletes the temp file */
+static cc_result HttpClient_FinishSave(struct HttpClientState* state, cc_result res) {
+	struct HttpRequest* req = state->req;
+	cc_filepath raw_temp, raw_path;
+	if (!state->tempPath.length) return res;
+	Platform_EncodePath(&raw_temp, &state->tempPath);
+
+	if (res || req->statusCode != 200 || !req->size) {
+		(void)File_Delete(&raw_temp);
+		return res;
+	}
+
+	Platform_EncodePath(&raw_path, state->savePath);
+	if ((res = File_Rename(&raw_temp, &raw_path))) (void)File_Delete(&raw_temp);
+	return res;
+}
+
+/* Adds the given data to the content, which is either saved to file or buffered in memory */
+/* NOTE: When buffering in memory, the data buffer must have already been expanded */
+static cc_result HttpClient_AddContent(struct HttpClientState* state, const cc_uint8* data, cc_uint32 len) {
+	struct HttpRequest* req = state->req;
+	cc_result res;
+
+	if (state->saving) {
+		if ((res = Stream_Write(&state->file, data, len))) return res;
+	} else {
+		Mem_Copy(req->data + req->size, data, len);
+	}
+
+	Http_BufferExpanded(req, len);
+	return 0;
+}
+
+/* Decompresses the given part of the gzip compressed content */
+static cc_result HttpClient_Inflate(struct HttpClientState* state, cc_uint8* data, cc_uint32 len) {
+	struct HttpGZipState* gz = state->gz;
+	struct HttpRequest* req  = state->req;
+	cc_uint32 read, avail;
+	cc_uint8* dst;
+	cc_result res;
+
+	/* Progress is based on the compressed data, since Content-Length is the compressed size */
+	gz->compressedRead += len;
+	if (req->contentLength) req->progress = (int)(100.0f * gz->compressedRead / req->contentLength);
+	Stream_ReadonlyMemory(&gz->part, data, len);
+
+	if (!gz->header.done) {
+		res = GZipHeader_Read(&gz->part, &gz->header);
+		if (res && res != ERR_END_OF_STREAM) return res;
+		if (!gz->header.done) return 0;
+	}
+
+	for (;;) 
+	{
+		if (state->saving) {
+			dst   = gz->output;
+			avail = sizeof(gz->output);
+		} else {
+			if (!Http_BufferExpand(req, max(req->size, HTTP_GZIP_MIN_EXPAND))) return ERR_OUT_OF_MEMORY;
+			dst   = req->data + req->size;
+			avail = req->_capacity - req->size;
+		}
+
+		res = gz->stream.Read(&gz->stream, dst, avail, &read);
+		if (res) return res;
+
+		/* All of the compressed data has been decompressed */
+		if (!read) return 0;
+		if (state->saving && (res = Stream_Write(&state->file, dst, read))) return res;
+		req->size += read;
+	}
+}
+
 /* https://httpwg.org/specs/rfc7230.html */
 static cc_result HttpClient_Process(struct HttpClientState* state, char* buffer, int total) {
 	struct HttpRequest* req = state->req;
 	cc_uint32 left, avail, read;
 	int offset = 0, chunkLen, ok;
+	cc_result res;
 
 	while (offset < total) {
 		switch (state->state) {
@@ -470,10 +670,17 @@ static cc_result HttpClient_Process(struct HttpClientState* state, char* buffer,
 				if (state->header.length == 0) {
 					state->state = HttpClient_BeginBody(req, state);
 
+					if (state->state != HTTP_RESPONSE_STATE_DONE) {
+						if ((res = HttpClient_BeginSave(state))) return res;
+					}
+					if (state->gzipped && state->state != HTTP_RESPONSE_STATE_DONE) {
+						if ((res = HttpClient_BeginInflate(state))) return res;
+					}
+
 					/* The rest of the request body is just content/data */
 					if (state->state == HTTP_RESPONSE_STATE_DATA) {
 						state->dataLeft = req->contentLength;
-						ok = Http_BufferExpand(req, state->dataLeft);
+						ok = state->saving || Http_BufferExpand(req, state->dataLeft);
 						if (!ok) return ERR_OUT_OF_MEMORY;
 					}
 					break;
@@ -492,8 +699,12 @@ static cc_result HttpClient_Process(struct HttpClientState* state, char* buffer,
 			avail = state->dataLeft;
 			read  = min(left, avail);
 
-			Mem_Copy(req->data + req->size, buffer + offset, read);
-			Http_BufferExpanded(req, read); 
+			if (state->gzipped) {
+				res = HttpClient_Inflate(state, (cc_uint8*)buffer + offset, read);
+			} else {
+				res = HttpClient_AddContent(state, (cc_uint8*)buffer + offset, read);
+			}
+			if (res) return res;
 
 			state->dataLeft -= read;
 			offset += read;
@@ -524,7 +735,7 @@ static cc_result HttpClient_Process(struct HttpClientState* state, char* buffer,
 					state->state = HTTP_RESPONSE_STATE_DATA;
 
 					state->dataLeft = chunkLen;
-					ok = Http_BufferExpand(req, state->dataLeft);
+					ok = state->saving || Http_BufferExpand(req, state->dataLeft);
 					if (!ok) return ERR_OUT_OF_MEMORY;
 				}
 				break;
@@ -580,7 +791,8 @@ static cc_result HttpClient_ParseResponse(struct HttpClientState* state) {
 
 	for (;;) 
 	{
-		dst = state->dataLeft > INPUT_BUFFER_LEN ? (req->data + req->size) : buffer;
+		/* Compressed or saved data always has to be handled by the HTTP client state machine */
+		dst = state->dataLeft > INPUT_BUFFER_LEN && !state->gzipped && !state->saving ? (req->data + req->size) : buffer;
 		res = HttpConnection_Read(state->conn, dst, INPUT_BUFFER_LEN, &total);
 		if (res) return res;
 
@@ -624,6 +836,7 @@ static cc_result HttpClient_HandleRedirect(struct HttpClientState* state) {
 *#########################################################################################################################*/
 static void HttpBackend_Init(void) {
 	SSLBackend_Init(httpsVerify);
+	poolMutex = Mutex_Create("HTTP connections");
 }
 
 static void Http_AddHeader(struct HttpRequest* req, const char* key, const cc_string* value) {
@@ -634,22 +847,19 @@ static cc_result HttpBackend_PerformRequest(struct HttpClientState* state) {
 	cc_result res;
 
 	res = ConnectionPool_Open(&state->conn, &state->url);
-	if (res) { HttpConnection_Close(state->conn); return res; }
-
-	res = HttpClient_SendRequest(state);
-	if (res) { HttpConnection_Close(state->conn); return res; }
+	if (!res) res = HttpClient_SendRequest(state);
+	if (!res) res = HttpClient_ParseResponse(state);
 
-	res = HttpClient_ParseResponse(state);
 	if (res) HttpConnection_Close(state->conn);
-
+	ConnectionPool_Release(state->conn);
 	return res;
 }
 static const char* verbs[] = { "GET", "HEAD", "POST" };
 
-static cc_result HttpBackend_Do(struct HttpRequest* req) {
+static cc_result HttpBackend_Do(struct HttpRequest* req, const cc_string* savePath) {
 	struct HttpClientState state;
-	cc_result res;
-	HttpClientState_Init(&state, req);
+	cc_result res, closeRes;
+	HttpClientState_Init(&state, req, savePath);
 
 	for (;;) {
 		Platform_Log4("Fetching %c%s%s (%c)", state.url.https ? "https://" : "http://", 
@@ -674,7 +884,7 @@ static cc_result HttpBackend_Do(struct HttpRequest* req) {
 		}
 
 		if (res || !HttpClient_IsRedirect(req)) break;
-		if (state.redirects >= 20) return HTTP_ERR_REDIRECTS;
+		if (state.redirects >= 20) { res = HTTP_ERR_REDIRECTS; break; }
 
 		/* TODO FOLLOW LOCATION PROPERLY */
 		state.redirects++;
@@ -682,7 +892,10 @@ static cc_result HttpBackend_Do(struct HttpRequest* req) {
 		if (res) break;
 		HttpClientState_Reset(&state);
 	}
-	return res;
+
+	Mem_Free(state.gz);
+	closeRes = HttpClient_EndSave(&state);
+	return HttpClient_FinishSave(&state, res ? res : closeRes);
 }
 
 static cc_bool HttpBackend_DescribeError(cc_result res, cc_string* dst) {
@@ -691,14 +904,43 @@ static cc_bool HttpBackend_DescribeError(cc_result res, cc_string* dst) {
 #endif
 
 
+#if defined CC_BUILD_LOWMEM || defined CC_BUILD_COOPTHREADED
+	#define HTTP_MAX_WORKERS 1
+	#define HTTP_DEF_WORKERS 1
+#else
+	#define HTTP_MAX_WORKERS 8
+	#define HTTP_DEF_WORKERS 4
+#endif
 static void* workerWaitable;
-static void* workerThread;
+static void* workerThreads[HTTP_MAX_WORKERS];
+static int http_numWorkers, http_hostLimit, http_nextWorker;
 
 static void* pendingMutex;
 static struct RequestList pendingReqs;
+/* Host of the request each worker is processing (empty when idle), protected by pendingMutex */
+static cc_string workerHosts[HTTP_MAX_WORKERS];
+static char workerHostBuffers[HTTP_MAX_WORKERS][STRING_SIZE];
+/* Files the contents of pending requests are saved to, as "[request id] [path]" entries, protected by pendingMutex */
+static struct StringsBuffer savePaths;
+
+/* Removes the file the given request's contents are saved to, copying it into dst (if not NULL) */
+/* NOTE: pendingMutex must be held when calling this */
+static void TakeSavePath(int reqID, cc_string* dst) {
+	cc_string key; char keyBuffer[STRING_INT_CHARS];
+	cc_string path;
+	if (!savePaths.count) return;
+
+	String_InitArray(key, keyBuffer);
+	String_AppendInt(&key, reqID);
+	path = EntryList_UNSAFE_Get(&savePaths, &key, ' ');
+
+	if (dst) String_Copy(dst, &path);
+	EntryList_Remove(&savePaths, &key, ' ');
+}
 
 static void* curRequestMutex;
-static struct HttpRequest http_curRequest;
+/* The request each worker is currently processing, protected by curRequestMutex */
+static struct HttpRequest http_curRequests[HTTP_MAX_WORKERS];
 
 
 /*########################################################################################################################*
@@ -717,20 +959,37 @@ cc_bool Http_GetResult(int reqID, struct HttpRequest* item) {
 }
 
 cc_bool Http_GetCurrent(int* reqID, int* progress) {
+	int i;
+	*reqID    = 0;
+	*progress = HTTP_PROGRESS_NOT_WORKING_ON;
+
 	Mutex_Lock(curRequestMutex);
 	{
-		*reqID    = http_curRequest.id;
-		*progress = http_curRequest.progress;
+		for (i = 0; i < HTTP_MAX_WORKERS; i++)
+		{
+			if (!http_curRequests[i].id) continue;
+			*reqID    = http_curRequests[i].id;
+			*progress = http_curRequests[i].progress;
+			break;
+		}
 	}
 	Mutex_Unlock(curRequestMutex);
 	return *reqID != 0;
 }
 
 int Http_CheckProgress(int reqID) {
-	int curReqID, progress;
-	Http_GetCurrent(&curReqID, &progress);
+	int i, progress = HTTP_PROGRESS_NOT_WORKING_ON;
 
-	if (reqID != curReqID) progress = HTTP_PROGRESS_NOT_WORKING_ON;
+	Mutex_Lock(curRequestMutex);
+	{
+		for (i = 0; i < HTTP_MAX_WORKERS; i++)
+		{
+			if (http_curRequests[i].id != reqID) continue;
+			progress = http_curRequests[i].progress;
+			break;
+		}
+	}
+	Mutex_Unlock(curRequestMutex);
 	return progress;
 }
 
@@ -738,6 +997,7 @@ void Http_ClearPending(void) {
 	Mutex_Lock(pendingMutex);
 	{
 		RequestList_Free(&pendingReqs);
+		StringsBuffer_Clear(&savePaths);
 	}
 	Mutex_Unlock(pendingMutex);
 }
@@ -746,6 +1006,7 @@ void Http_TryCancel(int reqID) {
 	Mutex_Lock(pendingMutex);
 	{
 		RequestList_TryFree(&pendingReqs, reqID);
+		TakeSavePath(reqID, NULL);
 	}
 	Mutex_Unlock(pendingMutex);
 
@@ -761,21 +1022,21 @@ void Http_TryCancel(int reqID) {
 *-----------------------------------------------------Http worker---------------------------------------------------------*
 *#########################################################################################################################*/
 /* Sets up state to begin a http request */
-static void SetCurrentRequest(struct HttpRequest* req) {
+static void SetCurrentRequest(struct HttpRequest* req, int worker) {
 	Mutex_Lock(curRequestMutex);
 	{
-		HttpRequest_Copy(&http_curRequest, req);
-		http_curRequest.progress = HTTP_PROGRESS_MAKING_REQUEST;
+		HttpRequest_Copy(&http_curRequests[worker], req);
+		http_curRequests[worker].progress = HTTP_PROGRESS_MAKING_REQUEST;
 	}
 	Mutex_Unlock(curRequestMutex);
 }
 
-static void PerformRequest(struct HttpRequest* req) {
+static void PerformRequest(struct HttpRequest* req, const cc_string* savePath) {
 	cc_uint64 beg, end;
 	int elapsed;
 
 	beg = Stopwatch_Measure();
-	req->result = HttpBackend_Do(req);
+	req->result = HttpBackend_Do(req, savePath);
 	end = Stopwatch_Measure();
 
 	elapsed = Stopwatch_ElapsedMS(beg, end);
@@ -785,40 +1046,90 @@ static void PerformRequest(struct HttpRequest* req) {
 	Http_FinishRequest(req);
 }
 
-static void ClearCurrentRequest(void) {
+static void ClearCurrentRequest(int worker) {
 	Mutex_Lock(curRequestMutex);
 	{
-		http_curRequest.id       = 0;
-		http_curRequest.progress = HTTP_PROGRESS_NOT_WORKING_ON;
+		http_curRequests[worker].id       = 0;
+		http_curRequests[worker].progress = HTTP_PROGRESS_NOT_WORKING_ON;
 	}
 	Mutex_Unlock(curRequestMutex);
 }
 
-static void DoRequest(struct HttpRequest* request) {
-	SetCurrentRequest(request);
-	PerformRequest(&http_curRequest);
-	ClearCurrentRequest();
+static void DoRequest(struct HttpRequest* request, int worker, const cc_string* savePath) {
+	SetCurrentRequest(request, worker);
+	PerformRequest(&http_curRequests[worker], savePath);
+	ClearCurrentRequest(worker);
+}
+
+/* Returns the host portion of a request's URL, e.g. "example.com:8080" for "http://example.com:8080/a.png" */
+static cc_string GetRequestHost(struct HttpRequest* req) {
+	cc_string host = String_FromRawArray(req->url);
+	int i = String_IndexOfConst(&host, "://");
+
+	if (i >= 0) host = String_UNSAFE_SubstringAt(&host, i + 3);
+	i = String_IndexOf(&host, '/');
+	if (i >= 0) host.length = i;
+	return host;
+}
+
+/* Finds the first pending request whose host isn't already at the connection limit */
+/* NOTE: pendingMutex must be held when calling this */
+static int NextPendingRequest(void) {
+	cc_string host;
+	int i, j, active;
+
+	for (i = 0; i < pendingReqs.count; i++)
+	{
+		host   = GetRequestHost(&pendingReqs.entries[i]);
+		active = 0;
+
+		for (j = 0; j < http_numWorkers; j++)
+		{
+			if (String_CaselessEquals(&workerHosts[j], &host)) active++;
+		}
+		if (active < http_hostLimit) return i;
+	}
+	return -1;
 }
 
 static void WorkerLoop(void) {
+	cc_string savePath; char savePathBuffer[FILENAME_SIZE];
 	struct HttpRequest request;
-	cc_bool hasRequest;
+	cc_bool hasRequest, hasMore = false;
+	cc_string host;
+	int i, worker;
 
-	for (;;) {
-		hasRequest = false;
+	Mutex_Lock(pendingMutex);
+	{
+		worker = http_nextWorker++;
+	}
+	Mutex_Unlock(pendingMutex);
 
+	for (;;) {
 		Mutex_Lock(pendingMutex);
 		{
-			if (pendingReqs.count) {
-				HttpRequest_Copy(&request, &pendingReqs.entries[0]);
-				hasRequest = true;
-				RequestList_RemoveAt(&pendingReqs, 0);
+			workerHosts[worker].length = 0;
+			i = NextPendingRequest();
+			hasRequest = i >= 0;
+
+			if (hasRequest) {
+				HttpRequest_Copy(&request, &pendingReqs.entries[i]);
+				RequestList_RemoveAt(&pendingReqs, i);
+
+				String_InitArray(savePath, savePathBuffer);
+				TakeSavePath(request.id, &savePath);
+
+				host = GetRequestHost(&request);
+				String_Copy(&workerHosts[worker], &host);
+				hasMore = NextPendingRequest() >= 0;
 			}
 		}
 		Mutex_Unlock(pendingMutex);
 
 		if (hasRequest) {
-			DoRequest(&request);
+			/* Wake up another worker if there are still requests it could start on */
+			if (hasMore) Waitable_Signal(workerWaitable);
+			DoRequest(&request, worker, &savePath);
 		} else {
 			/* Block until another thread submits a request to do */
 			Platform_LogConst("Download queue empty, going back to sleep...");
@@ -828,14 +1139,22 @@ static void WorkerLoop(void) {
 }
 
 /* Adds a req to the list of pending requests, waking up worker thread if needed */
-static void HttpBackend_Add(struct HttpRequest* req, cc_uint8 flags) {
+static void HttpBackend_Add(struct HttpRequest* req, cc_uint8 flags, const cc_string* savePath) {
 #if defined CC_BUILD_PSP || defined CC_BUILD_NDS
 	/* TODO why doesn't threading work properly on PSP */
-	DoRequest(req);
+	DoRequest(req, 0, savePath ? savePath : &String_Empty);
 #else
+	cc_string key; char keyBuffer[STRING_INT_CHARS];
+
 	Mutex_Lock(pendingMutex);
 	{
 		RequestList_Append(&pendingReqs, req, flags);
+
+		if (savePath && savePath->length) {
+			String_InitArray(key, keyBuffer);
+			String_AppendInt(&key, req->id);
+			EntryList_Set(&savePaths, &key, savePath, ' ');
+		}
 	}
 	Mutex_Unlock(pendingMutex);
 	Waitable_Signal(workerWaitable);
@@ -846,10 +1165,18 @@ static void HttpBackend_Add(struct HttpRequest* req, cc_uint8 flags) {
 *-----------------------------------------------------Http component------------------------------------------------------*
 *#########################################################################################################################*/
 static void Http_Init(void) {
+	int i;
 	Http_InitCommon();
-	http_curRequest.progress = HTTP_PROGRESS_NOT_WORKING_ON;
+	for (i = 0; i < HTTP_MAX_WORKERS; i++)
+	{
+		http_curRequests[i].progress = HTTP_PROGRESS_NOT_WORKING_ON;
+	}
 	/* Http component gets initialised multiple times on Android */
-	if (workerThread) return;
+	if (workerThreads[0]) return;
+
+	/* Several workers avoid e.g. skin downloads having to wait for one another on busy servers */
+	http_numWorkers = Options_GetInt(OPT_HTTP_WORKERS,          1, HTTP_MAX_WORKERS, HTTP_DEF_WORKERS);
+	http_hostLimit  = Options_GetInt(OPT_HTTP_HOST_CONNECTIONS, 1, HTTP_MAX_WORKERS, HTTP_DEF_WORKERS);
 
 	HttpBackend_Init();
 	RequestList_Init(&pendingReqs);
@@ -859,7 +1186,12 @@ static void Http_Init(void) {
 	pendingMutex    = Mutex_Create("HTTP pending");
 	processedMutex  = Mutex_Create("HTTP processed");
 	curRequestMutex = Mutex_Create("HTTP current");
-	
-	Thread_Run(&workerThread, WorkerLoop, 128 * 1024, "HTTP");
+	cookieMutex     = Mutex_Create("HTTP cookies");
+
+	for (i = 0; i < http_numWorkers; i++)
+	{
+		String_InitArray(workerHosts[i], workerHostBuffers[i]);
+		Thread_Run(&workerThreads[i], WorkerLoop, 128 * 1024, "HTTP");
+	}
 }
 #endif
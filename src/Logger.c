@@ -120,6 +120,11 @@ static const char* GetCCErrorDesc(cc_result res) {
 	case SOCK_ERR_UNKNOWN_HOST: return "Host could not be resolved to an IP address";
 	case ERR_NO_NETWORKING:     return "No working network access";
 	case ERR_NON_WRITABLE_FS:   return "No writable filesystem found";
+
+	case SNAP_ERR_IDENTIFIER: return "Not a ClassiCube snapshot";
+	case SNAP_ERR_VERSION:    return "Unsupported snapshot version";
+	case SNAP_ERR_LAYOUT:     return "Corrupted snapshot header";
+	case DELTA_ERR_CHUNK:     return "Corrupted map delta file";
 	}
 	return NULL;
 }
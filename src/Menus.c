@@ -1359,9 +1359,23 @@ static void SaveLevelScreen_RemoveOverwrites(struct SaveLevelScreen* s) {
 	}
 }
 
+static cc_result DoSaveSnapshot(struct Stream* stream, const cc_filepath* raw_path) {
+	/* Snapshots are uncompressed, so are written straight to the file */
+	cc_result res = Snapshot_Save(stream);
+	if (res) {
+		stream->Close(stream);
+		Logger_IOWarn2(res, "encoding", raw_path); return res;
+	}
+
+	res = stream->Close(stream);
+	if (res) { Logger_IOWarn2(res, "closing", raw_path); return res; }
+	return 0;
+}
+
 static cc_result DoSaveMap(const cc_string* path, struct GZipState* state) {
 	static const cc_string schematic = String_FromConst(".schematic");
 	static const cc_string mine      = String_FromConst(".mine");
+	static const cc_string snapshot  = String_FromConst(".ccsnap");
 	struct Stream stream, compStream;
 	cc_filepath raw_path;
 	cc_result res;
@@ -1369,8 +1383,12 @@ static cc_result DoSaveMap(const cc_string* path, struct GZipState* state) {
 	Platform_EncodePath(&raw_path, path);
 	res = Stream_CreatePath(&stream, &raw_path);
 	if (res) { Logger_IOWarn2(res, "creating", &raw_path); return res; }
+	if (String_CaselessEnds(path, &snapshot)) return DoSaveSnapshot(&stream, &raw_path);
 
-	GZip_MakeStream(&compStream, state, &stream);
+	/* Compressing on multiple threads is much faster for large maps */
+	if (GZip_MakeParallelStream(&compStream, &stream, DEFLATE_LEVEL_DEFAULT)) {
+		GZip_MakeStream(&compStream, state, &stream);
+	}
 
 	if (String_CaselessEnds(path, &schematic)) {
 		res = Schematic_Save(&compStream);
@@ -1381,6 +1399,8 @@ static cc_result DoSaveMap(const cc_string* path, struct GZipState* state) {
 	}
 
 	if (res) {
+		/* Compression stream must still be closed to free its resources */
+		compStream.Close(&compStream);
 		stream.Close(&stream);
 		Logger_IOWarn2(res, "encoding", &raw_path); return res;
 	}
@@ -1408,6 +1428,7 @@ static cc_result SaveLevelScreen_SaveMap(const cc_string* path) {
 	if (res) return res;
 
 	World.LastSave = Game.Time;
+	Autosave_OnSaved(path);
 	Gui_ShowPauseMenu();
 	return 0;
 }
@@ -1452,10 +1473,10 @@ static void SaveLevelScreen_UploadCallback(const cc_string* path) {
 
 static void SaveLevelScreen_File(void* screen, void* b) {
 	static const char* const titles[] = {
-		"ClassiCube map", "Minecraft schematic", "Minecraft classic map", NULL
+		"ClassiCube map", "Minecraft schematic", "Minecraft classic map", "ClassiCube snapshot", NULL
 	};
 	static const char* const filters[] = {
-		".cw", ".schematic", ".mine", NULL
+		".cw", ".schematic", ".mine", ".ccsnap", NULL
 	};
 	struct SaveLevelScreen* s = (struct SaveLevelScreen*)screen;
 	struct SaveFileDialogArgs args;
@@ -1855,7 +1876,7 @@ static void LoadLevelScreen_LoadEntries(struct ListScreen* s) {
 static void LoadLevelScreen_UploadCallback(const cc_string* path) { Map_LoadFrom(path); }
 static void LoadLevelScreen_ActionFunc(void* s, void* w) {
 	static const char* const filters[] = { 
-		".cw", ".dat", ".lvl", ".mine", ".fcm", ".mclevel", NULL 
+		".cw", ".dat", ".lvl", ".mine", ".fcm", ".mclevel", ".ccsnap", NULL 
 	}; /* TODO not hardcode list */
 	static struct OpenFileDialogArgs args = {
 		"Classic map files", filters,
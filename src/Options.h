@@ -16,6 +16,7 @@ Copyright 2014-2025 ClassiCube | Licensed under BSD-3
 
 #define OPT_VIEW_DISTANCE "viewdist"
 #define OPT_BLOCK_PHYSICS "singleplayerphysics"
+#define OPT_AUTOSAVE_INTERVAL "singleplayer-autosave"
 #define OPT_NAMES_MODE "namesmode"
 #define OPT_INVERT_MOUSE "invertmouse"
 #define OPT_SENSITIVITY "mousesensitivity"
@@ -81,11 +82,14 @@ Copyright 2014-2025 ClassiCube | Licensed under BSD-3
 #define OPT_HTTP_ONLY "http-no-https"
 #define OPT_HTTPS_VERIFY "https-verify"
 #define OPT_SKIN_SERVER "http-skinserver"
+#define OPT_HTTP_WORKERS "http-workers"
+#define OPT_HTTP_HOST_CONNECTIONS "http-host-connections"
 #define OPT_RAW_INPUT "win-raw-input"
 #define OPT_DPI_SCALING "win-dpi-scaling"
 #define OPT_GAME_VERSION "game-version"
 #define OPT_INV_SCROLLBAR_SCALE "inv-scrollbar-scale"
 #define OPT_ANAGLYPH3D "anaglyph-3d"
+#define OPT_NET_CAPTURE "net-capture"
 
 #define Option_GetOffsetX(defValue) Options_GetInt("offset-x", 0, 1000, defValue);
 #define Option_GetOffsetY(defValue) Options_GetInt("offset-y", 0, 1000, defValue);
@@ -81,6 +81,11 @@ extern cc_uint8 Platform_Flags;
 CC_API cc_result Process_StartGame2(const cc_string* args, int numArgs);
 /* Terminates the process with the given return code. */
 CC_API void Process_Exit(cc_result code);
+/* Returns the peak amount of physical memory used by the process in bytes, or 0 if unsupported. */
+/* NOTE: Some platforms can't reset this, in which case it is the peak since the process started. */
+cc_uint64 Process_GetPeakMemory(void);
+/* Resets the peak memory usage of the process to its current memory usage, if supported. */
+void Process_ResetPeakMemory(void);
 /* Starts the platform-specific program to open the given url or filename. */
 /* For example, provide a http:// url to open a website in the user's web browser. */
 CC_API cc_result Process_StartOpen(const cc_string* args);
@@ -275,6 +280,12 @@ typedef void (*Directory_EnumCallback)(const cc_string* filename, void* obj, int
 CC_API cc_result Directory_Enum(const cc_string* path, void* obj, Directory_EnumCallback callback);
 /* Returns non-zero if the given file exists. */
 int File_Exists(const cc_filepath* path);
+/* Attempts to rename a file, replacing the destination file if it already exists. */
+/* NOTE: Some platforms instead copy the contents and then empty the source file. */
+cc_result File_Rename(const cc_filepath* src, const cc_filepath* dst);
+/* Attempts to delete a file. */
+/* NOTE: Some platforms instead just empty the file. */
+cc_result File_Delete(const cc_filepath* path);
 void Directory_GetCachePath(cc_string* path);
 
 /* Attempts to create a new (or overwrite) file for writing. */
@@ -374,6 +385,9 @@ extern const cc_result ReturnCode_SocketDropped;
 /* Polls if the given socket is currently readable */
 /* NOTE: 'readable' usually means socket either has data available to read, or is closed */
 cc_result Socket_CheckReadable(cc_socket s, cc_bool* readable);
+/* Blocks until the given socket is readable, or until the given number of milliseconds has elapsed */
+/* NOTE: Some platforms instead just poll and then sleep for a short time */
+cc_result Socket_WaitReadable(cc_socket s, int milliseconds, cc_bool* readable);
 /* Checks if the given socket is currently writable */
 /* NOTE: 'writable' usually means socket either has finished connecting, or is closed */
 cc_result Socket_CheckWritable(cc_socket s, cc_bool* writable);
@@ -53,6 +53,13 @@ cc_uint8 Platform_Flags = PLAT_FLAG_SINGLE_PROCESS;
 cc_uint8 Platform_Flags;
 #endif
 cc_bool  Platform_ReadonlyFilesystem;
+
+#if defined CC_BUILD_LINUX || defined CC_BUILD_DARWIN || defined CC_BUILD_BSD
+#define OVERRIDE_PEAK_MEMORY
+#include <sys/resource.h>
+#endif
+#define OVERRIDE_SOCKET_WAIT
+#define OVERRIDE_FILE_RENAME
 #include "_PlatformBase.h"
 
 /* Operating system specific include files */
@@ -312,6 +319,14 @@ int File_Exists(const cc_filepath* path) {
 	return stat(path->buffer, &sb) == 0 && S_ISREG(sb.st_mode);
 }
 
+cc_result File_Rename(const cc_filepath* src, const cc_filepath* dst) {
+	return rename(src->buffer, dst->buffer) == -1 ? errno : 0;
+}
+
+cc_result File_Delete(const cc_filepath* path) {
+	return unlink(path->buffer) == -1 ? errno : 0;
+}
+
 cc_result Directory_Enum(const cc_string* dirPath, void* obj, Directory_EnumCallback callback) {
 	cc_string path; char pathBuffer[FILENAME_SIZE];
 	cc_filepath str;
@@ -812,11 +827,13 @@ void Socket_Close(cc_socket s) {
 #if defined CC_BUILD_DARWIN || defined CC_BUILD_BEOS
 /* poll is broken on old OSX apparently https://daniel.haxx.se/docs/poll-vs-select.html */
 /* BeOS lacks support for poll */
-static cc_result Socket_Poll(cc_socket s, int mode, cc_bool* success) {
+static cc_result Socket_Poll(cc_socket s, int mode, int milliseconds, cc_bool* success) {
 	fd_set set;
-	struct timeval time = { 0 };
+	struct timeval time;
 	int selectCount;
 
+	time.tv_sec  = milliseconds / 1000;
+	time.tv_usec = (milliseconds % 1000) * 1000;
 	FD_ZERO(&set);
 	FD_SET(s, &set);
 
@@ -831,13 +848,13 @@ static cc_result Socket_Poll(cc_socket s, int mode, cc_bool* success) {
 }
 #else
 #include <poll.h>
-static cc_result Socket_Poll(cc_socket s, int mode, cc_bool* success) {
+static cc_result Socket_Poll(cc_socket s, int mode, int milliseconds, cc_bool* success) {
 	struct pollfd pfd;
 	int flags;
 
 	pfd.fd     = s;
 	pfd.events = mode == SOCKET_POLL_READ ? POLLIN : POLLOUT;
-	if (poll(&pfd, 1, 0) == -1) { *success = false; return errno; }
+	if (poll(&pfd, 1, milliseconds) == -1) { *success = false; return errno; }
 	
 	/* to match select, closed socket still counts as readable */
 	flags    = mode == SOCKET_POLL_READ ? (POLLIN | POLLHUP) : POLLOUT;
@@ -847,11 +864,15 @@ static cc_result Socket_Poll(cc_socket s, int mode, cc_bool* success) {
 #endif
 
 cc_result Socket_CheckReadable(cc_socket s, cc_bool* readable) {
-	return Socket_Poll(s, SOCKET_POLL_READ, readable);
+	return Socket_Poll(s, SOCKET_POLL_READ, 0, readable);
+}
+
+cc_result Socket_WaitReadable(cc_socket s, int milliseconds, cc_bool* readable) {
+	return Socket_Poll(s, SOCKET_POLL_READ, milliseconds, readable);
 }
 
 cc_result Socket_CheckWritable(cc_socket s, cc_bool* writable) {
-	return Socket_Poll(s, SOCKET_POLL_WRITE, writable);
+	return Socket_Poll(s, SOCKET_POLL_WRITE, 0, writable);
 }
 
 cc_result Socket_GetLastError(cc_socket s) {
@@ -921,6 +942,30 @@ cc_result Process_StartGame2(const cc_string* args, int numArgs) {
 #endif
 void Process_Exit(cc_result code) { exit(code); }
 
+#ifdef OVERRIDE_PEAK_MEMORY
+cc_uint64 Process_GetPeakMemory(void) {
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage)) return 0;
+
+#if defined CC_BUILD_DARWIN
+	return (cc_uint64)usage.ru_maxrss; /* macOS reports in bytes */
+#else
+	return (cc_uint64)usage.ru_maxrss * 1024; /* Linux and BSDs report in kilobytes */
+#endif
+}
+
+void Process_ResetPeakMemory(void) {
+#if defined CC_BUILD_LINUX
+	/* Writing 5 to clear_refs resets the peak RSS to the current RSS (Linux 4.0+) */
+	int fd = open("/proc/self/clear_refs", O_WRONLY);
+	if (fd == -1) return;
+
+	(void)!write(fd, "5", 1);
+	close(fd);
+#endif
+}
+#endif
+
 /* Opening browser/starting shell is not really standardised */
 #if defined CC_BUILD_ANDROID
 /* Implemented in Platform_Android.c */
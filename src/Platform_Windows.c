@@ -8,6 +8,8 @@
 #include "Utils.h"
 #include "Errors.h"
 #define OVERRIDE_MEM_FUNCTIONS
+#define OVERRIDE_SOCKET_WAIT
+#define OVERRIDE_FILE_RENAME
 
 #define WIN32_LEAN_AND_MEAN
 #define NOSERVICE
@@ -296,6 +298,25 @@ int File_Exists(const cc_filepath* path) {
 	return attribs != INVALID_FILE_ATTRIBUTES && !(attribs & FILE_ATTRIBUTE_DIRECTORY);
 }
 
+cc_result File_Rename(const cc_filepath* src, const cc_filepath* dst) {
+	cc_result res;
+	if (MoveFileExW(src->uni, dst->uni, MOVEFILE_REPLACE_EXISTING)) return 0;
+	if ((res = GetLastError()) != ERROR_CALL_NOT_IMPLEMENTED) return res;
+
+	/* Windows 9x does not support MoveFileEx or W API functions */
+	DeleteFileA(dst->ansi);
+	return MoveFileA(src->ansi, dst->ansi) ? 0 : GetLastError();
+}
+
+cc_result File_Delete(const cc_filepath* path) {
+	cc_result res;
+	if (DeleteFileW(path->uni)) return 0;
+	if ((res = GetLastError()) != ERROR_CALL_NOT_IMPLEMENTED) return res;
+
+	/* Windows 9x does not support W API functions */
+	return DeleteFileA(path->ansi) ? 0 : GetLastError();
+}
+
 static cc_result Directory_EnumCore(const cc_string* dirPath, const cc_string* file, DWORD attribs,
 									void* obj, Directory_EnumCallback callback) {
 	cc_string path; char pathBuffer[MAX_PATH + 10];
@@ -699,11 +720,14 @@ void Socket_Close(cc_socket s) {
 	_closesocket(s);
 }
 
-static cc_result Socket_Poll(cc_socket s, int mode, cc_bool* success) {
+static cc_result Socket_Poll(cc_socket s, int mode, int milliseconds, cc_bool* success) {
 	fd_set set1, set2;
-	struct timeval time = { 0 };
+	struct timeval time;
 	int selectCount;
 
+	time.tv_sec  = milliseconds / 1000;
+	time.tv_usec = (milliseconds % 1000) * 1000;
+
 	set1.fd_count    = 1; set2.fd_count    = 1;
 	set1.fd_array[0] = s; set2.fd_array[0] = s;
 
@@ -729,11 +753,15 @@ static cc_result Socket_Poll(cc_socket s, int mode, cc_bool* success) {
 }
 
 cc_result Socket_CheckReadable(cc_socket s, cc_bool* readable) {
-	return Socket_Poll(s, SOCKET_POLL_READ, readable);
+	return Socket_Poll(s, SOCKET_POLL_READ, 0, readable);
+}
+
+cc_result Socket_WaitReadable(cc_socket s, int milliseconds, cc_bool* readable) {
+	return Socket_Poll(s, SOCKET_POLL_READ, milliseconds, readable);
 }
 
 cc_result Socket_CheckWritable(cc_socket s, cc_bool* writable) {
-	return Socket_Poll(s, SOCKET_POLL_WRITE, writable);
+	return Socket_Poll(s, SOCKET_POLL_WRITE, 0, writable);
 }
 
 cc_result Socket_GetLastError(cc_socket s) {
@@ -18,6 +18,8 @@
 #include "Model.h"
 #include "Funcs.h"
 #include "Lighting.h"
+#include "EnvRenderer.h"
+#include "MapRenderer.h"
 #include "Http.h"
 #include "Drawer2D.h"
 #include "Logger.h"
@@ -44,8 +46,6 @@ static cc_bool classic_receivedFirstPos;
 /* Map state */
 static cc_bool map_begunLoading;
 static cc_uint64 map_receiveBeg;
-static struct Stream map_part;
-static int map_volume;
 
 /*########################################################################################################################*
 *-----------------------------------------------------CPE extensions------------------------------------------------------*
@@ -346,15 +346,31 @@ static void WoM_Tick(void) {
 *----------------------------------------------------Map decompressor-----------------------------------------------------*
 *#########################################################################################################################*/
 #define MAP_SIZE_LEN 4
+/* Received map data is decompressed on a background thread per blocks array, so that */
+/*  inflating is pipelined with downloading instead of being done on the main thread. */
+/* NOTE: On cooperatively threaded systems, map data is still decompressed on the main thread */
 
 struct MapState {
 	struct InflateState inflateState;
 	struct Stream stream;
+	struct Stream part; /* Data currently being decompressed */
 	BlockRaw* blocks;
 	struct GZipHeader gzHeader;
 	cc_uint8 size[MAP_SIZE_LEN];
-	int index, sizeIndex;
+	volatile int index, volume;
+	int sizeIndex;
 	cc_bool allocFailed;
+#ifndef CC_BUILD_COOPTHREADED
+	Thread_StartFunc workerFunc;
+	void* worker;
+	void* mutex;
+	void* waitable;   /* Signalled when more data is queued, or when no more data will be */
+	cc_uint8* queue;  /* Data received but not yet decompressed */
+	cc_uint8* work;   /* Data being decompressed by the worker thread */
+	cc_uint32 queueLen, queueCap, workCap;
+	cc_bool finished, cancelled;
+	cc_result result; /* Error the worker thread stopped with */
+#endif
 };
 static struct MapState map1;
 #ifdef EXTENDED_BLOCKS
@@ -370,30 +386,11 @@ static void DisconnectInvalidMap(cc_result res) {
 	Game_Disconnect(&title, &tmp); return;
 }
 
-static void MapState_Init(struct MapState* m) {
-	Inflate_MakeStream2(&m->stream, &m->inflateState, &map_part);
-	GZipHeader_Init(&m->gzHeader);
-
-	m->index       = 0;
-	m->blocks      = NULL;
-	m->sizeIndex   = 0;
-	m->allocFailed = false;
-}
-
 static CC_INLINE void MapState_SkipHeader(struct MapState* m) {
 	m->gzHeader.done = true;
 	m->sizeIndex     = MAP_SIZE_LEN;
 }
 
-static void FreeMapStates(void) {
-	Mem_Free(map1.blocks);
-	map1.blocks = NULL;
-#ifdef EXTENDED_BLOCKS
-	Mem_Free(map2.blocks);
-	map2.blocks = NULL;
-#endif
-}
-
 static cc_result MapState_Read(struct MapState* m) {
 	cc_uint32 left, read;
 	cc_result res;
@@ -401,7 +398,7 @@ static cc_result MapState_Read(struct MapState* m) {
 
 	if (m->sizeIndex < MAP_SIZE_LEN) {
 		left = MAP_SIZE_LEN - m->sizeIndex;
-		res  = m->stream.Read(&m->stream, &m->size[m->sizeIndex], left, &read); 
+		res  = m->stream.Read(&m->stream, &m->size[m->sizeIndex], left, &read);
 
 		m->sizeIndex += read;
 		if (res) return res;
@@ -410,25 +407,195 @@ static cc_result MapState_Read(struct MapState* m) {
 		if (m->sizeIndex < MAP_SIZE_LEN) return 0;
 	}
 
-	if (!map_volume) map_volume = Stream_GetU32_BE(m->size);
+	if (!m->volume) m->volume = Stream_GetU32_BE(m->size);
 
 	if (!m->blocks) {
-		m->blocks = (BlockRaw*)Mem_TryAlloc(map_volume, 1);
+		m->blocks = (BlockRaw*)Mem_TryAlloc(m->volume, 1);
 		/* unlikely but possible */
-		if (!m->blocks) {
-			Window_ShowDialog("Out of memory", "Not enough free memory to join that map.\nTry joining a different map.");
-			m->allocFailed = true;
-			return 0;
-		}
+		if (!m->blocks) { m->allocFailed = true; return 0; }
 	}
 
-	left = map_volume - m->index;
+	left = m->volume - m->index;
 	res  = m->stream.Read(&m->stream, &m->blocks[m->index], left, &read);
 
 	m->index += read;
 	return res;
 }
 
+/* Decompresses the given part of the compressed map data */
+static cc_result MapState_Decode(struct MapState* m, cc_uint8* data, cc_uint32 len) {
+	cc_result res;
+	Stream_ReadonlyMemory(&m->part, data, len);
+
+	if (!m->gzHeader.done) {
+		res = GZipHeader_Read(&m->part, &m->gzHeader);
+		if (res && res != ERR_END_OF_STREAM) return res;
+	}
+
+	if (m->gzHeader.done) return MapState_Read(m);
+	return 0;
+}
+
+#ifdef CC_BUILD_COOPTHREADED
+static void MapState_Init(struct MapState* m, Thread_StartFunc workerFunc) { }
+static void MapState_Stop(struct MapState* m, cc_bool cancel) { }
+
+static cc_result MapState_Queue(struct MapState* m, cc_uint8* data, cc_uint32 len) {
+	return MapState_Decode(m, data, len);
+}
+static cc_result MapState_GetResult(struct MapState* m) { return 0; }
+#else
+static void MapState_Work(struct MapState* m) {
+	cc_uint8* data;
+	cc_uint32 len, cap;
+	cc_bool finished, cancelled;
+	cc_result res;
+
+	for (;;)
+	{
+		Mutex_Lock(m->mutex);
+		{
+			/* Swap the queued data with the already decompressed data */
+			data = m->queue; len = m->queueLen; cap = m->queueCap;
+			m->queue    = m->work;
+			m->queueCap = m->workCap;
+			m->queueLen = 0;
+			m->work     = data;
+			m->workCap  = cap;
+
+			finished  = m->finished;
+			cancelled = m->cancelled;
+		}
+		Mutex_Unlock(m->mutex);
+		if (cancelled) return;
+
+		if (len) {
+			if (!(res = MapState_Decode(m, data, len))) continue;
+
+			Mutex_Lock(m->mutex);
+			{
+				m->result = res;
+			}
+			Mutex_Unlock(m->mutex);
+			return;
+		}
+
+		if (finished) return;
+		Waitable_Wait(m->waitable);
+	}
+}
+
+static void MapState_Init(struct MapState* m, Thread_StartFunc workerFunc) {
+	m->workerFunc = workerFunc;
+	m->mutex      = Mutex_Create("Map decompress");
+	m->waitable   = Waitable_Create("Map decompress");
+}
+
+/* Waits for the worker thread to decompress all the queued data, or to stop early if cancelling */
+static void MapState_Stop(struct MapState* m, cc_bool cancel) {
+	if (m->worker) {
+		Mutex_Lock(m->mutex);
+		{
+			m->finished  = true;
+			m->cancelled = cancel;
+		}
+		Mutex_Unlock(m->mutex);
+
+		Waitable_Signal(m->waitable);
+		Thread_Join(m->worker);
+		m->worker = NULL;
+	}
+	if (!m->mutex) return;
+
+	Mutex_Free(m->mutex);
+	Waitable_Free(m->waitable);
+	Mem_Free(m->queue);
+	Mem_Free(m->work);
+
+	m->mutex    = NULL;
+	m->waitable = NULL;
+	m->queue    = NULL;
+	m->work     = NULL;
+}
+
+/* Queues the given part of the compressed map data to be decompressed by the worker thread */
+/* Returns the error the worker thread stopped with, if any */
+static cc_result MapState_Queue(struct MapState* m, cc_uint8* data, cc_uint32 len) {
+	cc_uint8* queue;
+	cc_uint32 cap;
+	cc_result res;
+
+	Mutex_Lock(m->mutex);
+	{
+		res = m->result;
+
+		if (!res && m->queueLen + len > m->queueCap) {
+			cap   = max(m->queueCap * 2, m->queueLen + len);
+			cap   = max(cap, 64 * 1024);
+			queue = (cc_uint8*)Mem_TryRealloc(m->queue, cap, 1);
+
+			if (queue) {
+				m->queue    = queue;
+				m->queueCap = cap;
+			} else {
+				res = ERR_OUT_OF_MEMORY;
+			}
+		}
+
+		if (!res) {
+			Mem_Copy(m->queue + m->queueLen, data, len);
+			m->queueLen += len;
+		}
+	}
+	Mutex_Unlock(m->mutex);
+	if (res) return res;
+
+	if (!m->worker) Thread_Run(&m->worker, m->workerFunc, 64 * 1024, "Map decompress");
+	Waitable_Signal(m->waitable);
+	return 0;
+}
+
+/* NOTE: Only valid after the worker thread has been stopped */
+static cc_result MapState_GetResult(struct MapState* m) { return m->result; }
+#endif
+
+static void MapState_Reset(struct MapState* m, Thread_StartFunc workerFunc) {
+	Mem_Set(m, 0, sizeof(*m));
+	Inflate_MakeStream2(&m->stream, &m->inflateState, &m->part);
+	GZipHeader_Init(&m->gzHeader);
+	MapState_Init(m, workerFunc);
+}
+
+static void MapState_Free(struct MapState* m) {
+	MapState_Stop(m, true);
+	Mem_Free(m->blocks);
+	m->blocks = NULL;
+}
+
+static cc_bool MapStates_AllocFailed(void) {
+#ifdef EXTENDED_BLOCKS
+	if (map2.allocFailed) return true;
+#endif
+	return map1.allocFailed;
+}
+
+static void FreeMapStates(void) {
+	MapState_Free(&map1);
+#ifdef EXTENDED_BLOCKS
+	MapState_Free(&map2);
+#endif
+}
+
+#ifndef CC_BUILD_COOPTHREADED
+static void MapState_Work1(void) { MapState_Work(&map1); }
+#ifdef EXTENDED_BLOCKS
+static void MapState_Work2(void) { MapState_Work(&map2); }
+#endif
+#else
+#define MapState_Work1 NULL
+#define MapState_Work2 NULL
+#endif
+
 
 /*########################################################################################################################*
 *----------------------------------------------------Classic protocol-----------------------------------------------------*
@@ -537,11 +704,12 @@ static void Classic_StartLoading(void) {
 
 	map_begunLoading = true;
 	map_receiveBeg   = Stopwatch_Measure();
-	map_volume       = 0;
 
-	MapState_Init(&map1);
+	/* Discard any partially received map from before */
+	FreeMapStates();
+	MapState_Reset(&map1, MapState_Work1);
 #ifdef EXTENDED_BLOCKS
-	MapState_Init(&map2);
+	MapState_Reset(&map2, MapState_Work2);
 #endif
 }
 
@@ -553,9 +721,10 @@ static void Classic_LevelInit(cc_uint8* data) {
 	if (!IsSupported(fastMap_Ext)) return;
 
 	/* Fast map puts volume in header, and uses raw DEFLATE without GZIP header/footer */
-	map_volume = Stream_GetU32_BE(data);
+	map1.volume = Stream_GetU32_BE(data);
 	MapState_SkipHeader(&map1);
 #ifdef EXTENDED_BLOCKS
+	map2.volume = map1.volume;
 	MapState_SkipHeader(&map2);
 #endif
 }
@@ -570,11 +739,6 @@ static void Classic_LevelDataChunk(cc_uint8* data) {
 	if (!map_begunLoading) Classic_StartLoading();
 	usedLength = Stream_GetU16_BE(data);
 
-	map_part.meta.mem.cur    = data + 2;
-	map_part.meta.mem.base   = data + 2;
-	map_part.meta.mem.left   = usedLength;
-	map_part.meta.mem.length = usedLength;
-
 #ifndef EXTENDED_BLOCKS
 	m = &map1;
 #else
@@ -586,31 +750,41 @@ static void Classic_LevelDataChunk(cc_uint8* data) {
 	}
 #endif
 
-	if (!m->gzHeader.done) {
-		res = GZipHeader_Read(&map_part, &m->gzHeader);
-		if (res && res != ERR_END_OF_STREAM) { DisconnectInvalidMap(res); return; }
-	}
-
-	if (m->gzHeader.done) {
-		res = MapState_Read(m);
-		if (res) { DisconnectInvalidMap(res); return; }
-	}
+	res = MapState_Queue(m, data + 2, min(usedLength, 1024));
+	if (res) { DisconnectInvalidMap(res); return; }
 
-	progress = !map_volume ? 0.0f : (float)map1.index / map_volume;
+	progress = !map1.volume ? 0.0f : (float)map1.index / map1.volume;
 	Event_RaiseFloat(&WorldEvents.Loading, progress);
 }
 
 static void Classic_LevelFinalise(cc_uint8* data) {
-	int width, height, length, volume;
+	int width, height, length, volume, mapVolume;
 	cc_uint64 end;
+	cc_result res;
 	int delta;
 
+	/* Wait for the rest of the map data to be decompressed */
+	MapState_Stop(&map1, false);
+#ifdef EXTENDED_BLOCKS
+	MapState_Stop(&map2, false);
+#endif
+
 	end   = Stopwatch_Measure();
 	delta = Stopwatch_ElapsedMS(map_receiveBeg, end);
 	Platform_Log1("map loading took: %i", &delta);
 	map_begunLoading = false;
 	WoM_CheckSendWomID();
 
+	res = MapState_GetResult(&map1);
+#ifdef EXTENDED_BLOCKS
+	if (!res) res = MapState_GetResult(&map2);
+#endif
+	if (res) { DisconnectInvalidMap(res); return; }
+
+	/* Dialog is shown here, as worker threads can't show it */
+	if (MapStates_AllocFailed()) {
+		Window_ShowDialog("Out of memory", "Not enough free memory to join that map.\nTry joining a different map.");
+	}
 #ifdef EXTENDED_BLOCKS
 	if (map2.allocFailed) FreeMapStates();
 #endif
@@ -619,6 +793,7 @@ static void Classic_LevelFinalise(cc_uint8* data) {
 	height = Stream_GetU16_BE(data + 2);
 	length = Stream_GetU16_BE(data + 4);
 	volume = width * height * length;
+	mapVolume = map1.volume;
 
 	if (map1.allocFailed) {
 		Chat_AddRaw("&cFailed to load map, try joining a different map");
@@ -626,9 +801,9 @@ static void Classic_LevelFinalise(cc_uint8* data) {
 	} else if (!map1.blocks) {
 		Chat_AddRaw("&cFailed to load map, try joining a different map");
 		Chat_AddRaw("   &cAttempted to load map without a Blocks array");
-	} else if (map_volume != volume) {
+	} else if (mapVolume != volume) {
 		Chat_AddRaw("&cFailed to load map, try joining a different map");
-		Chat_Add2(  "   &cBlocks array size (%i) does not match volume of map (%i)", &map_volume, &volume);
+		Chat_Add2(  "   &cBlocks array size (%i) does not match volume of map (%i)", &mapVolume, &volume);
 		FreeMapStates();
 	} else if (!World_CheckVolume(width, height, length)) {
 		Chat_AddRaw("&cFailed to load map, try joining a different map");
@@ -801,7 +976,6 @@ static void Classic_ReadAbsoluteLocation(cc_uint8* data, EntityID id, cc_uint8 f
 
 #define Classic_HandshakeSize() (Game_Version.Protocol > PROTOCOL_0019 ? 131 : 130)
 static void Classic_Reset(void) {
-	Stream_ReadonlyMemory(&map_part, NULL, 0);
 	map_begunLoading = false;
 	classic_receivedFirstPos = false;
 
@@ -1285,18 +1459,124 @@ static void CPE_ExtAddEntity2(cc_uint8* data) {
 }
 
 #define BULK_MAX_BLOCKS 256
+#define BULK_HASH_BITS  9
+#define BULK_HASH_SIZE  (1 << BULK_HASH_BITS)
+
+/* Divides by a fixed divisor using a multiply and shift, instead of a much slower division */
+/* NOTE: Only exact for dividends below 2^31 (which all block indices are) */
+struct FastDivisor { cc_uint64 mul; int shift; };
+
+static void FastDivisor_Init(struct FastDivisor* d, cc_uint32 divisor) {
+	int bits = 0;
+	while (bits < 32 && ((cc_uint64)1 << bits) < divisor) bits++;
+
+	/* mul = ceil(2^shift / divisor), which has an error small enough to be exact */
+	d->shift = 32 + bits;
+	d->mul   = (((cc_uint64)1 << d->shift) + divisor - 1) / divisor;
+}
+#define FastDivisor_Div(d, value) (int)(((cc_uint64)(value) * (d)->mul) >> (d)->shift)
+
+/* Applies the block updates grouped by chunk, so that each touched chunk is only */
+/*  marked for redrawing once, instead of once for every single block update */
+/* NOTE: Updates to the same block are still applied in their original order */
+static void CPE_ApplyBulkUpdate(const cc_int32* indices, const BlockID* blocks, int count) {
+	cc_uint16 xs[BULK_MAX_BLOCKS], ys[BULK_MAX_BLOCKS], zs[BULK_MAX_BLOCKS];
+	cc_int16 groupOf[BULK_MAX_BLOCKS];
+	cc_uint8 order[BULK_MAX_BLOCKS];
+	int groupChunk[BULK_MAX_BLOCKS];
+	int groupPos[BULK_MAX_BLOCKS];  /* Number of updates in each group, then where each group starts */
+	cc_int16 table[BULK_HASH_SIZE]; /* Group + 1 for each chunk, or 0 if empty slot */
+	struct FastDivisor divW, divWL;
+	int i, j, g, h, end, groups = 0, valid = 0;
+	int index, rem, x, y, z, chunk;
+	BlockID old, block, shown;
+	cc_bool changed;
+
+	if (!World.Volume) return;
+	FastDivisor_Init(&divW,  World.Width);
+	FastDivisor_Init(&divWL, World.OneY);
+	Mem_Set(table, 0, sizeof(table));
+
+	for (i = 0; i < count; i++)
+	{
+		index = indices[i];
+		groupOf[i] = -1;
+		if (index < 0 || index >= World.Volume) continue;
+
+		y   = FastDivisor_Div(&divWL, index);
+		rem = index - y * World.OneY;
+		z   = FastDivisor_Div(&divW, rem);
+		x   = rem - z * World.Width;
+		xs[i] = x; ys[i] = y; zs[i] = z;
+
+		chunk = World_ChunkPack(x >> CHUNK_SHIFT, y >> CHUNK_SHIFT, z >> CHUNK_SHIFT);
+		h     = ((cc_uint32)chunk * 2654435761U) >> (32 - BULK_HASH_BITS);
+
+		while (table[h] && groupChunk[table[h] - 1] != chunk) { h = (h + 1) & (BULK_HASH_SIZE - 1); }
+		if (!table[h]) {
+			groupChunk[groups] = chunk;
+			groupPos[groups]   = 0;
+			table[h] = ++groups;
+		}
+
+		groupOf[i] = table[h] - 1;
+		groupPos[groupOf[i]]++;
+		valid++;
+	}
+
+	/* Stable counting sort of the updates by group */
+	for (g = 1; g < groups; g++) { groupPos[g] += groupPos[g - 1]; }
+	for (i = count - 1; i >= 0; i--)
+	{
+		if (groupOf[i] >= 0) order[--groupPos[groupOf[i]]] = i;
+	}
+
+	for (g = 0; g < groups; g++)
+	{
+		end     = g + 1 < groups ? groupPos[g + 1] : valid;
+		changed = false;
+		shown   = BLOCK_AIR;
+
+		for (j = groupPos[g]; j < end; j++)
+		{
+			i = order[j];
+			x = xs[i]; y = ys[i]; z = zs[i];
+
+#ifdef EXTENDED_BLOCKS
+			block = blocks[i] % BLOCK_COUNT;
+#else
+			block = blocks[i];
+#endif
+			old = World_GetBlock(x, y, z);
+			if (old == block) continue;
+
+			/* Same as Game_UpdateBlock, except for redrawing the chunk */
+			World_SetBlock(x, y, z, block);
+			if (Weather_Heightmap) {
+				EnvRenderer_OnBlockChanged(x, y, z, old, block);
+			}
+			Lighting.OnBlockChanged(x, y, z, old, block);
+
+			/* Chunk is only completely air if all the changed blocks are air */
+			if (!changed || Blocks.Draw[block] != DRAW_GAS) shown = block;
+			changed = true;
+		}
+
+		if (changed) MapRenderer_OnBlockChanged(x, y, z, shown);
+	}
+}
+
 static void CPE_BulkBlockUpdate(cc_uint8* data) {
 	cc_int32 indices[BULK_MAX_BLOCKS];
 	BlockID blocks[BULK_MAX_BLOCKS];
-	int index, i;
-	int x, y, z;
+	int i;
 	int count = 1 + *data++;
 
 	for (i = 0; i < count; i++) {
 		indices[i] = Stream_GetU32_BE(data); data += 4;
 	}
 	data += (BULK_MAX_BLOCKS - count) * 4;
-	
+
 	for (i = 0; i < count; i++) {
 		blocks[i] = data[i];
 	}
@@ -1313,17 +1593,7 @@ static void CPE_BulkBlockUpdate(cc_uint8* data) {
 		data += BULK_MAX_BLOCKS / 4;
 	}
 
-	for (i = 0; i < count; i++) {
-		index = indices[i];
-		if (index < 0 || index >= World.Volume) continue;
-		World_Unpack(index, x, y, z);
-
-#ifdef EXTENDED_BLOCKS
-		Game_UpdateBlock(x, y, z, blocks[i] % BLOCK_COUNT);
-#else
-		Game_UpdateBlock(x, y, z, blocks[i]);
-#endif
-	}
+	CPE_ApplyBulkUpdate(indices, blocks, count);
 }
 
 static void CPE_SetTextColor(cc_uint8* data) {
@@ -1951,6 +2221,83 @@ static void BlockDefs_Reset(void) {
 }
 
 
+/*########################################################################################################################*
+*----------------------------------------------------Packet statistics----------------------------------------------------*
+*#########################################################################################################################*/
+struct ProtocolStats Protocol_Stats[256];
+
+static const char* const opcode_names[OPCODE_COUNT] = {
+	"Handshake", "Ping", "LevelInit", "LevelDataChunk", "LevelFinalize",
+	"SetBlockClient", "SetBlock", "SpawnPlayer", "PlayerTeleport",
+	"PosAndOriUpdate", "PosUpdate", "OriUpdate", "DespawnPlayer",
+	"Message", "DisconnectPlayer", "UpdateUserType",
+	/* CPE packets */
+	"ExtInfo", "ExtEntry", "SetClickDistance", "CustomBlockSupportLevel",
+	"HoldThis", "SetTextHotKey", "ExtAddPlayerName", "ExtAddEntity",
+	"ExtRemovePlayerName", "EnvSetColor", "MakeSelection", "RemoveSelection",
+	"SetBlockPermission", "ChangeModel", "EnvSetMapAppearance", "EnvSetWeatherType",
+	"HackControl", "ExtAddEntity2", "PlayerClicked", "DefineBlock",
+	"RemoveBlockDefinition", "DefineBlockExt", "BulkBlockUpdate", "SetTextColor",
+	"SetMapEnvUrl", "SetMapEnvProperty", "SetEntityProperty", "TwoWayPing",
+	"SetInventoryOrder", "SetHotbar", "SetSpawnpoint", "VelocityControl",
+	"DefineEffect", "SpawnEffect", "DefineModel", "DefineModelPart", "UndefineModel",
+	"PluginMessage", "EntityTeleportExt", "LightingMode", "CinematicGui",
+	"NotifyAction", "NotifyPositionAction", "ToggleBlockList"
+};
+
+const char* Protocol_GetOpcodeName(int opcode) {
+	return opcode >= 0 && opcode < OPCODE_COUNT ? opcode_names[opcode] : NULL;
+}
+
+void Protocol_ResetStats(void) {
+	Mem_Set(Protocol_Stats, 0, sizeof(Protocol_Stats));
+}
+
+cc_result Protocol_SaveStats(const cc_string* path) {
+	static const cc_string header = String_FromConst("opcode,name,packets,bytes,handler_us,avg_handler_us");
+	cc_string line; char lineBuffer[256];
+	struct ProtocolStats* s;
+	struct Stream stream;
+	cc_filepath raw_path;
+	const char* name;
+	cc_uint64 handlerUS;
+	cc_result res;
+	int i;
+
+	Platform_EncodePath(&raw_path, path);
+	res = Stream_CreatePath(&stream, &raw_path);
+	if (res) { Logger_IOWarn2(res, "creating", &raw_path); return res; }
+	res = Stream_WriteLine(&stream, (cc_string*)&header);
+
+	for (i = 0; i < 256 && !res; i++)
+	{
+		s = &Protocol_Stats[i];
+		if (!s->Packets) continue;
+
+		name      = Protocol_GetOpcodeName(i);
+		handlerUS = Stopwatch_ElapsedMicroseconds(0, s->HandlerTicks);
+
+		/* Totals can exceed 2^31 over a long session, so must not be formatted as int */
+		String_InitArray(line, lineBuffer);
+		String_Format2(&line, "%i,%c,", &i, name ? name : "Unknown");
+		String_AppendUInt32(&line, s->Packets);  String_Append(&line, ',');
+		String_AppendUInt64(&line, s->Bytes);    String_Append(&line, ',');
+		String_AppendUInt64(&line, handlerUS);   String_Append(&line, ',');
+		String_AppendUInt64(&line, handlerUS / s->Packets);
+		res = Stream_WriteLine(&stream, &line);
+	}
+
+	if (res) {
+		Logger_IOWarn2(res, "writing to", &raw_path);
+		stream.Close(&stream); return res;
+	}
+
+	res = stream.Close(&stream);
+	if (res) Logger_IOWarn2(res, "closing", &raw_path);
+	return res;
+}
+
+
 /*########################################################################################################################*
 *-----------------------------------------------------Public handlers-----------------------------------------------------*
 *#########################################################################################################################*/
@@ -1991,6 +2338,11 @@ void CPE_SendPlayerClick(int button, cc_bool pressed, cc_uint8 targetId, struct
 void CPE_SendNotifyAction(int action, cc_uint16 value) { }
 void CPE_SendNotifyPositionAction(int action, int x, int y, int z) { }
 
+struct ProtocolStats Protocol_Stats[256];
+const char* Protocol_GetOpcodeName(int opcode) { return NULL; }
+void Protocol_ResetStats(void) { }
+cc_result Protocol_SaveStats(const cc_string* path) { return ERR_NOT_SUPPORTED; }
+
 static void OnInit(void) { }
 
 static void OnReset(void) { }
@@ -70,6 +70,26 @@ struct RayTracer;
 struct IGameComponent;
 extern struct IGameComponent Protocol_Component;
 
+/* Statistics for all the received packets with a particular opcode */
+struct ProtocolStats {
+	/* Number of packets received */
+	cc_uint32 Packets;
+	/* Total size of the packets received, including opcode */
+	cc_uint64 Bytes;
+	/* Total time spent in the handler for the packets */
+	/* NOTE: This is in Stopwatch_Measure units, use Stopwatch_ElapsedMicroseconds(0, ticks) */
+	cc_uint64 HandlerTicks;
+};
+/* Statistics for each opcode, since the stats were last reset */
+/* NOTE: These are reset whenever connecting to a server */
+extern struct ProtocolStats Protocol_Stats[256];
+
+/* Returns the name of the packet for the given opcode, or NULL if unknown */
+const char* Protocol_GetOpcodeName(int opcode);
+void Protocol_ResetStats(void);
+/* Writes the statistics for each opcode that has been received to the given file as CSV */
+cc_result Protocol_SaveStats(const cc_string* path);
+
 void Protocol_Tick(void);
 
 extern cc_bool cpe_needD3Fix;
@@ -4,11 +4,14 @@
 #if CC_SSL_BACKEND == CC_SSL_BACKEND_BEARSSL
 #include "String.h"
 #include "Certs.h"
+#include "Funcs.h"
 #include "../third_party/bearssl/bearssl.h"
 #include "../misc/certs/certs.h"
 
 // https://github.com/unkaktus/bearssl/blob/master/samples/client_basic.c#L283
 #define SSL_ERROR_SHIFT 0xB5510000
+/* Hostnames are at most 253 characters long */
+#define SSL_MAX_HOST_LEN 256
 
 typedef struct SSLContext {
 	br_x509_minimal_context xc;
@@ -18,6 +21,9 @@ typedef struct SSLContext {
 	br_sslio_context ioc;
 	cc_result readError, writeError;
 	cc_socket socket;
+	cc_bool readEOF;
+	cc_bool sessionSaved;
+	char host[SSL_MAX_HOST_LEN];
 } SSLContext;
 static cc_bool _verifyCerts;
 
@@ -100,9 +106,155 @@ static const br_x509_class cert_verifier_vtable = {
 	x509_get_pkey
 };
 
+/*########################################################################################################################*
+*------------------------------------------------------Session cache------------------------------------------------------*
+*#########################################################################################################################*/
+/* Parameters of recent sessions are remembered per host, so that later connections to the same host */
+/*  can resume the session with an abbreviated handshake, instead of a full public key handshake */
+#ifdef CC_BUILD_LOWMEM
+	#define SSL_SESSION_CACHE_SIZE 2
+#else
+	#define SSL_SESSION_CACHE_SIZE 16
+#endif
+
+struct SSLSession {
+	char host[SSL_MAX_HOST_LEN];
+	br_ssl_session_parameters params;
+	cc_uint32 lastUsed; /* 0 if this entry is unused */
+};
+static struct SSLSession sessions[SSL_SESSION_CACHE_SIZE];
+static cc_uint32 sessions_counter;
+static void* sessionsMutex;
+
+static struct SSLSession* SSLSession_Find(const char* host_) {
+	cc_string host = String_FromReadonly(host_);
+	cc_string other;
+	int i;
+
+	for (i = 0; i < SSL_SESSION_CACHE_SIZE; i++)
+	{
+		if (!sessions[i].lastUsed) continue;
+		other = String_FromRawArray(sessions[i].host);
+		if (String_CaselessEquals(&other, &host)) return &sessions[i];
+	}
+	return NULL;
+}
+
+/* Sets the session parameters to try resuming for the host, if any */
+static cc_bool SSLSession_Restore(SSLContext* ctx) {
+	struct SSLSession* s;
+	cc_bool found = false;
+	if (!sessionsMutex) return false;
+
+	Mutex_Lock(sessionsMutex);
+	{
+		s = SSLSession_Find(ctx->host);
+		if (s) {
+			br_ssl_engine_set_session_parameters(&ctx->sc.eng, &s->params);
+			s->lastUsed = ++sessions_counter;
+			found = true;
+		}
+	}
+	Mutex_Unlock(sessionsMutex);
+	return found;
+}
+
+/* Remembers the session parameters of the completed handshake for the host */
+static void SSLSession_Save(SSLContext* ctx) {
+	struct SSLSession* s;
+	int i;
+	ctx->sessionSaved = true;
+	if (!sessionsMutex) return;
+	/* Server might not support session resumption */
+	if (!ctx->sc.eng.session.session_id_len) return;
+
+	Mutex_Lock(sessionsMutex);
+	{
+		s = SSLSession_Find(ctx->host);
+
+		/* Otherwise replace the least recently used (or an unused) entry */
+		if (!s) {
+			s = &sessions[0];
+			for (i = 1; i < SSL_SESSION_CACHE_SIZE; i++)
+			{
+				if (sessions[i].lastUsed < s->lastUsed) s = &sessions[i];
+			}
+		}
+
+		Mem_Copy(s->host, ctx->host, sizeof(s->host));
+		br_ssl_engine_get_session_parameters(&ctx->sc.eng, &s->params);
+		s->lastUsed = ++sessions_counter;
+	}
+	Mutex_Unlock(sessionsMutex);
+}
+
+/* Forgets the session parameters for the host, e.g. after an error */
+static void SSLSession_Remove(SSLContext* ctx) {
+	struct SSLSession* s;
+	if (!sessionsMutex) return;
+
+	Mutex_Lock(sessionsMutex);
+	{
+		s = SSLSession_Find(ctx->host);
+		if (s) Mem_Set(s, 0, sizeof(*s));
+	}
+	Mutex_Unlock(sessionsMutex);
+}
+
+
+/*########################################################################################################################*
+*------------------------------------------------------Cipher suites------------------------------------------------------*
+*#########################################################################################################################*/
+/* BearSSL prefers ChaCha20-Poly1305 by default, which is much faster than AES-GCM done in software. */
+/* However, AES-GCM is instead several times faster when the CPU has AES and carry-less multiply instructions */
+static const cc_uint16 aesgcm_suites[] = {
+	BR_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256,
+	BR_TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256,
+	BR_TLS_ECDHE_ECDSA_WITH_AES_256_GCM_SHA384,
+	BR_TLS_ECDHE_RSA_WITH_AES_256_GCM_SHA384
+};
+static cc_bool preferAESGCM;
+
+static void DetectHardwareAES(void) {
+	/* Same checks as br_ssl_engine_set_default_aes_gcm, which then uses the hardware accelerated implementation */
+	preferAESGCM = br_aes_x86ni_ctr_get_vtable() && br_ghash_pclmul_get();
+}
+
+static cc_bool IsAESGCMSuite(cc_uint16 suite) {
+	int i;
+	for (i = 0; i < Array_Elems(aesgcm_suites); i++)
+	{
+		if (aesgcm_suites[i] == suite) return true;
+	}
+	return false;
+}
+
+/* Moves the ECDHE AES-GCM cipher suites ahead of all the other supported cipher suites */
+static void PreferAESGCMSuites(SSLContext* ctx) {
+	br_ssl_engine_context* eng = &ctx->sc.eng;
+	uint16_t suites[BR_MAX_CIPHER_SUITES];
+	int i, count = 0;
+
+	for (i = 0; i < eng->suites_num; i++)
+	{
+		if (IsAESGCMSuite(eng->suites_buf[i])) suites[count++] = eng->suites_buf[i];
+	}
+	for (i = 0; i < eng->suites_num; i++)
+	{
+		if (!IsAESGCMSuite(eng->suites_buf[i])) suites[count++] = eng->suites_buf[i];
+	}
+	br_ssl_engine_set_suites(eng, suites, count);
+}
+
+
+/*########################################################################################################################*
+*-------------------------------------------------------SSL backend-------------------------------------------------------*
+*#########################################################################################################################*/
 void SSLBackend_Init(cc_bool verifyCerts) {
 	_verifyCerts = verifyCerts;
 	CertsBackend_Init();
+	DetectHardwareAES();
+	sessionsMutex = Mutex_Create("SSL sessions");
 }
 
 cc_bool SSLBackend_DescribeError(cc_result res, cc_string* dst) {
@@ -144,6 +296,8 @@ static int sock_read(void* ctx_, unsigned char* buf, size_t len) {
 	cc_result res = Socket_Read(ctx->socket, buf, len, &read);
 	
 	if (res) { ctx->readError = res; return -1; }
+	/* BearSSL would otherwise keep trying to read forever */
+	if (!read) { ctx->readEOF = true; return -1; }
 	return read;
 }
 
@@ -159,6 +313,7 @@ static int sock_write(void* ctx_, const unsigned char* buf, size_t len) {
 cc_result SSL_Init(cc_socket socket, const cc_string* host_, void** out_ctx) {
 	SSLContext* ctx;
 	char host[NATIVE_STR_LEN];
+	int resume;
 	String_EncodeUtf8(host, host_);
 	
 	ctx = (SSLContext*)Mem_TryAlloc(1, sizeof(SSLContext));
@@ -178,12 +333,18 @@ cc_result SSL_Init(cc_socket socket, const cc_string* host_, void** out_ctx) {
 #endif
 	
 	br_ssl_client_init_full(&ctx->sc, &ctx->xc, TAs, TAs_NUM);
+	if (preferAESGCM) PreferAESGCMSuites(ctx);
 	InjectEntropy(ctx);
 	SetCurrentTime(ctx);
 	ctx->socket = socket;
 
 	br_ssl_engine_set_buffer(&ctx->sc.eng, ctx->iobuf, sizeof(ctx->iobuf), 1);
-	br_ssl_client_reset(&ctx->sc, host, 0);
+	String_CopyToRawArray(ctx->host, host_);
+	ctx->sessionSaved = false;
+
+	/* Server falls back to a full handshake if it no longer recognises the session */
+	resume = SSLSession_Restore(ctx);
+	br_ssl_client_reset(&ctx->sc, host, resume);
 	ctx->xc.vtable = &cert_verifier_vtable;
 	
 	/* Account login must be done over TLS 1.2 */
@@ -197,6 +358,7 @@ cc_result SSL_Init(cc_socket socket, const cc_string* host_, void** out_ctx) {
 			
 	ctx->readError  = 0;
 	ctx->writeError = 0;
+	ctx->readEOF    = false;
 	
 	return 0;
 }
@@ -205,12 +367,15 @@ static CC_NOINLINE cc_result SSL_GetError(SSLContext* ctx) {
 	int err;
 	if (ctx->writeError) return ctx->writeError;
 	if (ctx->readError)  return ctx->readError;
+	if (ctx->readEOF)    return ReturnCode_SocketDropped;
 		
-	// TODO session resumption, proper connection closing ??
+	// TODO proper connection closing ??
 	err = br_ssl_engine_last_error(&ctx->sc.eng);
 	if (err == 0 && br_ssl_engine_current_state(&ctx->sc.eng) == BR_SSL_CLOSED)
 		return SSL_ERR_CONTEXT_DEAD;
-		
+
+	/* Don't keep trying to resume a session that might be the cause of the error */
+	SSLSession_Remove(ctx);
 	return SSL_ERROR_SHIFT | (err & 0xFFFF);
 }
 
@@ -218,6 +383,8 @@ cc_result SSL_Read(void* ctx_, cc_uint8* data, cc_uint32 count, cc_uint32* read)
 	SSLContext* ctx = (SSLContext*)ctx_;
 	// TODO: just br_sslio_write ??
 	int res = br_sslio_read(&ctx->ioc, data, count);
+	/* Report connection being closed without close_notify the same way as plain sockets do */
+	if (res < 0 && ctx->readEOF) { *read = 0; return 0; }
 	if (res < 0) return SSL_GetError(ctx);	
 	
 	br_sslio_flush(&ctx->ioc);
@@ -231,7 +398,9 @@ cc_result SSL_WriteAll(void* ctx_, const cc_uint8* data, cc_uint32 count) {
 	int res = br_sslio_write_all(&ctx->ioc, data, count);
 	if (res < 0) return SSL_GetError(ctx);	
 	
-	br_sslio_flush(&ctx->ioc);
+	/* Application data can only be sent once the handshake has been completed */
+	res = br_sslio_flush(&ctx->ioc);
+	if (res == 0 && !ctx->sessionSaved) SSLSession_Save(ctx);
 	return 0;
 }
 
@@ -25,6 +25,8 @@
 #include "Input.h"
 #include "Errors.h"
 #include "Options.h"
+#include "Stream.h"
+#include "Utils.h"
 
 static char nameBuffer[STRING_SIZE];
 static char motdBuffer[STRING_SIZE];
@@ -235,8 +237,6 @@ static cc_result net_writeFailure;
 static void OnClose(void);
 
 #ifdef CC_BUILD_NETWORKING
-static cc_uint8  net_readBuffer[4096 * 5];
-static cc_uint8* net_readCurrent;
 static double net_lastPacket;
 static cc_uint8 lastOpcode;
 
@@ -244,14 +244,266 @@ static cc_bool net_connecting;
 static float net_connectElapsed;
 #define NET_TIMEOUT_SECS 15
 
+static void NetRecv_Start(void);
+static void NetRecv_Stop(void);
+
+/* Packets are queued up and then sent together at the end of each network tick, */
+/*  instead of with a separate write call per packet */
+static cc_uint8* net_sendBuffer;
+static cc_uint32 net_sendLen, net_sendCap;
+static double net_lastSent;
+/* Queued data is sent immediately once this much is queued up */
+#define NET_SEND_FLUSH_SIZE (16 * 1024)
+/* How long sending can make no progress for before giving up */
+#define NET_SEND_TIMEOUT_SECS 10
+
+/* Writes as much of the queued data as the socket will currently accept */
+static void NetSend_Flush(void) {
+	cc_uint32 wrote, total = 0;
+	cc_result res = 0;
+	if (!net_sendLen || net_writeFailure) return;
+
+	while (total < net_sendLen) {
+		res = Socket_Write(net_socket, net_sendBuffer + total, net_sendLen - total, &wrote);
+		if (res || !wrote) break;
+		total += wrote;
+	}
+
+	if (total) {
+		net_sendLen -= total;
+		net_lastSent = Game.Time;
+		Mem_Move(net_sendBuffer, net_sendBuffer + total, net_sendLen);
+	}
+
+	/* If sending would block (send buffer full), retry again next tick, for up to 10 seconds */
+	if (res == ReturnCode_SocketInProgess || res == ReturnCode_SocketWouldBlock) {
+		if (net_lastSent + NET_SEND_TIMEOUT_SECS >= Game.Time) return;
+	} else if (!res && net_sendLen) {
+		res = ERR_INVALID_ARGUMENT;
+	}
+
+	/* NOTE: Not immediately disconnecting here, as otherwise we sometimes miss out on kick messages */
+	if (res) net_writeFailure = res;
+}
+
+static void NetSend_Reset(void) {
+	Mem_Free(net_sendBuffer);
+	net_sendBuffer = NULL;
+	net_sendLen    = 0;
+	net_sendCap    = 0;
+}
+
+/* Data is read from the socket into a ring buffer by a dedicated thread, so that reading isn't */
+/*  limited by the network tick rate. Whole packets are then drained from it on the main thread. */
+/* NOTE: On cooperatively threaded systems, the ring buffer is instead filled by the main thread */
+#if defined CC_BUILD_TINYMEM
+	#define NET_RING_SIZE (32 * 1024)
+#elif defined CC_BUILD_LOWMEM
+	#define NET_RING_SIZE (256 * 1024)
+#else
+	#define NET_RING_SIZE (2 * 1024 * 1024)
+#endif
+#define NET_RING_MASK (NET_RING_SIZE - 1)
+
+static cc_uint8 net_ring[NET_RING_SIZE];
+/* Total number of bytes ever written to/read from the ring buffer (wrap around is fine) */
+static cc_uint32 net_ringHead, net_ringTail, net_lastHead;
+/* Packets which wrap around the end of the ring buffer are copied here to make them contiguous */
+static cc_uint8  net_packetBuffer[4096 * 4];
+
+static void* net_recvMutex;
+static void* net_recvWaitable;
+static cc_result net_readFailure;
+static cc_bool net_readClosed;
+
+/* Reads as much data from the socket as fits in the contiguous free space of the ring buffer */
+/* Returns the number of bytes read, or 0 if no data was available or the ring buffer is full */
+static cc_uint32 NetRecv_Fill(void) {
+	cc_uint32 head, used, offset, count, read;
+	cc_result res;
+
+	Mutex_Lock(net_recvMutex);
+	{
+		head = net_ringHead;
+		used = net_ringHead - net_ringTail;
+	}
+	Mutex_Unlock(net_recvMutex);
+
+	offset = head & NET_RING_MASK;
+	count  = min(NET_RING_SIZE - used, NET_RING_SIZE - offset);
+	if (!count) return 0;
+
+	res = Socket_Read(net_socket, net_ring + offset, count, &read);
+	/* 'no data available for non-blocking read' is an expected error */
+	if (res == ReturnCode_SocketInProgess || res == ReturnCode_SocketWouldBlock) return 0;
+
+	Mutex_Lock(net_recvMutex);
+	{
+		if (res) {
+			net_readFailure = res;
+		} else if (read == 0) {
+			/* recv only returns 0 read when socket is closed.. probably? */
+			net_readClosed  = true;
+		} else {
+			net_ringHead   += read;
+		}
+	}
+	Mutex_Unlock(net_recvMutex);
+	return res ? 0 : read;
+}
+
+#ifdef CC_BUILD_COOPTHREADED
+static void NetRecv_Start(void) { }
+static void NetRecv_Stop(void)  { }
+#else
+static void* net_recvThread;
+static volatile cc_bool net_recvStopping;
+/* Longest time to block for while waiting for data, which also limits how long stopping takes */
+#define NET_RECV_WAIT_MS 50
+
+static void NetRecv_ThreadLoop(void) {
+	cc_bool failed, full, readable;
+	cc_result res;
+
+	while (!net_recvStopping)
+	{
+		Mutex_Lock(net_recvMutex);
+		{
+			failed = net_readFailure || net_readClosed;
+			full   = net_ringHead - net_ringTail == NET_RING_SIZE;
+		}
+		Mutex_Unlock(net_recvMutex);
+
+		if (failed) break;
+		/* Woken up early when space in the ring buffer is freed up, or when stopping */
+		if (full) { Waitable_WaitFor(net_recvWaitable, NET_RECV_WAIT_MS); continue; }
+
+		res = Socket_WaitReadable(net_socket, NET_RECV_WAIT_MS, &readable);
+		if (res) {
+			Mutex_Lock(net_recvMutex);
+			{
+				net_readFailure = res;
+			}
+			Mutex_Unlock(net_recvMutex);
+			break;
+		}
+		if (readable) NetRecv_Fill();
+	}
+}
+
+static void NetRecv_Start(void) {
+	net_recvStopping = false;
+	Thread_Run(&net_recvThread, NetRecv_ThreadLoop, 64 * 1024, "Network receive");
+}
+
+static void NetRecv_Stop(void) {
+	if (!net_recvThread) return;
+	net_recvStopping = true;
+	Waitable_Signal(net_recvWaitable);
+
+	Thread_Join(net_recvThread);
+	net_recvThread = NULL;
+}
+#endif
+
+static void NetRecv_Reset(void) {
+	net_ringHead    = 0;
+	net_ringTail    = 0;
+	net_lastHead    = 0;
+	net_readFailure = 0;
+	net_readClosed  = false;
+}
+
+/* Returns a pointer to the packet starting at the given offset in the ring buffer */
+static cc_uint8* NetRecv_GetPacket(cc_uint32 offset, cc_uint32 size) {
+	cc_uint32 part;
+	if (offset + size <= NET_RING_SIZE) return net_ring + offset;
+	if (size > sizeof(net_packetBuffer)) return NULL;
+
+	part = NET_RING_SIZE - offset;
+	Mem_Copy(net_packetBuffer,        net_ring + offset, part);
+	Mem_Copy(net_packetBuffer + part, net_ring,          size - part);
+	return net_packetBuffer;
+}
+
+/* Raw data received from the server can be recorded to a capture file, to be replayed later */
+/* Capture files start with "CCNETCAP", followed by records of: */
+/*  [time received in milliseconds since connecting (u32 BE)] [length (u32 BE)] [data] */
+static const cc_uint8 capture_magic[8] = { 'C','C','N','E','T','C','A','P' };
+static struct Stream net_capture;
+static cc_bool net_capturing;
+static double net_captureStart;
+
+static void NetCapture_Open(void) {
+	cc_string path; char pathBuffer[FILENAME_SIZE];
+	struct cc_datetime now;
+	cc_filepath raw_path;
+	cc_result res;
+
+	if (!Options_GetBool(OPT_NET_CAPTURE, false)) return;
+	if (!Utils_EnsureDirectory("captures")) return;
+	DateTime_CurrentLocal(&now);
+
+	String_InitArray(path, pathBuffer);
+	String_Format3(&path, "captures/capture_%p4-%p2-%p2", &now.year, &now.month, &now.day);
+	String_Format3(&path, "-%p2-%p2-%p2.cap", &now.hour, &now.minute, &now.second);
+
+	Platform_EncodePath(&raw_path, &path);
+	res = Stream_CreatePath(&net_capture, &raw_path);
+	if (res) { Logger_IOWarn2(res, "creating", &raw_path); return; }
+
+	res = Stream_Write(&net_capture, capture_magic, sizeof(capture_magic));
+	if (res) {
+		Logger_IOWarn2(res, "writing to", &raw_path); net_capture.Close(&net_capture); return;
+	}
+
+	net_capturing    = true;
+	net_captureStart = Game.Time;
+	Platform_Log1("Capturing network data to %s", &path);
+}
+
+static void NetCapture_Close(void) {
+	cc_result res;
+	if (!net_capturing) return;
+	net_capturing = false;
+
+	res = net_capture.Close(&net_capture);
+	if (res) Logger_SysWarn(res, "closing network capture");
+}
+
+/* Records the data between the given positions in the ring buffer */
+static void NetCapture_Write(cc_uint32 beg, cc_uint32 end) {
+	cc_uint32 offset = beg & NET_RING_MASK;
+	cc_uint32 len    = end - beg;
+	cc_uint32 part   = min(len, NET_RING_SIZE - offset);
+	cc_uint8 header[8];
+	cc_result res;
+
+	Stream_SetU32_BE(header + 0, (cc_uint32)((Game.Time - net_captureStart) * 1000));
+	Stream_SetU32_BE(header + 4, len);
+
+	if (!(res = Stream_Write(&net_capture, header, sizeof(header))) &&
+		!(res = Stream_Write(&net_capture, net_ring + offset, part))) {
+		  res = Stream_Write(&net_capture, net_ring, len - part);
+	}
+	if (!res) return;
+
+	Logger_SysWarn(res, "writing network capture");
+	NetCapture_Close();
+}
+
 static void MPConnection_FinishConnect(void) {
 	net_connecting = false;
 	Event_RaiseVoid(&NetEvents.Connected);
 	Event_RaiseFloat(&WorldEvents.Loading, 0.0f);
 
-	net_readCurrent = net_readBuffer;
+	NetRecv_Reset();
+	NetCapture_Open();
+	NetRecv_Start();
+	Protocol_ResetStats();
 	net_lastPacket  = Game.Time;
 	Classic_SendLogin();
+	NetSend_Flush();
 }
 
 static void MPConnection_Fail(const cc_string* reason) {
@@ -384,101 +636,129 @@ static void DisconnectInvalidOpcode(cc_uint8 opcode) {
 	Game_Disconnect(&title, &tmp); return;
 }
 
-static void MPConnection_Tick(struct ScheduledTask* task) {
+/* Processes all the whole packets currently in the ring buffer */
+/* Returns false if the connection was closed while processing packets */
+static cc_bool MPConnection_ProcessPackets(cc_uint32 head) {
+	cc_uint32 tail = net_ringTail;
+	struct ProtocolStats* stats;
 	Net_Handler handler;
-	cc_uint8* readEnd;
-	cc_uint8* readCur;
-	cc_uint32 read;
-	int i, remaining;
-	cc_result res;
+	cc_uint8* packet;
+	cc_uint8 opcode;
+	cc_uint32 size;
+	cc_uint64 beg;
+
+	/* Protocol packets might be split up across TCP packets */
+	/* If so, the last few unprocessed bytes are left in the ring buffer */
+	/* These bytes are then later combined with subsequently read TCP packet data */
+	while (tail != head) {
+		opcode = net_ring[tail & NET_RING_MASK];
+
+		/* Workaround for older D3 servers which wrote one byte too many for HackControl packets */
+		if (cpe_needD3Fix && lastOpcode == OPCODE_HACK_CONTROL && (opcode == 0x00 || opcode == 0xFF)) {
+			Platform_LogConst("Skipping invalid HackControl byte from D3 server");
+			tail++;
+			LocalPlayer_ResetJumpVelocity(Entities.CurPlayer);
+			continue;
+		}
 
-	if (Server.Disconnected) return;
-	if (net_connecting) { MPConnection_TickConnect(task); return; }
+		size = Protocol.Sizes[opcode];
+		if (size > head - tail) break;
+		handler = Protocol.Handlers[opcode];
+		packet  = NetRecv_GetPacket(tail & NET_RING_MASK, size);
+		if (!handler || !packet) { DisconnectInvalidOpcode(opcode); return false; }
 
-	/* NOTE: using a read call that is a multiple of 4096 (appears to?) improve read performance */	
-	res = Socket_Read(net_socket, net_readCurrent, 4096 * 4, &read);
-	
-	if (res) {
-		/* 'no data available for non-blocking read' is an expected error */
-		if (res == ReturnCode_SocketInProgess)  res = 0;
-		if (res == ReturnCode_SocketWouldBlock) res = 0;
+		lastOpcode = opcode;
+		beg = Stopwatch_Measure();
+		handler(packet + 1); /* skip opcode */
+		tail += size;
 
-		if (res) { DisconnectReadFailed(res); return; }
-	} else if (read == 0) {
-		/* recv only returns 0 read when socket is closed.. probably? */
-		/* Over 30 seconds since last packet, connection probably dropped */
-		/* TODO: Should this be checked unconditonally instead of just when read = 0 ? */
-		if (net_lastPacket + 30 < Game.Time) { MPConnection_Disconnect(); return; }
-	} else {
-		readCur        = net_readBuffer;
-		readEnd        = net_readCurrent + read;
-		net_lastPacket = Game.Time;
+		stats = &Protocol_Stats[opcode];
+		stats->Packets++;
+		stats->Bytes        += size;
+		stats->HandlerTicks += Stopwatch_Measure() - beg;
 
-		while (readCur < readEnd) {
-			cc_uint8 opcode = readCur[0];
+		/* Handler may have disconnected, which also resets the ring buffer */
+		if (Server.Disconnected) return false;
+	}
 
-			/* Workaround for older D3 servers which wrote one byte too many for HackControl packets */
-			if (cpe_needD3Fix && lastOpcode == OPCODE_HACK_CONTROL && (opcode == 0x00 || opcode == 0xFF)) {
-				Platform_LogConst("Skipping invalid HackControl byte from D3 server");
-				readCur++;
-				LocalPlayer_ResetJumpVelocity(Entities.CurPlayer);
-				continue;
-			}
+	Mutex_Lock(net_recvMutex);
+	{
+		net_ringTail = tail;
+	}
+	Mutex_Unlock(net_recvMutex);
+	return true;
+}
+
+static void MPConnection_Tick(struct ScheduledTask* task) {
+	cc_uint32 head;
+	cc_bool closed;
+	cc_result res;
 
-			if (readCur + Protocol.Sizes[opcode] > readEnd) break;
-			handler = Protocol.Handlers[opcode];
-			if (!handler) { DisconnectInvalidOpcode(opcode); return; }
+	if (Server.Disconnected) return;
+	if (net_connecting) { MPConnection_TickConnect(task); return; }
 
-			lastOpcode = opcode;
-			handler(readCur + 1); /* skip opcode */
-			readCur += Protocol.Sizes[opcode];
-		}
+#ifdef CC_BUILD_COOPTHREADED
+	while (NetRecv_Fill()) { }
+#endif
 
-		/* Protocol packets might be split up across TCP packets */
-		/* If so, copy last few unprocessed bytes back to beginning of buffer */
-		/* These bytes are then later combined with subsequently read TCP packet data */
-		remaining = (int)(readEnd - readCur);
-		for (i = 0; i < remaining; i++) 
-		{
-			net_readBuffer[i] = readCur[i];
-		}
-		net_readCurrent = net_readBuffer + remaining;
+	Mutex_Lock(net_recvMutex);
+	{
+		head   = net_ringHead;
+		res    = net_readFailure;
+		closed = net_readClosed;
 	}
+	Mutex_Unlock(net_recvMutex);
 
+	if (head != net_lastHead) {
+		if (net_capturing) NetCapture_Write(net_lastHead, head);
+		net_lastHead   = head;
+		net_lastPacket = Game.Time;
+
+		if (!MPConnection_ProcessPackets(head)) return;
+		/* Receive thread may be waiting for space in the ring buffer */
+		Waitable_Signal(net_recvWaitable);
+	} else if (res) {
+		DisconnectReadFailed(res); return;
+	} else if (closed) {
+		/* Over 30 seconds since last packet, connection probably dropped */
+		/* TODO: Should this be checked unconditonally instead of just when read = 0 ? */
+		if (net_lastPacket + 30 < Game.Time) { MPConnection_Disconnect(); return; }
+	}
 	if (net_writeFailure) {
 		Platform_Log1("Error from send: %e", &net_writeFailure);
 		MPConnection_Disconnect(); return;
 	}
 
 	/* Network is ticked 60 times a second. We only send position updates 20 times a second */
-	if ((ticks++ % 3) != 0) return;
-
-	TexturePack_CheckPending();
-	Protocol_Tick();
+	if ((ticks++ % 3) == 0) {
+		TexturePack_CheckPending();
+		Protocol_Tick();
+	}
+	NetSend_Flush();
 }
 
 static void MPConnection_SendData(const cc_uint8* data, cc_uint32 len) {
-	cc_uint32 wrote;
-	cc_result res;
-	int tries = 0;
-	if (Server.Disconnected) return;
+	cc_uint8* buffer;
+	cc_uint32 cap;
+	if (Server.Disconnected || net_writeFailure) return;
 
-	while (len) {
-		res = Socket_Write(net_socket, data, len, &wrote);
-		/* If sending would block (send buffer full), retry for a bit up to 10 seconds */
-		/* TODO: Avoid doing this and manually buffer data when this happens */
-		if (res && tries < 1000 && (res == ReturnCode_SocketInProgess || res == ReturnCode_SocketWouldBlock)) {
-			Thread_Sleep(10);
-			tries++;
-			continue;
-		}
+	if (net_sendLen + len > net_sendCap) {
+		cap    = max(net_sendCap * 2, net_sendLen + len);
+		cap    = max(cap, NET_SEND_FLUSH_SIZE);
+		buffer = (cc_uint8*)Mem_TryRealloc(net_sendBuffer, cap, 1);
 
 		/* NOTE: Not immediately disconnecting here, as otherwise we sometimes miss out on kick messages */
-		if (res)    { net_writeFailure = res;                  return; }
-		if (!wrote) { net_writeFailure = ERR_INVALID_ARGUMENT; return; }
-
-		data += wrote; len -= wrote;
+		if (!buffer) { net_writeFailure = ERR_OUT_OF_MEMORY; return; }
+		net_sendBuffer = buffer;
+		net_sendCap    = cap;
 	}
+
+	if (!net_sendLen) net_lastSent = Game.Time;
+	Mem_Copy(net_sendBuffer + net_sendLen, data, len);
+	net_sendLen += len;
+
+	/* Avoid queueing up too much data when lots of packets are sent within one tick */
+	if (net_sendLen >= NET_SEND_FLUSH_SIZE) NetSend_Flush();
 }
 
 static void MPConnection_Init(void) {
@@ -490,10 +770,203 @@ static void MPConnection_Init(void) {
 	Server.SendBlock    = MPConnection_SendBlock;
 	Server.SendChat     = MPConnection_SendChat;
 	Server.SendData     = MPConnection_SendData;
-	net_readCurrent     = net_readBuffer;
+
+	net_recvMutex    = Mutex_Create("Network receive");
+	net_recvWaitable = Waitable_Create("Network receive");
+}
+
+static void MPConnection_Close(void) {
+	NetRecv_Stop();
+	NetRecv_Reset();
+	NetSend_Reset();
+	NetCapture_Close();
+}
+
+static void MPConnection_Free(void) {
+	if (!net_recvMutex) return;
+	Mutex_Free(net_recvMutex);
+	Waitable_Free(net_recvWaitable);
+
+	net_recvMutex    = NULL;
+	net_recvWaitable = NULL;
 }
 #else
-static void MPConnection_Init(void) { SPConnection_Init(); }
+static void MPConnection_Init(void)  { SPConnection_Init(); }
+static void MPConnection_Close(void) { }
+static void MPConnection_Free(void)  { }
+#endif
+
+
+/*########################################################################################################################*
+*----------------------------------------------------Replay connection----------------------------------------------------*
+*#########################################################################################################################*/
+static char replayBuffer[FILENAME_SIZE];
+cc_string Replay_Path = String_FromArray(replayBuffer);
+
+#ifdef CC_BUILD_NETWORKING
+static struct Stream replay_file, replay_stream;
+static cc_uint8 replay_buffer[16 * 1024];
+static cc_bool replay_open, replay_fast, replay_finished;
+/* Whether the header of the next record has been read, but not all of its data yet */
+static cc_bool replay_pending;
+static cc_uint32 replay_time, replay_left, replay_records;
+static cc_uint64 replay_bytes;
+static double replay_start;
+
+static void ReplayConnection_Fail(cc_result res) {
+	static const cc_string title  = String_FromConst("Disconnected");
+	static const cc_string reason = String_FromConst("Failed to replay the network capture");
+
+	Logger_SysWarn2(res, "replaying", &Replay_Path);
+	Game_Disconnect(&title, &reason);
+}
+
+static void ReplayConnection_BeginConnect(void) {
+	cc_uint8 magic[sizeof(capture_magic)];
+	cc_result res;
+
+	res = Stream_OpenFile(&replay_file, &Replay_Path);
+	if (res) { ReplayConnection_Fail(res); return; }
+	replay_open = true;
+
+	Stream_ReadonlyBuffered(&replay_stream, &replay_file, replay_buffer, sizeof(replay_buffer));
+	res = Stream_Read(&replay_stream, magic, sizeof(magic));
+	if (!res && !Mem_Equal(magic, capture_magic, sizeof(magic))) res = ERR_INVALID_ARGUMENT;
+	if (res) { ReplayConnection_Fail(res); return; }
+
+	Event_RaiseVoid(&NetEvents.Connected);
+	Event_RaiseFloat(&WorldEvents.Loading, 0.0f);
+	NetRecv_Reset();
+	Protocol_ResetStats();
+
+	replay_pending  = false;
+	replay_finished = false;
+	replay_records  = 0;
+	replay_bytes    = 0;
+	replay_start    = Game.Time;
+	Classic_SendLogin();
+}
+
+/* Copies recorded data into the ring buffer, up to the given time since replaying started */
+/* NOTE: When replaying as fast as possible, copies as much as fits into the ring buffer */
+static void ReplayConnection_Fill(cc_uint32 elapsedMS) {
+	cc_uint32 used, offset, count;
+	cc_uint8 header[8];
+	cc_result res;
+
+	for (;;)
+	{
+		if (!replay_pending) {
+			res = Stream_Read(&replay_stream, header, sizeof(header));
+			if (res == ERR_END_OF_STREAM) { replay_finished = true; return; }
+			if (res) { ReplayConnection_Fail(res); return; }
+
+			replay_time    = Stream_GetU32_BE(header + 0);
+			replay_left    = Stream_GetU32_BE(header + 4);
+			replay_pending = true;
+		}
+		if (!replay_fast && replay_time > elapsedMS) return;
+
+		used   = net_ringHead - net_ringTail;
+		offset = net_ringHead & NET_RING_MASK;
+		count  = min(replay_left, min(NET_RING_SIZE - used, NET_RING_SIZE - offset));
+		if (!count && replay_left) return;
+
+		res = Stream_Read(&replay_stream, net_ring + offset, count);
+		if (res) { ReplayConnection_Fail(res); return; }
+
+		net_ringHead += count;
+		replay_bytes += count;
+		replay_left  -= count;
+		if (replay_left) continue;
+
+		replay_pending = false;
+		replay_records++;
+	}
+}
+
+static void ReplayConnection_Tick(struct ScheduledTask* task) {
+	cc_uint32 elapsedMS;
+	if (Server.Disconnected) return;
+
+	if (!replay_finished) {
+		elapsedMS = (cc_uint32)((Game.Time - replay_start) * 1000);
+		ReplayConnection_Fill(elapsedMS);
+		if (Server.Disconnected) return;
+
+		if (replay_finished && !replay_fast) Chat_AddRaw("&eFinished replaying network capture");
+	}
+
+	if (net_ringHead != net_lastHead) {
+		net_lastHead   = net_ringHead;
+		net_lastPacket = Game.Time;
+		if (!MPConnection_ProcessPackets(net_ringHead)) return;
+	}
+
+	if ((ticks++ % 3) == 0) {
+		TexturePack_CheckPending();
+		Protocol_Tick();
+	}
+}
+
+/* Replies to the server are just discarded */
+static void ReplayConnection_SendBlock(int x, int y, int z, BlockID old, BlockID now) { }
+static void ReplayConnection_SendChat(const cc_string* text) { }
+static void ReplayConnection_SendData(const cc_uint8* data, cc_uint32 len) { }
+
+static void ReplayConnection_Init(void) {
+	MPConnection_Init();
+
+	Server.BeginConnect = ReplayConnection_BeginConnect;
+	Server.Tick         = ReplayConnection_Tick;
+	Server.SendBlock    = ReplayConnection_SendBlock;
+	Server.SendChat     = ReplayConnection_SendChat;
+	Server.SendData     = ReplayConnection_SendData;
+}
+
+static void ReplayConnection_Close(void) {
+	NetRecv_Reset();
+	if (!replay_open) return;
+
+	replay_open = false;
+	/* No point logging error for closing readonly file */
+	(void)replay_file.Close(&replay_file);
+}
+
+int Replay_RunBenchmark(void) {
+	struct ScheduledTask task = { 0 };
+	cc_uint64 beg, end;
+	int records, sizeKB, elapsedMS;
+	float rate;
+
+	if (!Replay_Path.length || !replay_open) return 1;
+	task.interval = GAME_NET_TICKS;
+	replay_fast   = true;
+	beg = Stopwatch_Measure();
+
+	/* Rendering is skipped entirely, only the protocol handlers are run */
+	while (!Server.Disconnected && !replay_finished)
+	{
+		Game.Time += GAME_NET_TICKS;
+		Server.Tick(&task);
+	}
+	end = Stopwatch_Measure();
+
+	records   = (int)replay_records;
+	sizeKB    = (int)(replay_bytes / 1024);
+	elapsedMS = (int)(Stopwatch_ElapsedMicroseconds(beg, end) / 1000);
+	rate      = elapsedMS ? (float)(replay_bytes / 1000.0 / elapsedMS) : 0.0f;
+
+	Platform_Log4("Replayed %i records (%i KB) in %i ms, %f2 MB/s", &records, &sizeKB, &elapsedMS, &rate);
+	if (replay_finished) return 0;
+
+	Platform_LogConst("Disconnected before the end of the network capture");
+	return 1;
+}
+#else
+static void ReplayConnection_Init(void)  { SPConnection_Init(); }
+static void ReplayConnection_Close(void) { }
+int Replay_RunBenchmark(void) { return 1; }
 #endif
 
 
@@ -516,7 +989,9 @@ static void OnInit(void) {
 	String_InitArray(Server.MOTD,    motdBuffer);
 	String_InitArray(Server.AppName, appBuffer);
 
-	if (!Server.Address.length) {
+	if (Replay_Path.length) {
+		ReplayConnection_Init();
+	} else if (!Server.Address.length) {
 		SPConnection_Init();
 	} else {
 		MPConnection_Init();
@@ -542,6 +1017,7 @@ static void OnReset(void) {
 static void OnFree(void) {
 	Server.Address.length = 0;
 	OnClose();
+	MPConnection_Free();
 }
 
 static void OnClose(void) {
@@ -551,7 +1027,14 @@ static void OnClose(void) {
 		Ping_Reset();
 		if (Server.Disconnected) return;
 
-		Socket_Close(net_socket);
+		/* Receive thread must be stopped before the socket is closed */
+		MPConnection_Close();
+
+		if (Replay_Path.length) {
+			ReplayConnection_Close();
+		} else {
+			Socket_Close(net_socket);
+		}
 		Server.Disconnected = true;
 	}
 }
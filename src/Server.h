@@ -77,5 +77,13 @@ void Server_RetrieveTexturePack(const cc_string* url);
 /* Path of map to automatically load in singleplayer */
 extern cc_string SP_AutoloadMap;
 
+/* Path of network capture to replay, instead of connecting to a multiplayer server */
+/* NOTE: Network captures are recorded when the "net-capture" option is enabled */
+extern cc_string Replay_Path;
+/* Replays the network capture as fast as possible without rendering anything, then */
+/*  logs how long it took. Returns non-zero if the capture could not be fully replayed. */
+/* NOTE: The game must have already been setup, with Replay_Path set beforehand */
+int Replay_RunBenchmark(void);
+
 CC_END_HEADER
 #endif
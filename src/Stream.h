@@ -34,6 +34,7 @@ struct Stream {
 		cc_file file;
 		void* inflate;
 		struct { cc_uint8* cur; cc_uint32 left, length; cc_uint8* base; } mem;
+		struct { cc_uint8* cur; cc_uint32 left, length; cc_uint8* base; struct Bitmap* bmp; } png;
 		struct { struct Stream* source; cc_uint32 left, length; } portion;
 		struct { cc_uint8* cur; cc_uint32 left, length; cc_uint8* base; struct Stream* source; cc_uint32 end; } buffered;
 		struct { struct Stream* source; cc_uint32 crc32; } crc32;
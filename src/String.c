@@ -189,6 +189,18 @@ void String_AppendUInt32(cc_string* str, cc_uint32 num) {
 	}
 }
 
+void String_AppendUInt64(cc_string* str, cc_uint64 num) {
+	char digits[STRING_INT_CHARS];
+	int i, count = 0;
+	do {
+		digits[count] = '0' + (int)(num % 10); num /= 10; count++;
+	} while (num > 0);
+
+	for (i = count - 1; i >= 0; i--) {
+		String_Append(str, digits[i]);
+	}
+}
+
 void String_AppendPaddedInt(cc_string* str, int num, int minDigits) {
 	char digits[STRING_INT_CHARS];
 	int i, count;
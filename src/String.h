@@ -96,6 +96,8 @@ CC_API void String_AppendBool(cc_string* str, cc_bool value);
 CC_API void String_AppendInt(cc_string* str, int num);
 /* Attempts to append the digits of an unsigned 32 bit integer. */
 CC_API void String_AppendUInt32(cc_string* str, cc_uint32 num);
+/* Attempts to append the digits of an unsigned 64 bit integer. */
+CC_API void String_AppendUInt64(cc_string* str, cc_uint64 num);
 /* Attempts to append the digits of an integer, padding left with 0. */
 CC_API void String_AppendPaddedInt(cc_string* str, int num, int minDigits);
 
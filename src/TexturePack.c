@@ -16,6 +16,7 @@
 #include "Utils.h"
 #include "Chat.h" /* TODO avoid this include */
 #include "Errors.h"
+#include "Bitmap.h"
 
 /* Simple fallback terrain for when no texture packs are available at all */
 static BitmapCol fallback_terrain[16 * 8] = {
@@ -397,6 +398,12 @@ static cc_bool OpenCachedData(const cc_string* url, struct Stream* stream) {
 	return true;
 }
 
+/* Returns the path that the data for the given URL is downloaded into */
+static void GetDownloadPath(const cc_string* url, cc_string* path) {
+	cc_string altPath = String_Empty;
+	MakeCachePath(path, &altPath, url);
+}
+
 CC_NOINLINE static cc_string GetCachedTag(const cc_string* url, struct StringsBuffer* list) {
 	cc_string key; char keyBuffer[STRING_INT_CHARS];
 	String_InitArray(key, keyBuffer);
@@ -433,21 +440,27 @@ CC_NOINLINE static void SetCachedTag(const cc_string* url, struct StringsBuffer*
 	EntryList_Save(list, file);
 }
 
-/* Updates cached data, ETag, and Last-Modified for the given URL */
-static void UpdateCache(struct HttpRequest* req) {
-	cc_string url, altPath, value;
-	cc_string path; char pathBuffer[FILENAME_SIZE];
-	cc_result res;
+/* Updates ETag and Last-Modified for the given URL */
+static void UpdateCacheTags(struct HttpRequest* req) {
+	cc_string url, value;
 	url = String_FromRawArray(req->url);
 
 	value = String_FromRawArray(req->etag);
 	SetCachedTag(&url, &etagCache,    &value, ETAGS_TXT);
 	value = String_FromRawArray(req->lastModified);
 	SetCachedTag(&url, &lastModCache, &value, LASTMOD_TXT);
+}
+
+/* Updates cached data, ETag, and Last-Modified for the given URL */
+static void UpdateCache(struct HttpRequest* req) {
+	cc_string url;
+	cc_string path; char pathBuffer[FILENAME_SIZE];
+	cc_result res;
+	url = String_FromRawArray(req->url);
+	UpdateCacheTags(req);
 
 	String_InitArray(path, pathBuffer);
-	altPath = String_Empty;
-	MakeCachePath(&path, &altPath, &url);
+	GetDownloadPath(&url, &path);
 
 	res = Stream_WriteAllTo(&path, req->data, req->size);
 	if (res) { Logger_SysWarn2(res, "caching", &url); }
@@ -474,6 +487,11 @@ static cc_string GetCachedETag(const cc_string* url) {
 	return String_Empty;
 }
 
+static void GetDownloadPath(const cc_string* url, cc_string* path) { }
+
+/* Updates ETag and Last-Modified for the given URL */
+static void UpdateCacheTags(struct HttpRequest* req) { }
+
 /* Updates cached data, ETag, and Last-Modified for the given URL */
 static void UpdateCache(struct HttpRequest* req) { }
 #endif
@@ -528,6 +546,249 @@ static cc_result ProcessZipEntry(const cc_string* path, struct Stream* stream, s
 	return 0;
 }
 
+
+/*########################################################################################################################*
+*--------------------------------------------------Parallel zip decoding--------------------------------------------------*
+*#########################################################################################################################*/
+#if defined CC_BUILD_COOPTHREADED || defined CC_BUILD_LOWMEM || CC_BUILD_MAXSTACK <= (64 * 1024)
+static cc_bool ExtractZipParallel(struct Stream* stream, struct ZipEntry* entries, int maxEntries, cc_result* res) {
+	return false;
+}
+#else
+/* The zip walk buffers the data of each entry, while worker threads decode the .png entries. */
+/* The entries are then raised in their original order on the main thread, with each .png */
+/*  entry's stream handing its already decoded bitmap over to Png_Decode */
+#define ZIPDEC_WORKERS 4
+/* Maximum number of entries buffered in memory that have not been raised yet */
+#define ZIPDEC_MAX_BUFFERED (ZIPDEC_WORKERS * 2)
+/* The size in the zip header isn't trusted beyond this, since the buffer grows as needed anyways */
+#define ZIPDEC_MAX_SIZE_HINT (1024 * 1024)
+
+enum ZipDecState { ZIPDEC_PENDING, ZIPDEC_ACTIVE, ZIPDEC_DONE };
+struct ZipDecEntry {
+	cc_uint8* data;    /* Filename, followed by the contents of the entry */
+	cc_uint32 dataLen; /* Length of the contents of the entry */
+	int nameLen;
+	struct Bitmap bmp; /* Decoded bitmap, if the entry is a .png file */
+	cc_uint8 state;
+};
+
+static struct ZipDecoder {
+	struct ZipDecEntry* entries;
+	void* workers[ZIPDEC_WORKERS];
+	void* mutex;
+	void* workWaitable; /* Signalled when an entry is submitted */
+	void* doneWaitable; /* Signalled when an entry is decoded */
+	int count, nextPending, nextRaise;
+	cc_bool quit;
+} zipDec;
+
+/* Returns the oldest entry that is waiting to be decoded */
+static struct ZipDecEntry* ZipDecoder_NextEntry(void) {
+	for (; zipDec.nextPending < zipDec.count; zipDec.nextPending++)
+	{
+		struct ZipDecEntry* e = &zipDec.entries[zipDec.nextPending];
+		if (e->state == ZIPDEC_PENDING) return e;
+	}
+	return NULL;
+}
+
+static void ZipDecoder_Decode(struct ZipDecEntry* e) {
+	struct Stream stream;
+	cc_result res;
+
+	Stream_ReadonlyMemory(&stream, e->data + e->nameLen, e->dataLen);
+	res = Png_Decode(&e->bmp, &stream);
+	if (!res) return;
+
+	/* Main thread decodes it again, so the error is logged the same way as usual */
+	Mem_Free(e->bmp.scan0);
+	e->bmp.scan0 = NULL;
+}
+
+static void ZipDecoder_WorkerLoop(void) {
+	struct ZipDecEntry* e;
+	cc_bool quit, more;
+
+	for (;;) {
+		Mutex_Lock(zipDec.mutex);
+		{
+			e = ZipDecoder_NextEntry();
+			if (e) e->state = ZIPDEC_ACTIVE;
+			more = ZipDecoder_NextEntry() != NULL;
+			quit = zipDec.quit;
+		}
+		Mutex_Unlock(zipDec.mutex);
+		/* Wake up another worker, in case multiple entries were submitted */
+		if (more || (quit && !e)) Waitable_Signal(zipDec.workWaitable);
+
+		if (e) {
+			ZipDecoder_Decode(e);
+
+			Mutex_Lock(zipDec.mutex);
+			e->state = ZIPDEC_DONE;
+			Mutex_Unlock(zipDec.mutex);
+			Waitable_Signal(zipDec.doneWaitable);
+		} else if (quit) {
+			break;
+		} else {
+			Waitable_Wait(zipDec.workWaitable);
+		}
+	}
+}
+
+/* Reads all the data of the entry into memory, after its filename */
+static cc_result ZipDecoder_ReadEntry(struct ZipDecEntry* e, const cc_string* name, 
+									struct Stream* stream, cc_uint32 sizeHint) {
+	cc_uint32 len = name->length, cap, read;
+	cc_uint8* data;
+	cc_uint8* expanded;
+	cc_result res;
+
+	/* + 1 so reading the end of the data doesn't need to expand the buffer */
+	cap  = len + min(sizeHint, ZIPDEC_MAX_SIZE_HINT) + 1;
+	data = (cc_uint8*)Mem_TryAlloc(cap, 1);
+	if (!data) return ERR_OUT_OF_MEMORY;
+	Mem_Copy(data, name->buffer, len);
+
+	for (;;) {
+		if (len == cap) {
+			cap     *= 2;
+			expanded = (cc_uint8*)Mem_TryRealloc(data, cap, 1);
+			if (!expanded) { Mem_Free(data); return ERR_OUT_OF_MEMORY; }
+			data = expanded;
+		}
+
+		res = stream->Read(stream, data + len, cap - len, &read);
+		if (res) { Mem_Free(data); return res; }
+		if (!read) break;
+		len += read;
+	}
+
+	e->data    = data;
+	e->nameLen = name->length;
+	e->dataLen = len - name->length;
+	return 0;
+}
+
+static cc_bool ZipDecoder_IsDone(struct ZipDecEntry* e) {
+	cc_bool done;
+	Mutex_Lock(zipDec.mutex);
+	done = e->state == ZIPDEC_DONE;
+	Mutex_Unlock(zipDec.mutex);
+	return done;
+}
+
+static void ZipDecoder_RaiseEntry(struct ZipDecEntry* e) {
+	struct Stream stream;
+	cc_string name;
+
+	name = String_Init((char*)e->data, e->nameLen, e->nameLen);
+	if (e->bmp.scan0) {
+		Png_MakeDecodedStream(&stream, &e->bmp, e->data + e->nameLen, e->dataLen);
+	} else {
+		Stream_ReadonlyMemory(&stream, e->data + e->nameLen, e->dataLen);
+	}
+	Event_RaiseEntry(&TextureEvents.FileChanged, &stream, &name);
+
+	/* Bitmap is left over when none of the handlers decoded it */
+	Mem_Free(e->bmp.scan0);
+	Mem_Free(e->data);
+}
+
+/* Raises the entries that have been decoded so far, stopping at the first one that has not */
+/* While more than maxBuffered entries have not been raised, instead waits for it to be decoded */
+static void ZipDecoder_RaiseDecoded(int maxBuffered) {
+	struct ZipDecEntry* e;
+
+	while (zipDec.nextRaise < zipDec.count)
+	{
+		e = &zipDec.entries[zipDec.nextRaise];
+		if (!ZipDecoder_IsDone(e)) {
+			if (zipDec.count - zipDec.nextRaise <= maxBuffered) return;
+			Waitable_Wait(zipDec.doneWaitable);
+			continue;
+		}
+
+		ZipDecoder_RaiseEntry(e);
+		zipDec.nextRaise++;
+	}
+}
+
+static cc_result ZipDecoder_ProcessEntry(const cc_string* path, struct Stream* stream, struct ZipEntry* source) {
+	static const cc_string png = String_FromConst(".png");
+	struct ZipDecEntry* e = &zipDec.entries[zipDec.count];
+	cc_string name = *path;
+	cc_result res;
+
+	Utils_UNSAFE_GetFilename(&name);
+	/* Limit how much memory is used when decoding can't keep up with reading the zip */
+	ZipDecoder_RaiseDecoded(ZIPDEC_MAX_BUFFERED - 1);
+
+	res = ZipDecoder_ReadEntry(e, &name, stream, source->UncompressedSize);
+	if (res) return res;
+
+	/* Only .png entries need decoding, everything else is raised as is */
+	e->state = String_CaselessEnds(&name, &png) ? ZIPDEC_PENDING : ZIPDEC_DONE;
+	Mutex_Lock(zipDec.mutex);
+	{
+		zipDec.count++;
+	}
+	Mutex_Unlock(zipDec.mutex);
+
+	if (e->state == ZIPDEC_PENDING) Waitable_Signal(zipDec.workWaitable);
+	/* Raise already decoded entries straight away, so their data can be freed sooner */
+	ZipDecoder_RaiseDecoded(ZIPDEC_MAX_BUFFERED);
+	return 0;
+}
+
+static void ZipDecoder_Free(void) {
+	int i;
+	Mutex_Lock(zipDec.mutex);
+	zipDec.quit = true;
+	Mutex_Unlock(zipDec.mutex);
+	Waitable_Signal(zipDec.workWaitable);
+
+	for (i = 0; i < ZIPDEC_WORKERS; i++) {
+		if (zipDec.workers[i]) Thread_Join(zipDec.workers[i]);
+	}
+
+	Mem_Free(zipDec.entries);
+	Mutex_Free(zipDec.mutex);
+	Waitable_Free(zipDec.workWaitable);
+	Waitable_Free(zipDec.doneWaitable);
+	zipDec.mutex = NULL;
+}
+
+/* Returns false when threading is unavailable, in which case the entries must be extracted serially */
+static cc_bool ExtractZipParallel(struct Stream* stream, struct ZipEntry* entries, int maxEntries, cc_result* res) {
+	int i;
+
+	Mem_Set(&zipDec, 0, sizeof(zipDec));
+	zipDec.entries = (struct ZipDecEntry*)Mem_TryAllocCleared(maxEntries, sizeof(struct ZipDecEntry));
+	if (!zipDec.entries) return false;
+
+	zipDec.mutex        = Mutex_Create("Zip decode");
+	zipDec.workWaitable = Waitable_Create("Zip decode work");
+	zipDec.doneWaitable = Waitable_Create("Zip decode done");
+
+	for (i = 0; i < ZIPDEC_WORKERS; i++) {
+		Thread_Run(&zipDec.workers[i], ZipDecoder_WorkerLoop, 256 * 1024, "Zip decoder");
+		/* Threading might not be supported at all on this platform */
+		if (!zipDec.workers[i]) { ZipDecoder_Free(); return false; }
+	}
+
+	*res = Zip_Extract(stream, SelectZipEntry, ZipDecoder_ProcessEntry, entries, maxEntries);
+	/* Entries read before any error are still applied, same as when extracting serially */
+	ZipDecoder_RaiseDecoded(0);
+
+	ZipDecoder_Free();
+	return true;
+}
+#endif
+
+
+
 static cc_result ExtractPng(struct Stream* stream) {
 	struct Bitmap bmp;
 	cc_result res = Png_Decode(&bmp, stream);
@@ -567,8 +828,10 @@ static cc_result ExtractFrom(struct Stream* stream, const cc_string* path) {
 		res = Zip_Extract(stream, SelectZipEntry, ProcessZipEntry,
 							entries, 512);
 #else
-		res = Zip_Extract(stream, SelectZipEntry, ProcessZipEntry,
-							entries, Array_Elems(entries));
+		if (!ExtractZipParallel(stream, entries, Array_Elems(entries), &res)) {
+			res = Zip_Extract(stream, SelectZipEntry, ProcessZipEntry,
+								entries, Array_Elems(entries));
+		}
 #endif
 
 		if (res) Logger_SysWarn2(res, "extracting", path);
@@ -633,6 +896,7 @@ static cc_result ExtractUserTextures(void) {
 }
 
 static cc_bool usingDefault;
+
 cc_result TexturePack_ExtractCurrent(cc_bool forceReload) {
 	cc_string url = TexturePack_Url;
 	struct Stream stream;
@@ -659,16 +923,29 @@ cc_result TexturePack_ExtractCurrent(cc_bool forceReload) {
 
 /* Extracts and updates cache for the downloaded texture pack */
 static void ApplyDownloaded(struct HttpRequest* item) {
-	struct Stream mem;
+	struct Stream stream;
 	cc_string url;
-
 	url = String_FromRawArray(item->url);
+
+	/* Data was saved straight into the cache while downloading */
+	if (!item->data) {
+		UpdateCacheTags(item);
+		/* Took too long to download and is no longer active texture pack */
+		if (!String_Equals(&TexturePack_Url, &url)) return;
+		if (!OpenCachedData(&url, &stream)) return;
+
+		ExtractFrom(&stream, &url);
+		usingDefault = false;
+		(void)stream.Close(&stream);
+		return;
+	}
+
 	if (!Platform_ReadonlyFilesystem) UpdateCache(item);
 	/* Took too long to download and is no longer active texture pack */
 	if (!String_Equals(&TexturePack_Url, &url)) return;
 
-	Stream_ReadonlyMemory(&mem, item->data, item->size);
-	ExtractFrom(&mem, &url);
+	Stream_ReadonlyMemory(&stream, item->data, item->size);
+	ExtractFrom(&stream, &url);
 	usingDefault = false;
 }
 
@@ -696,6 +973,7 @@ void TexturePack_CheckPending(void) {
 
 /* Asynchronously downloads the given texture pack */
 static void DownloadAsync(const cc_string* url) {
+	cc_string path; char pathBuffer[FILENAME_SIZE];
 	cc_string etag = String_Empty;
 	cc_string time = String_Empty;
 
@@ -707,15 +985,25 @@ static void DownloadAsync(const cc_string* url) {
 	}
 
 	Http_TryCancel(TexturePack_ReqID);
-	TexturePack_ReqID = Http_AsyncGetDataEx(url, HTTP_FLAG_PRIORITY, &time, &etag, NULL);
+	String_InitArray(path, pathBuffer);
+	if (!Platform_ReadonlyFilesystem) GetDownloadPath(url, &path);
+
+	/* Save straight into the cache, instead of buffering the entire texture pack in memory */
+	if (path.length) {
+		TexturePack_ReqID = Http_AsyncGetDataToFile(url, HTTP_FLAG_PRIORITY, &time, &etag, &path);
+	} else {
+		TexturePack_ReqID = Http_AsyncGetDataEx(url, HTTP_FLAG_PRIORITY, &time, &etag, NULL);
+	}
 }
 
 void TexturePack_Extract(const cc_string* url) {
-	if (url->length) DownloadAsync(url);
+	/* Extract the cached texture pack before the download might replace it */
+	if (!String_Equals(url, &TexturePack_Url)) {
+		String_Copy(&TexturePack_Url, url);
+		TexturePack_ExtractCurrent(false);
+	}
 
-	if (String_Equals(url, &TexturePack_Url)) return;
-	String_Copy(&TexturePack_Url, url);
-	TexturePack_ExtractCurrent(false);
+	if (url->length) DownloadAsync(url);
 }
 
 static struct TextureEntry* entries_head;
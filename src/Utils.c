@@ -110,6 +110,46 @@ cc_uint32 Utils_CRC32(const cc_uint8* data, cc_uint32 length) {
 	return crc ^ 0xffffffffUL;
 }
 
+/* Multiplies a 32x32 matrix over GF(2) by a vector */
+static cc_uint32 CRC32_MatrixMul(const cc_uint32* mat, cc_uint32 vec) {
+	cc_uint32 sum = 0;
+	for (; vec; vec >>= 1, mat++) {
+		if (vec & 1) sum ^= *mat;
+	}
+	return sum;
+}
+
+static void CRC32_MatrixSquare(cc_uint32* square, const cc_uint32* mat) {
+	int i;
+	for (i = 0; i < 32; i++) { square[i] = CRC32_MatrixMul(mat, mat[i]); }
+}
+
+/* Based on crc32_combine from zlib */
+cc_uint32 Utils_CRC32Combine(cc_uint32 crc1, cc_uint32 crc2, cc_uint32 length2) {
+	cc_uint32 even[32], odd[32], row;
+	int i;
+	if (!length2) return crc1;
+
+	/* Operator for a single zero bit */
+	odd[0] = 0xEDB88320UL; row = 1;
+	for (i = 1; i < 32; i++, row <<= 1) { odd[i] = row; }
+
+	CRC32_MatrixSquare(even, odd); /* Operator for two zero bits */
+	CRC32_MatrixSquare(odd, even); /* Operator for four zero bits */
+
+	/* Apply length2 zero bytes to crc1 (first square puts operator for one zero byte in even) */
+	for (;;) {
+		CRC32_MatrixSquare(even, odd);
+		if (length2 & 1) crc1 = CRC32_MatrixMul(even, crc1);
+		if (!(length2 >>= 1)) break;
+
+		CRC32_MatrixSquare(odd, even);
+		if (length2 & 1) crc1 = CRC32_MatrixMul(odd, crc1);
+		if (!(length2 >>= 1)) break;
+	}
+	return crc1 ^ crc2;
+}
+
 const cc_uint32 Utils_Crc32Table[256] = {
 	0x00000000, 0x77073096, 0xEE0E612C, 0x990951BA, 0x076DC419, 0x706AF48F, 0xE963A535, 0x9E6495A3, 0x0EDB8832, 0x79DCB8A4, 0xE0D5E91E, 0x97D2D988, 0x09B64C2B, 0x7EB17CBD, 0xE7B82D07, 0x90BF1D91,
 	0x1DB71064, 0x6AB020F2, 0xF3B97148, 0x84BE41DE, 0x1ADAD47D, 0x6DDDE4EB, 0xF4D4B551, 0x83D385C7, 0x136C9856, 0x646BA8C0, 0xFD62F97A, 0x8A65C9EC, 0x14015C4F, 0x63066CD9, 0xFA0F3D63, 0x8D080DF5,
@@ -43,6 +43,9 @@ int Utils_AccumulateWheelDelta(float* accumulator, float delta);
 
 cc_uint8 Utils_CalcSkinType(const struct Bitmap* bmp);
 cc_uint32 Utils_CRC32(const cc_uint8* data, cc_uint32 length);
+/* Calculates CRC32 of the concatenation of two pieces of data, from the CRC32 of each piece */
+/* NOTE: length2 is the length of the second piece of data */
+cc_uint32 Utils_CRC32Combine(cc_uint32 crc1, cc_uint32 crc2, cc_uint32 length2);
 /* CRC32 lookup table, for faster CRC32 calculations. */
 /* NOTE: This cannot be just indexed by byte value - see Utils_CRC32 implementation. */
 extern const cc_uint32 Utils_Crc32Table[256];
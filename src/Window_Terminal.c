@@ -436,7 +436,9 @@ static void DoCreateWindow(int width, int height) {
 void Window_Create2D(int width, int height) { DoCreateWindow(width, height); }
 void Window_Create3D(int width, int height) { DoCreateWindow(width, height); }
 
-void Window_Destroy(void) { }
+void Window_Destroy(void) {
+	Window_Main.Exists = false;
+}
 
 void Window_SetTitle(const cc_string* title) {
 	// TODO
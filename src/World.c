@@ -10,9 +10,12 @@
 #include "Game.h"
 #include "TexturePack.h"
 #include "Window.h"
+#include "Utils.h"
 
 struct _WorldData World;
 static char nameBuffer[STRING_SIZE];
+static cc_uint8* dirtyChunks;
+static int dirtyCount;
 /*########################################################################################################################*
 *----------------------------------------------------------World----------------------------------------------------------*
 *#########################################################################################################################*/
@@ -37,6 +40,20 @@ static void GenerateNewUuid(void) {
 	World.Uuid[8] |= 0x80; /* variant 2*/
 }
 
+cc_bool World_HasUuid(void) {
+	int i;
+	for (i = 0; i < WORLD_UUID_LEN; i++) {
+		if (World.Uuid[i]) return true;
+	}
+	return false;
+}
+
+static void FreeDirtyChunks(void) {
+	Mem_Free(dirtyChunks);
+	dirtyChunks = NULL;
+	dirtyCount  = 0;
+}
+
 void World_Reset(void) {
 #ifdef EXTENDED_BLOCKS
 	if (World.Blocks != World.Blocks2) Mem_Free(World.Blocks2);
@@ -47,10 +64,13 @@ void World_Reset(void) {
 	World.Blocks = NULL;
 	String_InitArray(World.Name, nameBuffer);
 
+	FreeDirtyChunks();
+
 	World_SetDimensions(0, 0, 0);
 	World.Loaded   = false;
 	World.LastSave = -200;
 	World.Seed     = 0;
+	Mem_Set(World.Uuid, 0, WORLD_UUID_LEN);
 	Env_Reset();
 }
 
@@ -79,7 +99,10 @@ void World_SetNewMap(BlockRaw* blocks, int width, int height, int length) {
 	if (Env.EdgeHeight == -1)   { Env.EdgeHeight   = height / 2; }
 	if (Env.CloudsHeight == -1) { Env.CloudsHeight = height + 2; }
 
-	GenerateNewUuid();
+	/* Keep the UUID an importer read from the map file */
+	if (!World_HasUuid()) GenerateNewUuid();
+	/* Dimensions may have changed, so dirty chunks must be reallocated */
+	FreeDirtyChunks();
 	World.Loaded = true;
 	Event_RaiseVoid(&WorldEvents.MapLoaded);
 }
@@ -125,6 +148,7 @@ static CC_NOINLINE void LazyInitUpper(int i, BlockID block) {
 void World_SetBlock(int x, int y, int z, BlockID block) {
 	int i = World_Pack(x, y, z);
 	World.Blocks[i] = (BlockRaw)block;
+	World_MarkDirty(x, y, z);
 
 	/* defer allocation of second map array if possible */
 	if (World.Blocks == World.Blocks2) {
@@ -137,6 +161,7 @@ void World_SetBlock(int x, int y, int z, BlockID block) {
 #else
 void World_SetBlock(int x, int y, int z, BlockID block) {
 	World.Blocks[World_Pack(x, y, z)] = block; 
+	World_MarkDirty(x, y, z);
 }
 #endif
 
@@ -152,6 +177,98 @@ BlockID World_SafeGetBlock(int x, int y, int z) {
 }
 
 
+/*########################################################################################################################*
+*------------------------------------------------------Dirty chunks-------------------------------------------------------*
+*#########################################################################################################################*/
+void World_MarkDirty(int x, int y, int z) {
+	int i = World_ChunkPack(x >> CHUNK_SHIFT, y >> CHUNK_SHIFT, z >> CHUNK_SHIFT);
+	if (dirtyCount == World.ChunksCount) return;
+
+	if (!dirtyChunks) {
+		dirtyChunks = (cc_uint8*)Mem_TryAllocCleared((World.ChunksCount + 7) >> 3, 1);
+		/* Out of memory, so just treat every chunk as modified */
+		if (!dirtyChunks) { dirtyCount = World.ChunksCount; return; }
+	}
+
+	if (dirtyChunks[i >> 3] & (1 << (i & 7))) return;
+	dirtyChunks[i >> 3] |= 1 << (i & 7);
+	dirtyCount++;
+}
+
+cc_bool World_IsChunkDirty(int index) {
+	if (dirtyCount == World.ChunksCount) return true;
+	return dirtyChunks && (dirtyChunks[index >> 3] & (1 << (index & 7)));
+}
+
+int World_CountDirty(void) { return dirtyCount; }
+
+void World_ClearDirty(void) {
+	if (dirtyChunks) Mem_Set(dirtyChunks, 0, (World.ChunksCount + 7) >> 3);
+	dirtyCount = 0;
+}
+
+
+/*########################################################################################################################*
+*-------------------------------------------------------Flood fill--------------------------------------------------------*
+*#########################################################################################################################*/
+#if CC_BUILD_MAXSTACK <= (32 * 1024)
+	#define FILL_STACK_FAST 256
+#else
+	#define FILL_STACK_FAST 2048
+#endif
+
+#define FloodFill_Push(seed) \
+if (count == limit) Utils_Resize((void**)&stack, &limit, 4, FILL_STACK_FAST, FILL_STACK_FAST);\
+stack[count++] = seed;
+
+/* Pushes one seed for each run of 'match' blocks in the given row between x1 and x2 */
+#define FloodFill_ScanRow(row) \
+for (i = x1, inRun = false; i <= x2; i++) {\
+	if (blocks[(row) + i] != match) { inRun = false; continue; }\
+	if (!inRun) { FloodFill_Push((row) + i); }\
+	inRun = true;\
+}
+
+int World_FloodFill(BlockRaw* blocks, int index, BlockRaw match, BlockRaw block) {
+	int* stack;
+	int stack_default[FILL_STACK_FAST]; /* avoid allocating memory if possible */
+	int count = 0, limit = FILL_STACK_FAST, filled = 0;
+	int row, x, y, z, x1, x2, i;
+	cc_bool inRun;
+
+	/* Blocks are marked as visited by being replaced */
+	if (match == block) return 0;
+	stack = stack_default;
+	if (index < 0) return 0; /* y below map, don't bother starting */
+	stack[count++] = index;
+
+	while (count) {
+		index = stack[--count];
+		if (blocks[index] != match) continue;
+
+		/* Only need to calculate coordinates once per span, instead of once per block */
+		x   = index  % World.Width;
+		y   = index  / World.OneY;
+		z   = (index / World.Width) % World.Length;
+		row = index - x;
+
+		/* Find extent of this horizontal run of blocks, then fill it all */
+		for (x1 = x; x1 > 0          && blocks[row + x1 - 1] == match; x1--) { }
+		for (x2 = x; x2 < World.MaxX && blocks[row + x2 + 1] == match; x2++) { }
+
+		Mem_Set(blocks + row + x1, block, x2 - x1 + 1);
+		filled += x2 - x1 + 1;
+
+		if (z > 0)          { FloodFill_ScanRow(row - World.Width); }
+		if (z < World.MaxZ) { FloodFill_ScanRow(row + World.Width); }
+		if (y > 0)          { FloodFill_ScanRow(row - World.OneY);  }
+	}
+
+	if (limit > FILL_STACK_FAST) Mem_Free(stack);
+	return filled;
+}
+
+
 /*########################################################################################################################*
 *-------------------------------------------------------Environment-------------------------------------------------------*
 *#########################################################################################################################*/
@@ -69,10 +69,13 @@ void World_Reset(void);
 CC_API void World_NewMap(void);
 /* Sets blocks array/dimensions of the map and raises WorldEvents.MapLoaded event */
 /* May also sets some environment settings like border/clouds height, if they are -1 */
+/* NOTE: A new UUID is only generated if the world does not already have one */
 CC_API void World_SetNewMap(BlockRaw* blocks, int width, int height, int length);
 /* Sets the various dimension and max coordinate related variables. */
 /* NOTE: This is an internal API. Use World_SetNewMap instead. */
 CC_NOINLINE void World_SetDimensions(int width, int height, int length);
+/* Whether World.Uuid has been set (i.e. is not all zeroes) */
+cc_bool World_HasUuid(void);
 void World_OutOfMemory(void);
 
 #ifdef EXTENDED_BLOCKS
@@ -103,6 +106,21 @@ void World_SetBlock(int x, int y, int z, BlockID block);
 /* Otherwise returns the block at the given coordinates. */
 BlockID World_SafeGetBlock(int x, int y, int z);
 
+/* Marks the chunk containing the given coordinates as modified since the world was last saved. */
+/* NOTE: World_SetBlock automatically calls this. */
+void World_MarkDirty(int x, int y, int z);
+/* Whether the chunk at the given index (see World_ChunkPack) was modified since last save. */
+cc_bool World_IsChunkDirty(int index);
+/* Returns the number of chunks modified since last save. */
+int World_CountDirty(void);
+/* Marks all chunks as unmodified. (e.g. after the world has been saved) */
+void World_ClearDirty(void);
+
+/* Replaces all 'match' blocks connected to the given starting index with 'block'. */
+/* Like liquids, filling spreads horizontally and downwards, but never upwards. */
+/* blocks must use the current world dimensions. Returns number of blocks replaced. */
+int World_FloodFill(BlockRaw* blocks, int index, BlockRaw match, BlockRaw block);
+
 /* Whether the given coordinates lie inside the map. */
 static CC_INLINE cc_bool World_Contains(int x, int y, int z) {
 	return (unsigned)x < (unsigned)World.Width
@@ -144,6 +144,9 @@ static void Http_BufferExpanded(struct HttpRequest* req, cc_uint32 read) {
 /*########################################################################################################################*
 *---------------------------------------------------Common header code----------------------------------------------------*
 *#########################################################################################################################*/
+/* Cookie lists may be shared by requests that several worker threads are processing at once */
+static void* cookieMutex;
+
 static void Http_ParseCookie(struct HttpRequest* req, const cc_string* value) {
 	cc_string name, data;
 	int dataEnd;
@@ -153,7 +156,11 @@ static void Http_ParseCookie(struct HttpRequest* req, const cc_string* value) {
 	dataEnd = String_IndexOf(&data, ';');
 	if (dataEnd >= 0) data.length = dataEnd;
 
-	EntryList_Set(req->cookies, &name, &data, '=');
+	Mutex_Lock(cookieMutex);
+	{
+		EntryList_Set(req->cookies, &name, &data, '=');
+	}
+	Mutex_Unlock(cookieMutex);
 }
 
 static void Http_ParseContentLength(struct HttpRequest* req, const cc_string* value) {
@@ -212,26 +219,24 @@ static void Http_SetRequestHeaders(struct HttpRequest* req) {
 	}
 
 	if (req->data) Http_AddHeader(req, "Content-Type", &contentType);
-	if (!req->cookies || !req->cookies->count) return;
+	if (!req->cookies) return;
 
 	String_InitArray(cookies, cookiesBuffer);
-	for (i = 0; i < req->cookies->count; i++) {
-		if (i) String_AppendConst(&cookies, "; ");
-		str = StringsBuffer_UNSAFE_Get(req->cookies, i);
-		String_AppendString(&cookies, &str);
+	Mutex_Lock(cookieMutex);
+	{
+		for (i = 0; i < req->cookies->count; i++) {
+			if (i) String_AppendConst(&cookies, "; ");
+			str = StringsBuffer_UNSAFE_Get(req->cookies, i);
+			String_AppendString(&cookies, &str);
+		}
 	}
-	Http_AddHeader(req, "Cookie", &cookies);
+	Mutex_Unlock(cookieMutex);
+	if (cookies.length) Http_AddHeader(req, "Cookie", &cookies);
 }
 
-/* TODO: Rewrite to use a local variable instead */
-static cc_string* Http_GetUserAgent_UNSAFE(void) {
-	static char userAgentBuffer[STRING_SIZE];
-	static cc_string userAgent;
-
-	String_InitArray(userAgent, userAgentBuffer);
-	String_AppendConst(&userAgent, GAME_APP_NAME);
-	String_AppendConst(&userAgent, Platform_AppNameSuffix);
-	return &userAgent;
+static void Http_GetUserAgent(cc_string* userAgent) {
+	String_AppendConst(userAgent, GAME_APP_NAME);
+	String_AppendConst(userAgent, Platform_AppNameSuffix);
 }
 
 
@@ -241,11 +246,12 @@ static cc_string* Http_GetUserAgent_UNSAFE(void) {
 static void* processedMutex;
 static struct RequestList processedReqs;
 static int nextReqID;
-static void HttpBackend_Add(struct HttpRequest* req, cc_uint8 flags);
+static void HttpBackend_Add(struct HttpRequest* req, cc_uint8 flags, const cc_string* savePath);
 
 /* Adds a req to the list of pending requests, waking up worker thread if needed. */
 static int Http_Add(const cc_string* url, cc_uint8 flags, cc_uint8 type, const cc_string* lastModified,
-					const cc_string* etag, const void* data, cc_uint32 size, struct StringsBuffer* cookies) {
+					const cc_string* etag, const void* data, cc_uint32 size, struct StringsBuffer* cookies,
+					const cc_string* savePath) {
 	static const cc_string https = String_FromConst("https://");
 	static const cc_string http  = String_FromConst("http://");
 	struct HttpRequest req = { 0 };
@@ -273,7 +279,6 @@ static int Http_Add(const cc_string* url, cc_uint8 flags, cc_uint8 type, const c
 	if (etag) { 
 		String_CopyToRawArray(req.etag, etag);
 	}
-
 	if (data) {
 		req.data = (cc_uint8*)Mem_Alloc(size, 1, "Http_PostData");
 		Mem_Copy(req.data, data, size);
@@ -282,14 +287,15 @@ static int Http_Add(const cc_string* url, cc_uint8 flags, cc_uint8 type, const c
 	req.cookies  = cookies;
 	req.progress = HTTP_PROGRESS_NOT_WORKING_ON;
 
-	HttpBackend_Add(&req, flags);
+	HttpBackend_Add(&req, flags, savePath);
 	return req.id;
 }
 
 
 /* Updates state after a completed http request */
 static void Http_FinishRequest(struct HttpRequest* req) {
-	req->success = !req->result && req->statusCode == 200 && req->data && req->size;
+	/* Content saved to a file leaves data as NULL, so only the size can be checked */
+	req->success = !req->result && req->statusCode == 200 && req->size;
 
 	if (!req->success) {
 		char* error = req->error; req->error = NULL;
@@ -332,6 +338,9 @@ static void Http_CleanCacheTask(struct ScheduledTask* task) {
 *----------------------------------------------------Http public api------------------------------------------------------*
 *#########################################################################################################################*/
 int Http_AsyncGetSkin(const cc_string* skinName, cc_uint8 flags) {
+	return Http_AsyncGetSkinEx(skinName, flags, NULL);
+}
+int Http_AsyncGetSkinEx(const cc_string* skinName, cc_uint8 flags, const cc_string* etag) {
 	cc_string url; char urlBuffer[URL_MAX_SIZE];
 	String_InitArray(url, urlBuffer);
 
@@ -340,20 +349,23 @@ int Http_AsyncGetSkin(const cc_string* skinName, cc_uint8 flags) {
 	} else {
 		String_Format2(&url, "%s/%s.png", &skinServer, skinName);
 	}
-	return Http_AsyncGetData(&url, flags);
+	return Http_Add(&url, flags, REQUEST_TYPE_GET, NULL, etag, NULL, 0, NULL, NULL);
 }
 
 int Http_AsyncGetData(const cc_string* url, cc_uint8 flags) {
-	return Http_Add(url, flags, REQUEST_TYPE_GET, NULL, NULL, NULL, 0, NULL);
+	return Http_Add(url, flags, REQUEST_TYPE_GET, NULL, NULL, NULL, 0, NULL, NULL);
 }
 int Http_AsyncGetHeaders(const cc_string* url, cc_uint8 flags) {
-	return Http_Add(url, flags, REQUEST_TYPE_HEAD, NULL, NULL, NULL, 0, NULL);
+	return Http_Add(url, flags, REQUEST_TYPE_HEAD, NULL, NULL, NULL, 0, NULL, NULL);
 }
 int Http_AsyncPostData(const cc_string* url, cc_uint8 flags, const void* data, cc_uint32 size, struct StringsBuffer* cookies) {
-	return Http_Add(url, flags, REQUEST_TYPE_POST, NULL, NULL, data, size, cookies);
+	return Http_Add(url, flags, REQUEST_TYPE_POST, NULL, NULL, data, size, cookies, NULL);
 }
 int Http_AsyncGetDataEx(const cc_string* url, cc_uint8 flags, const cc_string* lastModified, const cc_string* etag, struct StringsBuffer* cookies) {
-	return Http_Add(url, flags, REQUEST_TYPE_GET, lastModified, etag, NULL, 0, cookies);
+	return Http_Add(url, flags, REQUEST_TYPE_GET, lastModified, etag, NULL, 0, cookies, NULL);
+}
+int Http_AsyncGetDataToFile(const cc_string* url, cc_uint8 flags, const cc_string* lastModified, const cc_string* etag, const cc_string* path) {
+	return Http_Add(url, flags, REQUEST_TYPE_GET, lastModified, etag, NULL, 0, NULL, path);
 }
 
 static cc_bool Http_UrlDirect(cc_uint8 c) {
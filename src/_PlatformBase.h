@@ -220,6 +220,52 @@ int Stopwatch_ElapsedMS(cc_uint64 beg, cc_uint64 end) {
 	return (int)raw / 1000;
 }
 
+#ifndef OVERRIDE_PEAK_MEMORY
+cc_uint64 Process_GetPeakMemory(void) { return 0; }
+void Process_ResetPeakMemory(void) { }
+#endif
+
+#ifndef OVERRIDE_FILE_RENAME
+static cc_result File_CopyContents(cc_file src, cc_file dst) {
+	cc_uint8 buffer[4096];
+	cc_uint32 read, wrote, offset;
+	cc_result res;
+
+	for (;;)
+	{
+		if ((res = File_Read(src, buffer, sizeof(buffer), &read))) return res;
+		if (!read) return 0;
+
+		for (offset = 0; offset < read; offset += wrote)
+		{
+			if ((res = File_Write(dst, buffer + offset, read - offset, &wrote))) return res;
+			if (!wrote) return ERR_END_OF_STREAM;
+		}
+	}
+}
+
+cc_result File_Rename(const cc_filepath* src, const cc_filepath* dst) {
+	cc_file srcFile, dstFile;
+	cc_result res, closeRes;
+
+	if ((res = File_Open(&srcFile, src))) return res;
+	if ((res = File_Create(&dstFile, dst))) { File_Close(srcFile); return res; }
+
+	res = File_CopyContents(srcFile, dstFile);
+	closeRes = File_Close(dstFile);
+	if (!res) res = closeRes;
+
+	File_Close(srcFile);
+	return res ? res : File_Delete(src);
+}
+
+cc_result File_Delete(const cc_filepath* path) {
+	cc_file file;
+	cc_result res = File_Create(&file, path);
+	return res ? res : File_Close(file);
+}
+#endif
+
 static CC_INLINE void SocketAddr_Set(cc_sockaddr* addr, const void* src, unsigned srcLen) {
 	if (srcLen > CC_SOCKETADDR_MAXSIZE) Process_Abort("Attempted to copy too large socket");
 
@@ -423,6 +469,14 @@ cc_result Socket_ParseAddress(const cc_string* address, int port, cc_sockaddr* a
 	*numValidAddrs = 0;
 	return ParseHost(str, port, addrs, numValidAddrs);
 }
+
+#ifndef OVERRIDE_SOCKET_WAIT
+cc_result Socket_WaitReadable(cc_socket s, int milliseconds, cc_bool* readable) {
+	cc_result res = Socket_CheckReadable(s, readable);
+	if (!res && !*readable) Thread_Sleep(1);
+	return res;
+}
+#endif
 #endif
 
 
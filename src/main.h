@@ -8,6 +8,10 @@ CC_BEGIN_HEADER
 
 #define DEFAULT_SINGLEPLAYER_ARG "--singleplayer"
 #define DEFAULT_RESUME_ARG       "--resume"
+#define DEFAULT_GENBENCH_ARG     "--genbench"
+#define DEFAULT_MAPBENCH_ARG     "--mapbench"
+#define DEFAULT_REPLAY_ARG       "--replay"
+#define DEFAULT_REPLAYBENCH_ARG  "--replaybench"
 
 struct ResumeInfo {
 	cc_string user, ip, port, server, mppass;
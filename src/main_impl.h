@@ -18,6 +18,8 @@ Eg. the webclient 'main' function loads IndexedDB, and when that has asynchronou
 #include "Launcher.h"
 #include "Server.h"
 #include "Options.h"
+#include "Generator.h"
+#include "Formats.h"
 #include "main.h"
 
 /*########################################################################################################################*
@@ -83,6 +85,16 @@ static void RunGame(void) {
 	Window_Destroy();
 }
 
+static int RunReplayBenchmark(void) {
+	int res;
+	Game_Setup();
+	res = Replay_RunBenchmark();
+
+	Game_Free();
+	Window_Destroy();
+	return res;
+}
+
 static void RunLauncher(void) {
 #ifndef CC_BUILD_WEB
 	Launcher_Setup();
@@ -163,6 +175,12 @@ static int ParseMPArgs(const cc_string* user, const cc_string* mppass, const cc_
 #define ARG_RESULT_RUN_LAUNCHER 1
 #define ARG_RESULT_RUN_GAME     2
 #define ARG_RESULT_INVALID_ARGS 3
+#define ARG_RESULT_RUN_GENBENCH 4
+#define ARG_RESULT_RUN_MAPBENCH 5
+#define ARG_RESULT_RUN_REPLAYBENCH 6
+
+static char mapbenchBuffer[FILENAME_SIZE];
+static cc_string mapbenchDir = String_FromArray(mapbenchBuffer);
 
 static int ProcessProgramArgs(int argc, char** argv) {
 cc_string args[GAME_MAX_CMDARGS];
@@ -206,6 +224,31 @@ cc_string args[GAME_MAX_CMDARGS];
 		return ARG_RESULT_RUN_GAME;
 	}
 
+	/* --genbench - benchmark and verify the map generators, then exit */
+	if (argsCount == 1 && String_CaselessEqualsConst(&args[0], DEFAULT_GENBENCH_ARG)) {
+		return ARG_RESULT_RUN_GENBENCH;
+	}
+
+	/* --mapbench [directory] - benchmark importing every map in the directory, then exit */
+	if (argsCount == 2 && String_CaselessEqualsConst(&args[0], DEFAULT_MAPBENCH_ARG)) {
+		String_Copy(&mapbenchDir, &args[1]);
+		return ARG_RESULT_RUN_MAPBENCH;
+	}
+
+	/* --replay [file] - replay a network capture at its recorded speed */
+	if (argsCount == 2 && String_CaselessEqualsConst(&args[0], DEFAULT_REPLAY_ARG)) {
+		Options_Get(LOPT_USERNAME, &Game_Username, DEFAULT_USERNAME);
+		String_Copy(&Replay_Path, &args[1]);
+		return ARG_RESULT_RUN_GAME;
+	}
+
+	/* --replaybench [file] - replay a network capture as fast as possible, then exit */
+	if (argsCount == 2 && String_CaselessEqualsConst(&args[0], DEFAULT_REPLAYBENCH_ARG)) {
+		Options_Get(LOPT_USERNAME, &Game_Username, DEFAULT_USERNAME);
+		String_Copy(&Replay_Path, &args[1]);
+		return ARG_RESULT_RUN_REPLAYBENCH;
+	}
+
 	/* [file path] - run singleplayer with auto loaded map */
 	if (argsCount == 1 && IsOpenableFile(&args[0])) {
 		Options_Get(LOPT_USERNAME, &Game_Username, DEFAULT_USERNAME);
@@ -250,6 +293,12 @@ static int RunProgram(int argc, char** argv) {
 	case ARG_RESULT_RUN_GAME:
 		RunGame();
 		return 0;
+	case ARG_RESULT_RUN_GENBENCH:
+		return Gen_RunBenchmark() ? 1 : 0;
+	case ARG_RESULT_RUN_MAPBENCH:
+		return Map_RunBenchmark(&mapbenchDir) ? 1 : 0;
+	case ARG_RESULT_RUN_REPLAYBENCH:
+		return RunReplayBenchmark();
 	default:
 		return 1;
 	}